@@ -19,6 +19,9 @@ export const connectGatewayNanomsg = (gatewayName) => {
     const ipcPath = path.join(ipcDir, 'pub.ipc')
     const addr = `ipc://${ipcPath}`
     sub.connect(addr);
+    //只收json编码的推送，gateway同时推送二进制编码时不受影响
+    sub.chan(['{']);
+    sub.rmchan('');
     return sub
 }
 
@@ -57,6 +60,9 @@ export const connectStrategyNanomsg = (strategyId) => {
     const ipcPath = path.join(ipcDir, 'pub.ipc')
     const addr = `ipc://${ipcPath}`
     sub.connect(addr);
+    //只收json编码的推送，策略同时推送二进制编码时不受影响
+    sub.chan(['{']);
+    sub.rmchan('');
     return sub
 }
 
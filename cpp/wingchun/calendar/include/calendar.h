@@ -19,6 +19,7 @@
 #include <thread>
 #include <chrono>
 #include <map>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 namespace kungfu
@@ -98,6 +99,26 @@ namespace kungfu
         void loop();
         void get_current_via_req();
 
+        //交易时段表, 每个交易所按时段(上午/下午/夜盘)存放各交易日开收盘纳秒时间戳, 与trading_days对齐,
+        //启动时由节假日库一次生成, 查询只做二分查找
+        struct SessionTable
+        {
+            std::vector<int> trading_days;      //交易日 %Y%m%d, 升序
+            std::vector<long> open[3];          //下标MORNING/AFTERNOON/EVENING, 无夜盘则EVENING为空
+            std::vector<long> close[3];
+            long begin_nano;                    //第一个交易日开盘
+            long end_nano;                      //最后一个交易日收盘
+        };
+        void build_session_tables();
+        //nano不在表范围内时返回nullptr
+        const SessionTable* get_session_table(long nano, const std::string& exchange_id) const;
+
+        //表范围之外逐个交易日计算, 需要calendar service
+        bool is_open_by_day(long nano, const std::string& exchange_id);
+        long next_open_by_day(long nano, const std::string& exchange_id, int slot);
+        long next_close_by_day(long nano, const std::string& exchange_id, int slot);
+        std::vector<TradingSession> get_trading_sessions_by_day(long start_nano, long end_nano, const std::string& exchange_id);
+
     protected:
         std::map<std::string, std::vector<std::vector<std::string>>> trading_times {
             {"CZCE", {{"9:00:00", "13:30:00", "21:00:00"}, {"11:30:00", "15:00:00", "23:30:00"}}},
@@ -122,6 +143,7 @@ namespace kungfu
         std::atomic<bool>               started_;
         std::atomic<int>                current_;
         std::vector<SwitchDayCallback>  cbs_;
+        std::map<std::string, SessionTable> session_tables_;
     };
     typedef std::shared_ptr<Calendar> CalendarPtr;
 }
@@ -3,7 +3,9 @@
 //
 
 #include "calendar/include/calendar.h"
+#include "calendar_storage.hpp"
 #include "spdlog/spdlog.h"
+#include <algorithm>
 
 namespace kungfu
 {
@@ -20,6 +22,8 @@ namespace kungfu
         nn_setsockopt(sub_socket_, NN_SOL_SOCKET, NN_RCVTIMEO, &timeout, sizeof(int));
         nn_connect(sub_socket_, sub_url.c_str());
 
+        build_session_tables();
+
         started_ = true;
         thread_ = std::make_shared<std::thread>(&Calendar::loop, this);
     }
@@ -34,7 +38,174 @@ namespace kungfu
         }
     }
 
+    void Calendar::build_session_tables()
+    {
+        std::vector<int> trading_days;
+        try
+        {
+            // a missing or empty holiday db would make every weekday a trading day
+            CalendarStorage storage(fmt::format(CALENDAR_HOLIDAY_DB_FILE_FORMAT, get_base_dir()), true);
+            // weekdays are counted from 1990
+            if (!storage.get_trading_days(1990, CALENDAR_SESSION_TO_YEAR, trading_days, REGION_CN))
+            {
+                SPDLOG_ERROR("[Calendar] no holidays loaded, sessions computed per call");
+                return;
+            }
+        }
+        catch (std::exception& e)
+        {
+            SPDLOG_ERROR("[Calendar] failed to load trading days, sessions computed per call, exception: {}", e.what());
+            return;
+        }
+        trading_days.erase(trading_days.begin(), std::lower_bound(trading_days.begin(), trading_days.end(), CALENDAR_SESSION_FROM_YEAR * 10000));
+        if (trading_days.empty())
+        {
+            return;
+        }
+
+        // session time as offset to 00:00 of the trading day, same as get_nano_from_trading_day
+        auto get_offset = [](const std::string& time)
+        {
+            int hour, min, sec;
+            sscanf(time.c_str(), "%d:%d:%d", &hour, &min, &sec);
+            long offset = (hour * 3600L + min * 60L + sec) * yijinjing::NANOSECONDS_PER_SECOND;
+            return hour >= SWITCH_HOUR ? offset - yijinjing::NANOSECONDS_PER_DAY : offset;
+        };
+
+        std::vector<long> day_nanos;
+        day_nanos.reserve(trading_days.size());
+        for (int day : trading_days)
+        {
+            struct tm day_tm = {};
+            day_tm.tm_year = day / 10000 - 1900;
+            day_tm.tm_mon = day / 100 % 100 - 1;
+            day_tm.tm_mday = day % 100;
+            day_tm.tm_isdst = -1;
+            day_nanos.push_back(yijinjing::parseTm(day_tm));
+        }
+
+        for (const auto& iter : trading_times)
+        {
+            const std::string& exchange_id = iter.first;
+            SessionTable& table = session_tables_[exchange_id];
+            table.trading_days = trading_days;
+            int slot_num = trading_evening[exchange_id] ? EVENING + 1 : AFTERNOON + 1;
+            for (int slot = MORNING; slot < slot_num; slot++)
+            {
+                long open_offset = get_offset(iter.second[0][slot]);
+                long close_offset = get_offset(iter.second[1][slot]);
+                table.open[slot].reserve(day_nanos.size());
+                table.close[slot].reserve(day_nanos.size());
+                for (long day_nano : day_nanos)
+                {
+                    table.open[slot].push_back(day_nano + open_offset);
+                    table.close[slot].push_back(day_nano + close_offset);
+                }
+            }
+            table.begin_nano = table.open[slot_num > EVENING ? EVENING : MORNING].front();
+            table.end_nano = table.close[AFTERNOON].back();
+        }
+        SPDLOG_INFO("[Calendar] indexed sessions of {} trading days from {} to {}", trading_days.size(), trading_days.front(), trading_days.back());
+    }
+
+    const Calendar::SessionTable* Calendar::get_session_table(long nano, const std::string& exchange_id) const
+    {
+        auto iter = session_tables_.find(exchange_id);
+        if (iter == session_tables_.end() || nano < iter->second.begin_nano || nano > iter->second.end_nano)
+        {
+            return nullptr;
+        }
+        return &iter->second;
+    }
+
     bool Calendar::is_open(long nano, const std::string& exchange_id)
+    {
+        const SessionTable* table = get_session_table(nano, exchange_id);
+        if (table == nullptr)
+        {
+            return is_open_by_day(nano, exchange_id);
+        }
+        // sessions of a slot do not overlap, the last one opened before nano is the only candidate
+        for (int slot = MORNING; slot <= EVENING; slot++)
+        {
+            const std::vector<long>& open = table->open[slot];
+            auto iter = std::upper_bound(open.begin(), open.end(), nano);
+            if (iter != open.begin() && table->close[slot][iter - open.begin() - 1] >= nano)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    long Calendar::next_open(long nano, const std::string& exchange_id, int slot)
+    {
+        const SessionTable* table = get_session_table(nano, exchange_id);
+        if (table == nullptr)
+        {
+            return next_open_by_day(nano, exchange_id, slot);
+        }
+        if (slot == DEFAULT_SLOT || table->open[slot].empty())
+        {
+            slot = MORNING;
+        }
+        const std::vector<long>& open = table->open[slot];
+        auto iter = std::lower_bound(open.begin(), open.end(), nano);
+        return iter != open.end() ? *iter : next_open_by_day(nano, exchange_id, slot);
+    }
+
+    long Calendar::next_close(long nano, const std::string& exchange_id, int slot)
+    {
+        const SessionTable* table = get_session_table(nano, exchange_id);
+        if (table == nullptr)
+        {
+            return next_close_by_day(nano, exchange_id, slot);
+        }
+        if (slot == DEFAULT_SLOT || table->close[slot].empty())
+        {
+            slot = AFTERNOON;
+        }
+        const std::vector<long>& close = table->close[slot];
+        auto iter = std::lower_bound(close.begin(), close.end(), nano);
+        return iter != close.end() ? *iter : next_close_by_day(nano, exchange_id, slot);
+    }
+
+    std::vector<TradingSession> Calendar::get_trading_sessions(long start_nano, long end_nano, const std::string& exchange_id)
+    {
+        const SessionTable* table = get_session_table(start_nano, exchange_id);
+        if (table == nullptr || end_nano > table->end_nano)
+        {
+            return get_trading_sessions_by_day(start_nano, end_nano, exchange_id);
+        }
+        std::vector<TradingSession> result;
+        bool evening = !table->open[EVENING].empty();
+        const std::vector<long>& last_close = table->close[AFTERNOON];
+        // first trading day not closed before start_nano, sessions of a day in time order
+        for (size_t i = std::lower_bound(last_close.begin(), last_close.end(), start_nano) - last_close.begin(); i < last_close.size(); i++)
+        {
+            if ((evening ? table->open[EVENING][i] : table->open[MORNING][i]) > end_nano)
+            {
+                break;
+            }
+            std::string trading_day = std::to_string(table->trading_days[i]);
+            for (int slot : {EVENING, MORNING, AFTERNOON})
+            {
+                if (table->open[slot].empty())
+                {
+                    continue;
+                }
+                long start = std::max(table->open[slot][i], start_nano);
+                long end = std::min(table->close[slot][i], end_nano);
+                if (start <= end)
+                {
+                    result.push_back({exchange_id, trading_day, start, end});
+                }
+            }
+        }
+        return result;
+    }
+
+    bool Calendar::is_open_by_day(long nano, const std::string& exchange_id)
     {
         std::string trading_day = get_trading_day_from_nano(nano);
         trading_day = get_next_trading_day(trading_day.c_str(),0);
@@ -72,7 +243,7 @@ namespace kungfu
         return get_nano_from_trading_day(trading_day, trading_times[exchange_id][1][slot]);
     }
 
-    long Calendar::next_open(long nano, const std::string& exchange_id, int slot)
+    long Calendar::next_open_by_day(long nano, const std::string& exchange_id, int slot)
     {
         std::string trading_day = get_trading_day_from_nano(nano);
         trading_day = get_next_trading_day(trading_day.c_str(),0);
@@ -89,7 +260,7 @@ namespace kungfu
         return get_open_time(trading_day, exchange_id, slot);
     }
 
-    long Calendar::next_close(long nano, const std::string& exchange_id, int slot)
+    long Calendar::next_close_by_day(long nano, const std::string& exchange_id, int slot)
     {
         std::string trading_day = get_trading_day_from_nano(nano);
         trading_day = get_next_trading_day(trading_day.c_str(),0);
@@ -106,7 +277,7 @@ namespace kungfu
         return get_close_time(trading_day, exchange_id, slot);
     }
 
-    std::vector<TradingSession> Calendar::get_trading_sessions(long start_nano, long end_nano, const std::string& exchange_id)
+    std::vector<TradingSession> Calendar::get_trading_sessions_by_day(long start_nano, long end_nano, const std::string& exchange_id)
     {
         std::vector<TradingSession> result;
         if(end_nano<start_nano)
@@ -16,9 +16,14 @@ namespace kungfu
     class CalendarStorage
     {
     public:
-        CalendarStorage(const std::string& file_name) : db_(file_name.c_str(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
+        //read_only: 库不存在时抛异常, 不创建空库
+        CalendarStorage(const std::string& file_name, bool read_only = false) :
+                db_(file_name.c_str(), read_only ? SQLite::OPEN_READONLY : SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
         {
-            create_table_if_not_exist();
+            if (!read_only)
+            {
+                create_table_if_not_exist();
+            }
         }
         void create_table_if_not_exist()
         {
@@ -34,18 +39,24 @@ namespace kungfu
                 SPDLOG_ERROR(e.what());
             }
         }
-        const void get_trading_days(int from_year, int to_year, std::vector<int>& trading_days,
-                                    const char* region)
+        //@return 读不到节假日(空库或出错)返回 false, 此时 trading_days 不可信
+        bool get_trading_days(int from_year, int to_year, std::vector<int>& trading_days,
+                              const char* region)
         {
             try
             {
                 std::set<int> holidays;
                 SQLite::Statement query(db_, "SELECT holiday FROM holidays WHERE region = ?");
                 query.bind(1, region);
-                if (query.executeStep())
+                while (query.executeStep())
                 {
                     holidays.insert(query.getColumn(0));
                 }
+                if (holidays.empty())
+                {
+                    SPDLOG_ERROR("no holiday of region {} in {}", region, db_.getFilename());
+                    return false;
+                }
                 int start = 0;
                 for (int year = from_year; year <= to_year; year++)
                 {
@@ -71,10 +82,11 @@ namespace kungfu
                         start += months[month];
                     }
                 }
-
+                return true;
             } catch (std::exception& e)
             {
                 SPDLOG_ERROR(e.what());
+                return false;
             }
         }
 
@@ -4,6 +4,8 @@
 
 #include "gtest/gtest.h"
 #include "calendar/include/calendar.h"
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <boost/filesystem.hpp>
 
 using namespace kungfu;
 
@@ -57,6 +59,73 @@ TEST(CalendarTest, TradingSession)
     EXPECT_EQ(yijinjing::parseNano(result[2].end_nano, "%Y%m%d-%H:%M:%S"), "20190410-23:00:00");
 }
 
+class SessionTableCalendar : public Calendar
+{
+public:
+    bool has_session_table() const { return !session_tables_.empty(); }
+};
+
+// holiday db is looked up in KF_HOME, a fresh one per test
+class CalendarHolidayTest : public ::testing::Test
+{
+protected:
+    CalendarHolidayTest()
+    {
+        const char* home = getenv("KF_HOME");
+        old_home = home == nullptr ? "" : home;
+        home_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("kf-calendar-%%%%%%");
+        boost::filesystem::create_directories(home_dir / "global");
+        setenv("KF_HOME", home_dir.string().c_str(), 1);
+    }
+
+    virtual ~CalendarHolidayTest()
+    {
+        setenv("KF_HOME", old_home.c_str(), 1);
+        boost::filesystem::remove_all(home_dir);
+    }
+
+    void create_holiday_db(const std::vector<int>& holidays)
+    {
+        SQLite::Database db(fmt::format(CALENDAR_HOLIDAY_DB_FILE_FORMAT, home_dir.string()), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        db.exec("CREATE TABLE holidays(region CHAR(50), holiday INTEGER)");
+        for (int holiday : holidays)
+        {
+            SQLite::Statement insert(db, "INSERT INTO holidays VALUES(?, ?)");
+            insert.bind(1, REGION_CN);
+            insert.bind(2, holiday);
+            insert.exec();
+        }
+    }
+
+    boost::filesystem::path home_dir;
+    std::string old_home;
+};
+
+TEST_F(CalendarHolidayTest, MissingDb)
+{
+    SessionTableCalendar calendar;
+    EXPECT_FALSE(calendar.has_session_table());
+    // read only, no empty db is left behind
+    EXPECT_FALSE(boost::filesystem::exists(fmt::format(CALENDAR_HOLIDAY_DB_FILE_FORMAT, home_dir.string())));
+}
+
+TEST_F(CalendarHolidayTest, EmptyDb)
+{
+    create_holiday_db({});
+    SessionTableCalendar calendar;
+    EXPECT_FALSE(calendar.has_session_table());
+}
+
+TEST_F(CalendarHolidayTest, HolidayDb)
+{
+    create_holiday_db({20190405, 20190501});
+    SessionTableCalendar calendar;
+    EXPECT_TRUE(calendar.has_session_table());
+    long nano = yijinjing::parseTime("20190404-10:00:00", "%Y%m%d-%H:%M:%S");
+    EXPECT_EQ(yijinjing::parseNano(calendar.next_open(nano, "SSE"), "%Y%m%d-%H:%M:%S"), "20190408-09:30:00");
+    EXPECT_EQ(calendar.is_open(yijinjing::parseTime("20190501-10:00:00", "%Y%m%d-%H:%M:%S"), "SSE"), false);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
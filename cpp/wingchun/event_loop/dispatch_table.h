@@ -0,0 +1,281 @@
+//
+// Handlers of EventLoop indexed by msg type, any number per type,
+// each with an optional filter on instrument / exchange / source checked on the payload in place.
+//
+
+#ifndef KUNGFU_DISPATCH_TABLE_H
+#define KUNGFU_DISPATCH_TABLE_H
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "md_struct.h"
+#include "oms_struct.h"
+#include "util/include/symbol_interner.h"
+
+namespace kungfu
+{
+#define DISPATCH_INVALID_HANDLE 0
+#define DISPATCH_MSG_TYPE_LIMIT 1024 // msg types are below, see msg.h
+
+    typedef int64_t DispatchHandle;
+
+    // instruments a handler wants, from one source or from any.
+    // a filter with nothing added lets nothing through, a handler without filter gets everything.
+    // accept never copies the payload nor allocates, symbols are looked up in the SymbolInterner.
+    class DispatchFilter
+    {
+    public:
+        // instrument from any source
+        void add_instrument(const std::string& instrument_id, const std::string& exchange_id)
+        {
+            add_instrument("", instrument_id, exchange_id);
+        }
+
+        // instrument from source_id only
+        void add_instrument(const std::string& source_id, const std::string& instrument_id, const std::string& exchange_id)
+        {
+            uint32_t id = SymbolInterner::get_interner().intern(instrument_id.c_str(), exchange_id.c_str());
+            SourceEntry& entry = get_entry(source_id);
+            if (entry.symbols.size() <= id)
+            {
+                entry.symbols.resize(id + 1, false);
+            }
+            entry.symbols[id] = true;
+        }
+
+        // everything from source_id
+        void add_source(const std::string& source_id)
+        {
+            get_entry(source_id).all = true;
+        }
+
+        void clear()
+        {
+            entries_.clear();
+        }
+
+        // source_id is nullptr for payloads without source (order, trade), any source matches then
+        bool accept(const char* instrument_id, const char* exchange_id, const char* source_id) const
+        {
+            uint32_t id = SYMBOL_ID_NONE;
+            bool looked_up = false;
+            for (const auto& entry : entries_)
+            {
+                if (source_id != nullptr && !entry.source_id.empty() && strcmp(entry.source_id.c_str(), source_id) != 0)
+                {
+                    continue;
+                }
+                if (entry.all)
+                {
+                    return true;
+                }
+                if (!looked_up)
+                {
+                    id = SymbolInterner::get_interner().find(instrument_id, exchange_id);
+                    looked_up = true;
+                }
+                if (id < entry.symbols.size() && entry.symbols[id])
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    private:
+        struct SourceEntry
+        {
+            std::string source_id; // empty for any source
+            bool all;
+            std::vector<bool> symbols; // indexed by symbol id
+        };
+
+        SourceEntry& get_entry(const std::string& source_id)
+        {
+            for (auto& entry : entries_)
+            {
+                if (entry.source_id == source_id)
+                {
+                    return entry;
+                }
+            }
+            entries_.push_back(SourceEntry{source_id, false, {}});
+            return entries_.back();
+        }
+
+        std::vector<SourceEntry> entries_; // a handful of sources, scanned linearly
+    };
+    typedef std::shared_ptr<DispatchFilter> DispatchFilterPtr;
+
+    // payload types a filter can be applied to
+    inline bool dispatch_accept(const DispatchFilter& filter, const Quote& quote)
+    {
+        return filter.accept(quote.instrument_id, quote.exchange_id, quote.source_id);
+    }
+
+    inline bool dispatch_accept(const DispatchFilter& filter, const Entrust& entrust)
+    {
+        return filter.accept(entrust.instrument_id, entrust.exchange_id, entrust.source_id);
+    }
+
+    inline bool dispatch_accept(const DispatchFilter& filter, const Transaction& transaction)
+    {
+        return filter.accept(transaction.instrument_id, transaction.exchange_id, transaction.source_id);
+    }
+
+    inline bool dispatch_accept(const DispatchFilter& filter, const OrderInput& input)
+    {
+        return filter.accept(input.instrument_id, input.exchange_id, nullptr);
+    }
+
+    inline bool dispatch_accept(const DispatchFilter& filter, const Order& order)
+    {
+        return filter.accept(order.instrument_id, order.exchange_id, nullptr);
+    }
+
+    inline bool dispatch_accept(const DispatchFilter& filter, const Trade& trade)
+    {
+        return filter.accept(trade.instrument_id, trade.exchange_id, nullptr);
+    }
+
+    // not thread safe, handlers are added, removed and called on the event loop thread.
+    // handlers added or removed by a handler take effect once the current dispatch returns.
+    class DispatchTable
+    {
+    public:
+        DispatchTable(): table_(DISPATCH_MSG_TYPE_LIMIT), last_handle_(DISPATCH_INVALID_HANDLE), dispatching_(0), removed_(0) {}
+
+        // T is the payload type of msg_type
+        template <typename T>
+        DispatchHandle add(int msg_type, std::function<void (const T&)> handler)
+        {
+            return add_entry(msg_type, nullptr, nullptr, [handler](const void* data) { handler(*(const T*)data); });
+        }
+
+        // handler only gets payloads accepted by filter, needs a dispatch_accept overload for T
+        template <typename T>
+        DispatchHandle add(int msg_type, std::function<void (const T&)> handler, DispatchFilterPtr filter)
+        {
+            if (filter == nullptr)
+            {
+                return add<T>(msg_type, std::move(handler));
+            }
+            return add_entry(msg_type, std::move(filter), &accept_payload<T>, [handler](const void* data) { handler(*(const T*)data); });
+        }
+
+        bool remove(DispatchHandle handle)
+        {
+            for (auto& entries : table_)
+            {
+                for (auto& entry : entries)
+                {
+                    if (entry.handle == handle && !entry.removed)
+                    {
+                        // the handler may be running, it is dropped after the dispatch
+                        entry.removed = true;
+                        removed_++;
+                        apply_changes();
+                        return true;
+                    }
+                }
+            }
+            for (auto iter = pending_.begin(); iter != pending_.end(); ++iter)
+            {
+                if (iter->second.handle == handle)
+                {
+                    pending_.erase(iter);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // false if msg_type has no handler, callers may skip decoding the payload then
+        bool has_handler(int msg_type) const
+        {
+            return msg_type >= 0 && msg_type < DISPATCH_MSG_TYPE_LIMIT && !table_[msg_type].empty();
+        }
+
+        void dispatch(int msg_type, const void* data)
+        {
+            if (!has_handler(msg_type))
+            {
+                return;
+            }
+            dispatching_++;
+            for (const auto& entry : table_[msg_type])
+            {
+                if (!entry.removed && (entry.filter == nullptr || entry.accept(*entry.filter, data)))
+                {
+                    entry.handler(data);
+                }
+            }
+            dispatching_--;
+            apply_changes();
+        }
+
+    private:
+        typedef bool (*AcceptFunc)(const DispatchFilter& filter, const void* data);
+
+        struct DispatchEntry
+        {
+            DispatchHandle handle;
+            DispatchFilterPtr filter;
+            AcceptFunc accept;
+            std::function<void (const void*)> handler;
+            bool removed;
+        };
+
+        template <typename T>
+        static bool accept_payload(const DispatchFilter& filter, const void* data)
+        {
+            return dispatch_accept(filter, *(const T*)data);
+        }
+
+        DispatchHandle add_entry(int msg_type, DispatchFilterPtr filter, AcceptFunc accept, std::function<void (const void*)> handler)
+        {
+            if (msg_type < 0 || msg_type >= DISPATCH_MSG_TYPE_LIMIT)
+            {
+                return DISPATCH_INVALID_HANDLE;
+            }
+            DispatchHandle handle = ++last_handle_;
+            pending_.emplace_back(msg_type, DispatchEntry{handle, std::move(filter), accept, std::move(handler), false});
+            apply_changes();
+            return handle;
+        }
+
+        void apply_changes()
+        {
+            if (dispatching_ > 0)
+            {
+                return;
+            }
+            if (removed_ > 0)
+            {
+                for (auto& entries : table_)
+                {
+                    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const DispatchEntry& entry) { return entry.removed; }), entries.end());
+                }
+                removed_ = 0;
+            }
+            for (auto& pending : pending_)
+            {
+                table_[pending.first].emplace_back(std::move(pending.second));
+            }
+            pending_.clear();
+        }
+
+        std::vector<std::vector<DispatchEntry>> table_; // indexed by msg type, handlers in order of adding
+        std::vector<std::pair<int, DispatchEntry>> pending_;
+        DispatchHandle last_handle_;
+        int dispatching_;
+        int removed_;
+    };
+}
+
+#endif //KUNGFU_DISPATCH_TABLE_H
@@ -12,17 +12,37 @@
 #include "nlohmann/json.hpp"
 #include "Timer.h"
 #include "util/include/nanomsg_util.h"
+#include "util/include/latency_probe.h"
+#include "util/include/env.h"
+#include "util/include/filesystem_util.h"
+#include "config.h"
 #include "oms/include/def.h"
+#include "nn_publisher/nn_codec.h"
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
 
 namespace kungfu
 {
     volatile sig_atomic_t EventLoop::signal_received_ = -1;
 
+    EventLoop::~EventLoop()
+    {
+        if (epoll_fd_ >= 0)
+        {
+            close(epoll_fd_);
+        }
+    }
+
     void EventLoop::subscribe_nanomsg(const std::string& url)
     {
         std::shared_ptr<nn::socket> socket = std::shared_ptr<nn::socket>(new nn::socket(AF_SP, NN_SUB));
         socket->connect(url.c_str());
-        socket->setsockopt(NN_SUB, NN_SUB_SUBSCRIBE, "", 0);
+        // json messages only, binary ones are for subscribers who asked for NN_BINARY_TOPIC
+        socket->setsockopt(NN_SUB, NN_SUB_SUBSCRIBE, NN_JSON_TOPIC, strlen(NN_JSON_TOPIC));
         socket_vec_.emplace_back(socket);
     }
 
@@ -38,6 +58,7 @@ namespace kungfu
         if (reader_.get() == nullptr)
         {
             reader_ = kungfu::yijinjing::JournalReader::create(journal_folder, journal_name, offset_nano, name_);
+            reader_->setMergeMode(merge_mode_);
         }
         else
         {
@@ -46,74 +67,106 @@ namespace kungfu
         }
     }
 
-    void EventLoop::register_nanotime_callback(int64_t nano, TSCallback callback)
+    void EventLoop::set_journal_merge_mode(yijinjing::JournalMergeMode mode)
+    {
+        merge_mode_ = mode;
+        if (reader_.get() != nullptr)
+        {
+            reader_->setMergeMode(mode);
+        }
+    }
+
+    TSHandle EventLoop::register_nanotime_callback(int64_t nano, TSCallback callback)
     {
-        scheduler_->insert_callback_at(nano, callback);
+        return scheduler_->insert_callback_at(nano, callback);
     }
 
-    void EventLoop::register_nanotime_callback_at_next(const char *time_str, kungfu::TSCallback callback)
+    TSHandle EventLoop::register_nanotime_callback_at_next(const char *time_str, kungfu::TSCallback callback)
     {
-        scheduler_->insert_callback_at_next(time_str, callback);
+        return scheduler_->insert_callback_at_next(time_str, callback);
     }
 
-    void EventLoop::register_quote_callback(QuoteCallback callback)
+    TSHandle EventLoop::register_nanotime_interval_callback(int64_t interval_nano, kungfu::TSCallback callback, int64_t first_nano)
     {
-        quote_callback_ = callback;
+        return scheduler_->insert_callback_every(interval_nano, callback, false, first_nano);
     }
 
-    void EventLoop::register_entrust_callback(EntrustCallback callback)
+    bool EventLoop::cancel_nanotime_callback(TSHandle handle)
     {
-        entrust_callback_ = callback;
+        return scheduler_->cancel(handle);
     }
 
-    void EventLoop::register_transaction_callback(TransactionCallback callback)
+    DispatchHandle EventLoop::register_quote_callback(QuoteCallback callback, DispatchFilterPtr filter)
     {
-        transaction_callback_ = callback;
+        return dispatch_table_.add<Quote>((int)MsgType::Quote, callback, filter);
     }
 
-    void EventLoop::register_req_login_callback(ReqLoginCallback callback)
+    DispatchHandle EventLoop::register_entrust_callback(EntrustCallback callback, DispatchFilterPtr filter)
     {
-        login_callback_ = callback;
+        return dispatch_table_.add<Entrust>((int)MsgType::Entrust, callback, filter);
     }
 
-    void EventLoop::register_subscribe_callback(SubscribeCallback callback)
+    DispatchHandle EventLoop::register_transaction_callback(TransactionCallback callback, DispatchFilterPtr filter)
     {
-        sub_callback_ = callback;
+        return dispatch_table_.add<Transaction>((int)MsgType::Transaction, callback, filter);
     }
 
-    void EventLoop::register_order_input_callback(OrderInputCallback callback)
+    DispatchHandle EventLoop::register_req_login_callback(ReqLoginCallback callback)
     {
-        order_input_callback_ = callback;
+        return dispatch_table_.add<LoginRequest>((int)MsgType::ReqLogin, [callback](const LoginRequest& req) { callback(req.recipient, req.sender); });
     }
 
-    void EventLoop::register_order_action_callback(OrderActionCallback callback)
+    DispatchHandle EventLoop::register_subscribe_callback(SubscribeCallback callback)
     {
-        order_action_callback_ = callback;
+        return dispatch_table_.add<SubscribeRequest>((int)MsgType::Subscribe, [callback](const SubscribeRequest& req)
+        {
+            std::vector<Instrument> instruments = req.instruments;
+            callback(req.recipient, instruments, req.is_level2);
+        });
     }
 
-    void EventLoop::register_order_callback(OrderCallback callback)
+    DispatchHandle EventLoop::register_order_input_callback(OrderInputCallback callback, DispatchFilterPtr filter)
     {
-        order_callback_ = callback;
+        return dispatch_table_.add<OrderInput>((int)MsgType::OrderInput, callback, filter);
     }
 
-    void EventLoop::register_trade_callback(TradeCallback callback)
+    DispatchHandle EventLoop::register_order_action_callback(OrderActionCallback callback)
     {
-        trade_callback_ = callback;
+        return dispatch_table_.add<OrderAction>((int)MsgType::OrderAction, callback);
     }
 
-    void EventLoop::register_algo_order_input_callback(AlgoOrderInputCallback callback)
+    DispatchHandle EventLoop::register_order_callback(OrderCallback callback, DispatchFilterPtr filter)
     {
-        algo_order_input_callback_ = callback;
+        return dispatch_table_.add<Order>((int)MsgType::Order, callback, filter);
     }
 
-    void EventLoop::register_algo_order_status_callback(AlgoOrderStatusCallback callback)
+    DispatchHandle EventLoop::register_trade_callback(TradeCallback callback, DispatchFilterPtr filter)
     {
-        algo_order_status_callback_ = callback;
+        return dispatch_table_.add<Trade>((int)MsgType::Trade, callback, filter);
     }
 
-    void EventLoop::register_algo_order_action_callback(AlgoOrderActionCallback callback)
+    DispatchHandle EventLoop::register_algo_order_input_callback(AlgoOrderInputCallback callback)
     {
-        algo_order_action_callback_ = callback;
+        return dispatch_table_.add<AlgoOrderInput>((int)MsgType::AlgoOrderInput, [callback](const AlgoOrderInput& msg)
+        {
+            callback(msg.order_id, msg.client_id, msg.algo_type, get_algo_msg_var(msg));
+        });
+    }
+
+    DispatchHandle EventLoop::register_algo_order_status_callback(AlgoOrderStatusCallback callback)
+    {
+        return dispatch_table_.add<AlgoOrderStatus>((int)MsgType::AlgoOrderStatus, [callback](const AlgoOrderStatus& msg)
+        {
+            callback(msg.order_id, msg.algo_type, get_algo_msg_var(msg));
+        });
+    }
+
+    DispatchHandle EventLoop::register_algo_order_action_callback(AlgoOrderActionCallback callback)
+    {
+        return dispatch_table_.add<AlgoOrderAction>((int)MsgType::AlgoOrderAction, [callback](const AlgoOrderAction& msg)
+        {
+            callback(msg.order_id, msg.order_action_id, get_algo_msg_var(msg));
+        });
     }
 
     void EventLoop::register_signal_callback(SignalCallback signal_callback)
@@ -135,9 +188,41 @@ namespace kungfu
         
         quit_ = false;
 
+        const char* wait_env = getenv(EVENT_LOOP_WAIT_ENV);
+        if (wait_env != nullptr)
+        {
+            std::string mode = wait_env;
+            if (mode == "spin") wait_mode_ = EventLoopWaitMode::BusySpin;
+            else if (mode == "yield") wait_mode_ = EventLoopWaitMode::SpinYield;
+            else if (mode == "park") wait_mode_ = EventLoopWaitMode::SpinPark;
+            else if (mode == "epoll") wait_mode_ = EventLoopWaitMode::Epoll;
+            else SPDLOG_WARN("unknown {} {}, use spin / yield / park / epoll", EVENT_LOOP_WAIT_ENV, mode);
+        }
+        SPDLOG_INFO("event loop {} wait mode {}", name_, (int)wait_mode_);
+
+        TSHandle latency_timer = TS_INVALID_HANDLE;
+        if (LatencyRegistry::get().enabled())
+        {
+            latency_timer = register_nanotime_interval_callback(LATENCY_REPORT_INTERVAL_SEC * yijinjing::NANOSECONDS_PER_SECOND,
+                                                                [this](long nano) { dump_latency(nano); });
+        }
+
+        int idle = 0;
         while (! quit_ && signal_received_ < 0)
         {
-            iteration();
+            if (iteration())
+            {
+                idle = 0;
+            }
+            else if (wait_mode_ != EventLoopWaitMode::BusySpin && ++idle >= EVENT_LOOP_SPIN_BEFORE_WAIT && wait())
+            {
+                idle = 0;
+            }
+        }
+        if (latency_timer != TS_INVALID_HANDLE)
+        {
+            cancel_nanotime_callback(latency_timer);
+            dump_latency(yijinjing::getNanoTime());
         }
         if (signal_received_ >= 0)
         {
@@ -149,145 +234,186 @@ namespace kungfu
         }
     }
 
+    void EventLoop::dump_latency(int64_t nano)
+    {
+        SPDLOG_INFO("latency of {} (nano) {}\n{}", name_, nano, LatencyRegistry::get().to_string());
+        if (get_base_dir() == nullptr)
+        {
+            return;
+        }
+        create_folder_if_not_exists(fmt::format("{}/latency", get_base_dir()));
+        std::string file_path = fmt::format(LATENCY_REPORT_FILE_FORMAT, get_base_dir(), name_);
+        if (!LatencyRegistry::get().dump(file_path, nano))
+        {
+            SPDLOG_ERROR("failed to dump latency to {}", file_path);
+        }
+    }
+
     void EventLoop::stop()
     {
         quit_= true;
     }
 
-    void EventLoop::iteration()
+    bool EventLoop::wait()
+    {
+        switch (wait_mode_)
+        {
+            case EventLoopWaitMode::SpinYield:
+            {
+                std::this_thread::yield();
+                return false;
+            }
+            case EventLoopWaitMode::SpinPark:
+            {
+                int wait_micro = get_wait_micro(EVENT_LOOP_PARK_TIMEOUT_MICROSEC);
+                if (wait_micro <= 0)
+                {
+                    return false;
+                }
+                if (reader_ != nullptr)
+                {
+                    return iteration(wait_micro);
+                }
+                if (!socket_vec_.empty())
+                {
+                    epoll_wait_sockets((wait_micro + 999) / 1000);
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(wait_micro));
+                }
+                return false;
+            }
+            case EventLoopWaitMode::Epoll:
+            {
+                // journal writes do not wake epoll, keep polling journals at a coarse interval
+                int wait_micro = get_wait_micro(reader_ != nullptr ? EVENT_LOOP_EPOLL_JOURNAL_POLL_MS * 1000 : EVENT_LOOP_PARK_TIMEOUT_MICROSEC);
+                if (wait_micro > 0)
+                {
+                    epoll_wait_sockets((wait_micro + 999) / 1000);
+                }
+                return false;
+            }
+            default:
+            {
+                return false;
+            }
+        }
+    }
+
+    int EventLoop::get_wait_micro(int limit_micro) const
+    {
+        int64_t next_nano = scheduler_->get_next_nano();
+        if (next_nano == LONG_MAX)
+        {
+            return limit_micro;
+        }
+        int64_t wait_micro = (next_nano - yijinjing::getNanoTime()) / 1000;
+        return wait_micro >= limit_micro ? limit_micro : (wait_micro > 0 ? (int)wait_micro : 0);
+    }
+
+    void EventLoop::epoll_wait_sockets(int timeout_ms)
+    {
+#ifdef __linux__
+        if (epoll_fd_ < 0 || epoll_socket_num_ != socket_vec_.size())
+        {
+            if (epoll_fd_ >= 0)
+            {
+                close(epoll_fd_);
+            }
+            epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+            epoll_socket_num_ = socket_vec_.size();
+            for (const auto& socket: socket_vec_)
+            {
+                int fd = -1;
+                size_t fd_size = sizeof(fd);
+                try
+                {
+                    // readable while the socket has a message to receive
+                    socket->getsockopt(NN_SOL_SOCKET, NN_RCVFD, &fd, &fd_size);
+                }
+                catch (std::exception &e)
+                {
+                    SPDLOG_WARN("socket has no receive fd to wait on, exception: {}", e.what());
+                    continue;
+                }
+                struct epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.fd = fd;
+                epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+            }
+        }
+        struct epoll_event events[16];
+        epoll_wait(epoll_fd_, events, 16, timeout_ms);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+#endif
+    }
+
+    bool EventLoop::iteration(int wait_micro)
     {
+        bool handled = false;
         int64_t nano = -1;
         if (reader_ != nullptr)
         {
-            yijinjing::FramePtr frame = reader_->getNextFrame();
-            if (frame != nullptr)
+            yijinjing::Frame frame(nullptr);
+            if (wait_micro > 0 ? reader_->waitNextFrame(frame, wait_micro) : reader_->getNextFrame(frame))
             {
-                nano = frame->getNano();
-                int msg_type = frame->getMsgType();
+                handled = true;
+                nano = frame.getNano();
+                int msg_type = frame.getMsgType();
+                // md frames originate here, others carry the md nano they were caused by in extra nano
+                int64_t& origin_nano = latency_origin_nano();
                 switch (msg_type)
                 {
                     case (int)MsgType::Quote:
-                    {
-                        Quote* quote_ptr = (Quote*) frame->getData();
-                        if (quote_callback_)
-                        {
-                            quote_callback_(*quote_ptr);
-                        }
+                        origin_nano = ((const Quote*)frame.getData())->rcv_time;
+                        LATENCY_PROBE("loop.journal_to_quote", yijinjing::getNanoTime() - nano);
                         break;
-                    }
                     case (int)MsgType::Entrust:
-                    {
-                        Entrust* entrust_ptr = (Entrust*) frame->getData();
-                        if (entrust_callback_)
-                        {
-                            entrust_callback_(*entrust_ptr);
-                        }
+                        origin_nano = ((const Entrust*)frame.getData())->rcv_time;
                         break;
-                    }
                     case (int)MsgType::Transaction:
-                    {
-                        Transaction* transaction_ptr = (Transaction*) frame->getData();
-                        if (transaction_callback_)
-                        {
-                            transaction_callback_(*transaction_ptr);
-                        }
+                        origin_nano = ((const Transaction*)frame.getData())->rcv_time;
                         break;
-                    }
-                    case (int) MsgType::OrderInput:
-                    {
-                        OrderInput* input = (OrderInput*) frame->getData();
-                        if (order_input_callback_)
-                        {
-                            order_input_callback_(*input);
-                        }
-                        break;
-                    }
-                    case (int)MsgType::OrderAction:
-                    {
-                        OrderAction* action = (OrderAction*) frame->getData();
-                        if (order_action_callback_)
-                        {
-                            order_action_callback_(*action);
-                        }
+                    case (int)MsgType::OrderInput:
+                        origin_nano = frame.getExtraNano();
+                        LATENCY_PROBE("loop.journal_to_order_input", yijinjing::getNanoTime() - nano);
                         break;
-                    }
-                    case (int)MsgType::Order:
-                    {
-                        Order* order = (Order*) frame->getData();
-                        if (order_callback_)
-                        {
-                            order_callback_(*order);
-                        }
-                        break;
-                    }
-                    case (int)MsgType::Trade:
-                    {
-                        Trade* trade = (Trade*) frame->getData();
-                        if (trade_callback_)
-                        {
-                            trade_callback_(*trade);
-                        }
-                        break;
-                    }
-                    case (int)MsgType::AlgoOrderInput:
-                    {
-                        std::string js((char *) frame->getData());
-                        try
-                        {
-                            nlohmann::json j = nlohmann::json::parse(js);
-                            AlgoOrderInput msg = j;
-                            if(algo_order_input_callback_)
-                            {
-                                algo_order_input_callback_(msg.order_id, msg.client_id, msg.algo_type, msg.input);
-                            }
-                        }
-                        catch (std::exception& e)
-                        {
-                            SPDLOG_ERROR("failed to parse algo order input msg, data[{}], exception: {}", (char*)frame->getData(), e.what());
-                        }
-                        break;
-                    }
-                    case (int)MsgType::AlgoOrderStatus:
+                    default:
+                        origin_nano = frame.getExtraNano();
+                }
+                // nothing is decoded for msg types nobody listens to
+                if (dispatch_table_.has_handler(msg_type))
+                {
+                    switch (msg_type)
                     {
-                        std::string js((char*) frame->getData());
-                        try
+                        case (int)MsgType::AlgoOrderInput:
+                        case (int)MsgType::AlgoOrderStatus:
+                        case (int)MsgType::AlgoOrderAction:
                         {
-                            nlohmann::json j = nlohmann::json::parse(js);
-                            AlgoOrderStatus msg = j;
-                            if(algo_order_status_callback_)
+                            // header plus variable part, read in place
+                            bool valid = msg_type == (int)MsgType::AlgoOrderInput ? is_algo_msg_valid<AlgoOrderInput>(frame.getData(), frame.getDataLength()) :
+                                         msg_type == (int)MsgType::AlgoOrderStatus ? is_algo_msg_valid<AlgoOrderStatus>(frame.getData(), frame.getDataLength()) :
+                                         is_algo_msg_valid<AlgoOrderAction>(frame.getData(), frame.getDataLength());
+                            if (valid)
                             {
-                                algo_order_status_callback_(msg.order_id, msg.algo_type, msg.status);
+                                dispatch_table_.dispatch(msg_type, frame.getData());
                             }
-                        }
-                        catch (std::exception& e)
-                        {
-                            SPDLOG_ERROR("failed to parse algo order action msg, data[{}], exception: {}", (char*)frame->getData(), e.what());
-                        }
-                        break;
-                    }
-                    case (int)MsgType::AlgoOrderAction:
-                    {
-                        std::string js((char*) frame->getData());
-                        try
-                        {
-                            nlohmann::json j = nlohmann::json::parse(js);
-                            AlgoOrderAction msg = j;
-                            if(algo_order_action_callback_)
+                            else
                             {
-                                algo_order_action_callback_(msg.order_id, msg.order_action_id, msg.action);
+                                SPDLOG_ERROR("invalid algo order msg, msg type {}, data length {}", msg_type, frame.getDataLength());
                             }
+                            break;
                         }
-                        catch (std::exception& e)
+                        default:
                         {
-                            SPDLOG_ERROR("failed to parse algo order action msg, data[{}], exception: {}", (char*)frame->getData(), e.what());
+                            // POD payload, handlers and their filters read it in place
+                            dispatch_table_.dispatch(msg_type, frame.getData());
                         }
-                        break;
-                    }
-                    default:
-                    {
-                        ;
                     }
                 }
+                origin_nano = 0;
             }
         }
 
@@ -303,6 +429,7 @@ namespace kungfu
             int rc = socket->recv(&buf, NN_MSG, NN_DONTWAIT); // non-blocking
             if (rc > 0)
             {
+                handled = true;
                 SPDLOG_TRACE("recv: data[{}]\n", buf);
                 try
                 {
@@ -312,19 +439,19 @@ namespace kungfu
                     {
                         case MsgType::ReqLogin:
                         {
-                            if (login_callback_)
+                            if (dispatch_table_.has_handler((int)msg.msg_type))
                             {
                                 LoginRequest req = msg.data;
-                                login_callback_(req.recipient, req.sender);
+                                dispatch_table_.dispatch((int)msg.msg_type, &req);
                             }
                             break;
                         }
                         case MsgType::Subscribe:
                         {
-                            SubscribeRequest req = msg.data;
-                            if (sub_callback_)
+                            if (dispatch_table_.has_handler((int)msg.msg_type))
                             {
-                                sub_callback_(req.recipient, req.instruments, req.is_level2);
+                                SubscribeRequest req = msg.data;
+                                dispatch_table_.dispatch((int)msg.msg_type, &req);
                             }
                             break;
                         }
@@ -345,5 +472,6 @@ namespace kungfu
                 nn::freemsg(buf);
             }
         }
+        return handled;
     }
 }
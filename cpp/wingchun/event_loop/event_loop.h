@@ -11,7 +11,9 @@
 #include "JournalReader.h"
 #include "md_struct.h"
 #include "oms_struct.h"
+#include "msg.h"
 #include "task_scheduler/task_scheduler.h"
+#include "dispatch_table.h"
 
 namespace kungfu
 {
@@ -29,43 +31,76 @@ namespace kungfu
     typedef std::function<void (uint64_t order_id, uint64_t order_action_id, const std::string& cmd)> AlgoOrderActionCallback;
     typedef std::function<void(int sig)> SignalCallback;
 
+    // what run() does when there is nothing to handle
+    enum class EventLoopWaitMode: int
+    {
+        BusySpin = 0,   // poll all the time, lowest latency, burns a core
+        SpinYield = 1,  // spin, then yield the cpu between polls
+        SpinPark = 2,   // spin, then park until a journal is written (paged doorbell), a timer is due or EVENT_LOOP_PARK_TIMEOUT_MICROSEC
+        Epoll = 3       // spin, then sleep in epoll on nanomsg sockets, journals are polled every EVENT_LOOP_EPOLL_JOURNAL_POLL_MS
+    };
+
+#define EVENT_LOOP_SPIN_BEFORE_WAIT 20000 // idle iterations before yield / park / epoll
+#define EVENT_LOOP_PARK_TIMEOUT_MICROSEC 10000 // a parked loop polls nanomsg sockets at least this often
+#define EVENT_LOOP_EPOLL_JOURNAL_POLL_MS 1
+#define EVENT_LOOP_WAIT_ENV "KF_EVENT_LOOP_WAIT" // spin / yield / park / epoll, overrides set_wait_mode
+
     class EventLoop
     {
     public:
-        EventLoop(const std::string& name): quit_(false), name_(name), reader_(nullptr), scheduler_(new TaskScheduler()) {};
+        EventLoop(const std::string& name): quit_(false), name_(name), reader_(nullptr), merge_mode_(yijinjing::MERGE_LINEAR_SCAN), scheduler_(new TaskScheduler()),
+                                            wait_mode_(EventLoopWaitMode::BusySpin), epoll_fd_(-1), epoll_socket_num_(0) {};
+        ~EventLoop();
 
         void subscribe_nanomsg(const std::string& url);
         void bind_nanomsg(const std::string& url);
 
         void add_socket(std::shared_ptr<nn::socket> socket) {  socket_vec_.push_back(socket); };
         void subscribe_yjj_journal(const std::string& journal_folder, const std::string& journal_name, int64_t offset_nano);
-
-        void register_nanotime_callback(int64_t nano, TSCallback callback); // if nano == 0, trigger at next update
-        void register_nanotime_callback_at_next(const char* time_str, TSCallback callback);
-
-        void register_quote_callback(QuoteCallback callback);
-        void register_entrust_callback(EntrustCallback callback);
-        void register_transaction_callback(TransactionCallback callback);
-
-        void register_order_input_callback(OrderInputCallback callback);
-        void register_order_action_callback(OrderActionCallback callback);
-
-        void register_order_callback(OrderCallback callback);
-        void register_trade_callback(TradeCallback callback);
-
-        void register_subscribe_callback(SubscribeCallback callback);
-        void register_req_login_callback(ReqLoginCallback callback);
-
-        void register_algo_order_input_callback(AlgoOrderInputCallback callback);
-        void register_algo_order_status_callback(AlgoOrderStatusCallback callback);
-        void register_algo_order_action_callback(AlgoOrderActionCallback callback);
+        void set_journal_merge_mode(yijinjing::JournalMergeMode mode); // heap merge suits readers with many journals
+        void set_wait_mode(EventLoopWaitMode mode) { wait_mode_ = mode; }
+        EventLoopWaitMode get_wait_mode() const { return wait_mode_; }
+
+        TSHandle register_nanotime_callback(int64_t nano, TSCallback callback); // if nano == 0, trigger at next update
+        TSHandle register_nanotime_callback_at_next(const char* time_str, TSCallback callback);
+        TSHandle register_nanotime_interval_callback(int64_t interval_nano, TSCallback callback, int64_t first_nano = 0);
+        bool cancel_nanotime_callback(TSHandle handle);
+
+        // callbacks add to the handlers of their msg type, all of them are called in order of registering.
+        // with a filter, a callback only gets data of the instruments / sources in the filter
+        DispatchHandle register_quote_callback(QuoteCallback callback, DispatchFilterPtr filter = nullptr);
+        DispatchHandle register_entrust_callback(EntrustCallback callback, DispatchFilterPtr filter = nullptr);
+        DispatchHandle register_transaction_callback(TransactionCallback callback, DispatchFilterPtr filter = nullptr);
+
+        DispatchHandle register_order_input_callback(OrderInputCallback callback, DispatchFilterPtr filter = nullptr);
+        DispatchHandle register_order_action_callback(OrderActionCallback callback);
+
+        DispatchHandle register_order_callback(OrderCallback callback, DispatchFilterPtr filter = nullptr);
+        DispatchHandle register_trade_callback(TradeCallback callback, DispatchFilterPtr filter = nullptr);
+
+        DispatchHandle register_subscribe_callback(SubscribeCallback callback);
+        DispatchHandle register_req_login_callback(ReqLoginCallback callback);
+
+        DispatchHandle register_algo_order_input_callback(AlgoOrderInputCallback callback);
+        DispatchHandle register_algo_order_status_callback(AlgoOrderStatusCallback callback);
+        DispatchHandle register_algo_order_action_callback(AlgoOrderActionCallback callback);
+
+        // any journal msg type with a POD payload T
+        template <typename T>
+        DispatchHandle register_callback(MsgType msg_type, std::function<void (const T&)> callback)
+        {
+            return dispatch_table_.add<T>((int)msg_type, std::move(callback));
+        }
+        bool remove_callback(DispatchHandle handle) { return dispatch_table_.remove(handle); }
 
         void register_signal_callback(SignalCallback handler);
 
         void run();
         void stop();
 
-        void iteration();
+        // handle at most one journal frame and one message per socket, true if anything was handled.
+        // with wait_micro > 0 it parks on journal writes up to wait_micro if no frame is readable
+        bool iteration(int wait_micro = 0);
 
         int64_t get_nano() const { return scheduler_->get_nano(); };
 
@@ -75,28 +110,25 @@ namespace kungfu
 
         std::vector<std::shared_ptr<nn::socket>> socket_vec_;
         yijinjing::JournalReaderPtr reader_;
+        yijinjing::JournalMergeMode merge_mode_;
 
         std::unique_ptr<TaskScheduler> scheduler_;
 
+        EventLoopWaitMode wait_mode_;
+        int epoll_fd_;
+        size_t epoll_socket_num_;
+
         static volatile std::sig_atomic_t signal_received_;
         vector<SignalCallback> signal_callbacks_;
 
-        QuoteCallback quote_callback_;
-        EntrustCallback entrust_callback_;
-        TransactionCallback transaction_callback_;
-
-        ReqLoginCallback login_callback_;
-        SubscribeCallback sub_callback_;
-        OrderInputCallback order_input_callback_;
-        OrderActionCallback order_action_callback_;
-        OrderCallback order_callback_;
-        TradeCallback trade_callback_;
-
-        AlgoOrderInputCallback algo_order_input_callback_;
-        AlgoOrderStatusCallback algo_order_status_callback_;
-        AlgoOrderActionCallback algo_order_action_callback_;
+        DispatchTable dispatch_table_;
 
         static void signal_handler(int signal);
+
+        bool wait(); // true if anything was handled while waiting
+        int get_wait_micro(int limit_micro) const; // limit_micro or less if a timer is due earlier
+        void epoll_wait_sockets(int timeout_ms);
+        void dump_latency(int64_t nano); // latency probes to log and LATENCY_REPORT_FILE_FORMAT
     };
     DECLARE_PTR(EventLoop)
 }
@@ -0,0 +1,110 @@
+//
+// EventLoop dispatch benchmark.
+// a strategy watching a few symbols of a wide quote feed: the old single callback checking its
+// subscriptions (map of symbol strings, as StrategyUtil::is_subscribed) against a filtered dispatch table.
+// usage: bench_dispatch [symbol_num] [subscribed_num] [tick_num]
+//
+
+#include "event_loop/dispatch_table.h"
+#include "msg.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+#include <cstdio>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define BENCH_SOURCE "xtp"
+
+int main(int argc, char** argv)
+{
+    int symbol_num = (argc > 1) ? atoi(argv[1]) : 4000;
+    int subscribed_num = (argc > 2) ? atoi(argv[2]) : 20;
+    int tick_num = (argc > 3) ? atoi(argv[3]) : 4000000;
+    std::cout << "(symbols) " << symbol_num << " (subscribed) " << subscribed_num << " (ticks) " << tick_num << std::endl;
+
+    std::vector<Quote> quotes(symbol_num);
+    for (int i = 0; i < symbol_num; i++)
+    {
+        Quote& quote = quotes[i];
+        memset(&quote, 0, sizeof(quote));
+        strcpy(quote.source_id, BENCH_SOURCE);
+        sprintf(quote.instrument_id, "%06d", 600000 + i);
+        strcpy(quote.exchange_id, i % 2 == 0 ? "SSE" : "SZE");
+        quote.last_price = 10.0 + i;
+    }
+    int stride = symbol_num / subscribed_num;
+
+    // old: one callback per type, the strategy drops what it did not subscribe
+    std::map<std::string, std::set<std::string>> subscribed;
+    for (int i = 0; i < subscribed_num; i++)
+    {
+        const Quote& quote = quotes[i * stride];
+        subscribed[quote.source_id].insert(std::string(quote.instrument_id) + "." + quote.exchange_id);
+    }
+    long old_handled = 0;
+    std::function<void (const Quote&)> old_callback = [&](const Quote& quote)
+    {
+        if (subscribed.find(quote.source_id) != subscribed.end() &&
+            subscribed.at(quote.source_id).find(std::string(quote.instrument_id) + "." + quote.exchange_id) != subscribed.at(quote.source_id).end())
+        {
+            old_handled++;
+        }
+    };
+    int64_t start = now_nano();
+    for (int i = 0; i < tick_num; i++)
+    {
+        old_callback(quotes[i % symbol_num]);
+    }
+    int64_t old_ns = now_nano() - start;
+    std::cout << "[callback + is_subscribed] (ns per tick) " << (double)old_ns / tick_num << " (handled) " << old_handled << std::endl;
+
+    // new: the filter drops the rest before any handler
+    DispatchFilterPtr filter(new DispatchFilter());
+    for (int i = 0; i < subscribed_num; i++)
+    {
+        const Quote& quote = quotes[i * stride];
+        filter->add_instrument(quote.source_id, quote.instrument_id, quote.exchange_id);
+    }
+    // every symbol on the feed is known to the interner, as after a while of trading
+    for (const auto& quote : quotes)
+    {
+        SymbolInterner::get_interner().intern(quote.instrument_id, quote.exchange_id);
+    }
+    DispatchTable table;
+    long new_handled = 0;
+    table.add<Quote>((int)MsgType::Quote, [&](const Quote& quote) { new_handled++; }, filter);
+    start = now_nano();
+    for (int i = 0; i < tick_num; i++)
+    {
+        table.dispatch((int)MsgType::Quote, &quotes[i % symbol_num]);
+    }
+    int64_t new_ns = now_nano() - start;
+    std::cout << "[dispatch table + filter ] (ns per tick) " << (double)new_ns / tick_num << " (handled) " << new_handled << std::endl;
+    bool ok = new_handled == old_handled;
+
+    // several handlers, one removing itself while dispatched
+    long second_handled = 0;
+    long once_handled = 0;
+    DispatchHandle once;
+    table.add<Quote>((int)MsgType::Quote, [&](const Quote& quote) { second_handled++; });
+    once = table.add<Quote>((int)MsgType::Quote, [&](const Quote& quote) { once_handled++; table.remove(once); });
+    new_handled = 0;
+    for (int i = 0; i < symbol_num; i++)
+    {
+        table.dispatch((int)MsgType::Quote, &quotes[i]);
+    }
+
+    ok = ok && new_handled == subscribed_num && second_handled == symbol_num && once_handled == 1
+         && !table.has_handler((int)MsgType::Entrust);
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
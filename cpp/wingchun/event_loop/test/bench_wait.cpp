@@ -0,0 +1,133 @@
+//
+// EventLoop wait strategy benchmark.
+// a forked writer publishes timestamped journal frames at a fixed interval, the reader idles the way
+// EventLoop::run does in each wait mode and reports wake-up latency and the cpu it burns while idle.
+// both sides ring a doorbell in shared memory, as paged clients do through the comm file.
+// usage: bench_wait [frame_num] [interval_micro]
+//
+
+#include "event_loop/event_loop.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "PageCommStruct.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace kungfu;
+
+#define BENCH_JOURNAL_DIR "/tmp/bench_wait_journal"
+#define BENCH_MSG_TYPE 9999
+
+inline int64_t cpu_nano()
+{
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000L + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000L;
+}
+
+void run_writer(const std::string& jname, yijinjing::PageCommDoorbell* bell, int frame_num, int interval_micro)
+{
+    yijinjing::PageProviderPtr provider(new yijinjing::LocalPageProvider(true));
+    yijinjing::JournalWriterPtr writer = yijinjing::JournalWriter::create(BENCH_JOURNAL_DIR, jname, provider);
+    writer->setDoorbell(bell);
+    // let the reader settle into its idle state first
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (int i = 0; i < frame_num; i++)
+    {
+        int64_t seq = i;
+        writer->write_frame(&seq, sizeof(seq), 0, BENCH_MSG_TYPE, true, i);
+        std::this_thread::sleep_for(std::chrono::microseconds(interval_micro));
+    }
+}
+
+void run_reader(const char* mode_name, EventLoopWaitMode mode, bool use_doorbell, int frame_num, int interval_micro)
+{
+    std::string jname = std::string("bench_wait_") + mode_name;
+    auto* bell = (yijinjing::PageCommDoorbell*)mmap(nullptr, sizeof(yijinjing::PageCommDoorbell), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    memset(bell, 0, sizeof(yijinjing::PageCommDoorbell));
+
+    {
+        // the reader only picks up journal pages that exist when it starts
+        yijinjing::PageProviderPtr provider(new yijinjing::LocalPageProvider(true));
+        yijinjing::JournalWriter::create(BENCH_JOURNAL_DIR, jname, provider);
+    }
+    int64_t start_nano = yijinjing::getNanoTime();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        run_writer(jname, bell, frame_num, interval_micro);
+        _exit(0);
+    }
+
+    yijinjing::PageProviderPtr provider(new yijinjing::LocalPageProvider(false));
+    yijinjing::JournalReaderPtr reader = yijinjing::JournalReader::create({BENCH_JOURNAL_DIR}, {jname}, start_nano, provider);
+    if (use_doorbell)
+    {
+        reader->setDoorbell(bell);
+    }
+
+    std::vector<int64_t> latency;
+    latency.reserve(frame_num);
+    int64_t cpu_start = cpu_nano();
+    int64_t wall_start = yijinjing::getNanoTime();
+    yijinjing::Frame frame(nullptr);
+    int idle = 0;
+    while ((int)latency.size() < frame_num)
+    {
+        bool got = reader->getNextFrame(frame);
+        if (!got && mode != EventLoopWaitMode::BusySpin && ++idle >= EVENT_LOOP_SPIN_BEFORE_WAIT)
+        {
+            if (mode == EventLoopWaitMode::SpinYield)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                got = reader->waitNextFrame(frame, EVENT_LOOP_PARK_TIMEOUT_MICROSEC);
+            }
+        }
+        if (got)
+        {
+            idle = 0;
+            if (frame.getMsgType() == BENCH_MSG_TYPE)
+            {
+                latency.push_back(yijinjing::getNanoTime() - frame.getNano());
+            }
+        }
+    }
+    int64_t wall = yijinjing::getNanoTime() - wall_start;
+    int64_t cpu = cpu_nano() - cpu_start;
+    waitpid(pid, nullptr, 0);
+    munmap(bell, sizeof(yijinjing::PageCommDoorbell));
+
+    std::sort(latency.begin(), latency.end());
+    std::cout << "[" << mode_name << "]"
+              << " (p50 us) " << latency[latency.size() / 2] / 1000.0
+              << " (p99 us) " << latency[latency.size() * 99 / 100] / 1000.0
+              << " (max us) " << latency.back() / 1000.0
+              << " (reader cpu %) " << 100.0 * cpu / wall << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int frame_num = (argc > 1) ? atoi(argv[1]) : 2000;
+    int interval_micro = (argc > 2) ? atoi(argv[2]) : 500;
+    std::cout << "(frames) " << frame_num << " (interval us) " << interval_micro
+              << " (cpus) " << std::thread::hardware_concurrency() << std::endl;
+    system("rm -rf " BENCH_JOURNAL_DIR " && mkdir -p " BENCH_JOURNAL_DIR);
+
+    run_reader("spin", EventLoopWaitMode::BusySpin, false, frame_num, interval_micro);
+    run_reader("yield", EventLoopWaitMode::SpinYield, false, frame_num, interval_micro);
+    run_reader("park", EventLoopWaitMode::SpinPark, true, frame_num, interval_micro);
+    // what SpinPark does on a reader without doorbell (local page provider)
+    run_reader("park_no_doorbell", EventLoopWaitMode::SpinPark, false, frame_num, interval_micro);
+    return 0;
+}
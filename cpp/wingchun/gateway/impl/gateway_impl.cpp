@@ -10,6 +10,7 @@
 #include "util/include/env.h"
 #include "util/include/filesystem_util.h"
 #include "util/include/timer_util.h"
+#include "util/include/latency_probe.h"
 #include "gateway/include/util.hpp"
 
 #include <cstring>
@@ -48,6 +49,7 @@ namespace kungfu
         calendar_ = CalendarPtr(new Calendar());
 
         loop_ = std::shared_ptr<EventLoop>(new EventLoop(get_name()));
+        loop_->set_wait_mode(GATEWAY_EVENT_LOOP_WAIT);
 
         if (!create_folder_if_not_exists(GATEWAY_FOLDER(this->get_name())))
         {
@@ -77,7 +79,7 @@ namespace kungfu
         state_storage_ =  std::shared_ptr<GatewayStateStorage>(new GatewayStateStorage(state_db_file));
 
         std::string url = GATEWAY_PUB_URL(name_);
-        nn_publisher_ = std::unique_ptr<NNPublisher>(new NNPublisher(url));
+        nn_publisher_ = std::unique_ptr<NNPublisher>(new NNPublisher(url, GATEWAY_PUB_ENCODING));
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
@@ -117,7 +119,7 @@ namespace kungfu
         GatewayImpl::init();
 
         std::string journal_folder = MD_JOURNAL_FOLDER(get_source());
-        kungfu::yijinjing::JournalWriterPtr writer = kungfu::yijinjing::JournalWriter::create(journal_folder, MD_JOURNAL_NAME(get_source()), this->get_name());
+        kungfu::yijinjing::JournalWriterPtr writer = kungfu::yijinjing::JournalWriter::create(journal_folder, MD_JOURNAL_NAME(get_source()), this->get_name(), MD_JOURNAL_PAGE_SIZE);
         std::shared_ptr<kungfu::MarketDataStreamingWriter> feed_handler = std::shared_ptr<kungfu::MarketDataStreamingWriter>(new kungfu::MarketDataStreamingWriter(writer));
         register_feed_handler(feed_handler);
 
@@ -169,6 +171,64 @@ namespace kungfu
         feed_handler_->on_transaction(&transaction);
     }
 
+    Quote* MdGatewayImpl::reserve_quote()
+    {
+        Quote* quote = feed_handler_->reserve_quote();
+        if (quote == nullptr)
+            quote = &quote_buffer_;
+        memset(quote, 0, sizeof(Quote));
+        return quote;
+    }
+
+    Entrust* MdGatewayImpl::reserve_entrust()
+    {
+        Entrust* entrust = feed_handler_->reserve_entrust();
+        if (entrust == nullptr)
+            entrust = &entrust_buffer_;
+        memset(entrust, 0, sizeof(Entrust));
+        return entrust;
+    }
+
+    Transaction* MdGatewayImpl::reserve_transaction()
+    {
+        Transaction* transaction = feed_handler_->reserve_transaction();
+        if (transaction == nullptr)
+            transaction = &transaction_buffer_;
+        memset(transaction, 0, sizeof(Transaction));
+        return transaction;
+    }
+
+    void MdGatewayImpl::commit_quote(Quote* quote)
+    {
+        QUOTE_TRACE(kungfu::to_string(*quote));
+        if (quote == &quote_buffer_)
+            feed_handler_->on_quote(quote);
+        else
+            feed_handler_->commit();
+        if (quote->rcv_time > 0)
+        {
+            LATENCY_PROBE("md.rcv_to_journal", yijinjing::getNanoTime() - quote->rcv_time);
+        }
+    }
+
+    void MdGatewayImpl::commit_entrust(Entrust* entrust)
+    {
+        ENTRUST_TRACE(kungfu::to_string(*entrust));
+        if (entrust == &entrust_buffer_)
+            feed_handler_->on_entrust(entrust);
+        else
+            feed_handler_->commit();
+    }
+
+    void MdGatewayImpl::commit_transaction(Transaction* transaction)
+    {
+        TRANSACTION_TRACE(kungfu::to_string(*transaction));
+        if (transaction == &transaction_buffer_)
+            feed_handler_->on_transaction(transaction);
+        else
+            feed_handler_->commit();
+    }
+
     void MdGatewayImpl::on_subscribe(const std::string &recipient, const std::vector<Instrument> &instruments, bool is_level2 = false)
     {
         SPDLOG_TRACE("(recipient) {} (size) {} (is_level2) {}", recipient, instruments.size(), is_level2);
@@ -206,9 +266,11 @@ namespace kungfu
 
         init_account_manager();
 
+        // strategy journals are added on each login, keep per-frame cost independent of their number
+        loop_->set_journal_merge_mode(kungfu::yijinjing::MERGE_MIN_HEAP);
         loop_->subscribe_yjj_journal(MD_JOURNAL_FOLDER(get_source()), MD_JOURNAL_NAME(get_source()), kungfu::yijinjing::getNanoTime());
         std::string journal_folder = TD_JOURNAL_FOLDER(get_source(), get_account_id());
-        kungfu::yijinjing::JournalWriterPtr writer = kungfu::yijinjing::JournalWriter::create(journal_folder, TD_JOURNAL_NAME(get_source(), get_account_id()), this->get_name());
+        kungfu::yijinjing::JournalWriterPtr writer = kungfu::yijinjing::JournalWriter::create(journal_folder, TD_JOURNAL_NAME(get_source(), get_account_id()), this->get_name(), TD_JOURNAL_PAGE_SIZE);
         std::shared_ptr<kungfu::TraderDataFeedHandler> feed_handler = std::shared_ptr<kungfu::TraderDataFeedHandler>(new kungfu::TraderDataStreamingWriter(writer));
         register_feed_handler(feed_handler);
 
@@ -220,6 +282,7 @@ namespace kungfu
 
         loop_->register_nanotime_callback(nseconds_next_min(yijinjing::getNanoTime()), std::bind(&TdGatewayImpl::on_1min_timer, this, std::placeholders::_1));
         loop_->register_nanotime_callback(nseconds_next_day(yijinjing::getNanoTime()), std::bind(&TdGatewayImpl::on_daily_timer, this, std::placeholders::_1));
+        loop_->register_nanotime_interval_callback(PNL_SAVE_INTERVAL_NANO, std::bind(&TdGatewayImpl::on_pnl_save_timer, this, std::placeholders::_1));
         loop_->register_req_login_callback(std::bind(&TdGatewayImpl::on_login, this, std::placeholders::_1, std::placeholders::_2));
         loop_->register_order_input_callback(std::bind(&TdGatewayImpl::on_order_input, this, std::placeholders::_1));
         loop_->register_order_action_callback(std::bind(&TdGatewayImpl::on_order_action, this, std::placeholders::_1));
@@ -251,15 +314,15 @@ namespace kungfu
             folders.push_back(MD_JOURNAL_FOLDER(get_source()));
             names.emplace_back(MD_JOURNAL_NAME(get_source()));
             kungfu::yijinjing::JournalReaderPtr reader = kungfu::yijinjing::JournalReader::create(folders, names, last_update);
-            kungfu::yijinjing::FramePtr frame = reader->getNextFrame();
-            while (frame != nullptr)
+            kungfu::yijinjing::Frame frame(nullptr);
+            while (reader->getNextFrame(frame))
             {
-                int msg_type = frame->getMsgType();
+                int msg_type = frame.getMsgType();
                 switch (msg_type)
                 {
                     case (int) MsgType::Quote:
                     {
-                        auto quote = (const Quote*) frame->getData();
+                        auto quote = (const Quote*) frame.getData();
                         if (quote->rcv_time > last_update)
                         {
                             account_manager_->on_quote(quote);
@@ -268,7 +331,7 @@ namespace kungfu
                     }
                     case (int) MsgType::Order:
                     {
-                        auto order = (const Order*) frame->getData();
+                        auto order = (const Order*) frame.getData();
                         if (order->rcv_time > last_update)
                         {
                             account_manager_->on_order(order);
@@ -277,7 +340,7 @@ namespace kungfu
                     }
                     case (int) MsgType::Trade:
                     {
-                        auto trade = (const Trade*) frame->getData();
+                        auto trade = (const Trade*) frame.getData();
                         if (trade->rcv_time > last_update)
                         {
                             account_manager_->on_trade(trade);
@@ -286,7 +349,7 @@ namespace kungfu
                     }
                     case (int) MsgType::AccountInfo:
                     {
-                        auto account = (const AccountInfo*)frame->getData();
+                        auto account = (const AccountInfo*)frame.getData();
                         if (account->rcv_time > last_update)
                         {
                             account_manager_->on_account(*account);
@@ -298,7 +361,6 @@ namespace kungfu
                         break;
                     }
                 }
-                frame = reader->getNextFrame();
             }
             SPDLOG_INFO("forward account manager from {}|{} to {}|{}", last_update, kungfu::yijinjing::parseNano(last_update, "%Y%m%d-%H:%M:%S"), account_manager_->get_last_update(), kungfu::yijinjing::parseNano(account_manager_->get_last_update(), "%Y%m%d-%H:%M:%S"));
         }
@@ -359,10 +421,29 @@ namespace kungfu
     {
         if (order_input.account_id == this->get_account_id())
         {
+            int64_t start_nano = LatencyRegistry::get().enabled() ? yijinjing::getNanoTime() : 0;
             insert_order(order_input);
+            if (start_nano > 0)
+            {
+                int64_t end_nano = yijinjing::getNanoTime();
+                LATENCY_PROBE("td.insert_order", end_nano - start_nano);
+                if (latency_origin_nano() > 0)
+                {
+                    LATENCY_PROBE("td.md_to_insert_order", end_nano - latency_origin_nano());
+                }
+            }
         }
     }
 
+    void TdGatewayImpl::start()
+    {
+        GatewayImpl::start();
+        // loop exited (stop or signal), orders and trades still queued must reach the db before exit
+        order_storage_->flush();
+        trade_storage_->flush();
+        account_manager_->flush();
+    }
+
     void TdGatewayImpl::on_order_action(const OrderAction &order_action)
     {
         cancel_order(order_action);
@@ -432,6 +513,12 @@ namespace kungfu
         auto account_info = account_manager_->get_account_info();
         bool is_open = calendar_->is_open(nano, account_info.type == AccountTypeFuture ? EXCHANGE_SHFE : EXCHANGE_SSE);
         TIMER_TRACE(fmt::format("[on_1min_timer] (nano) {} (is_open) {}", nano, is_open));
+        for (const auto& stats: {std::make_pair("orders", order_storage_->get_stats()), std::make_pair("trade", trade_storage_->get_stats())})
+        {
+            TIMER_TRACE(fmt::format("[on_1min_timer] (storage) {} (queue) {} (max queue) {} (full waits) {} (batches) {} (failed) {} (last commit ns) {} (max commit ns) {}",
+                                    stats.first, stats.second.queue_depth, stats.second.max_queue_depth, stats.second.full_waits, stats.second.batches,
+                                    stats.second.failed, stats.second.last_commit_ns, stats.second.max_commit_ns));
+        }
         if (is_open)
         {
             account_info.update_time = (int64_t)std::round((double)yijinjing::getNanoTime() / 1000000000) * 1000000000;
@@ -451,6 +538,12 @@ namespace kungfu
         loop_->register_nanotime_callback_at_next(DAILY_STORAGE_TIME, std::bind(&TdGatewayImpl::on_daily_timer, this, std::placeholders::_1));
     }
 
+    void TdGatewayImpl::on_pnl_save_timer(long nano)
+    {
+        // positions / account saves held back by fills are written at the latest one interval later
+        account_manager_->on_timer(nano);
+    }
+
     void TdGatewayImpl::on_switch_day(const std::string &trading_day)
     {
         if (nullptr != account_manager_)
@@ -43,6 +43,24 @@ namespace kungfu
             writer_->write_frame(transaction, sizeof(Transaction), -1, (int)MsgType::Transaction, true, -1);
         }
 
+        // build structs directly in journal page, published together by commit
+        Quote* reserve_quote() override
+        {
+            return (Quote*)writer_->reserve(sizeof(Quote), -1, (int)MsgType::Quote, true, -1);
+        }
+        Entrust* reserve_entrust() override
+        {
+            return (Entrust*)writer_->reserve(sizeof(Entrust), -1, (int)MsgType::Entrust, true, -1);
+        }
+        Transaction* reserve_transaction() override
+        {
+            return (Transaction*)writer_->reserve(sizeof(Transaction), -1, (int)MsgType::Transaction, true, -1);
+        }
+        void commit() override
+        {
+            writer_->commit();
+        }
+
     private:
         kungfu::yijinjing::JournalWriterPtr writer_;
     };
@@ -120,11 +138,25 @@ namespace kungfu
         void on_quote(const Quote& quote);
         void on_entrust(const Entrust& entrust);
         void on_transaction(const Transaction& transaction);
+
+        // zero copy path: fill the returned struct (zeroed) in place, then publish it by commit_*,
+        // falls back to a local buffer if the feed handler has no writable slot
+        Quote* reserve_quote();
+        Entrust* reserve_entrust();
+        Transaction* reserve_transaction();
+        void commit_quote(Quote* quote);
+        void commit_entrust(Entrust* entrust);
+        void commit_transaction(Transaction* transaction);
+
         void on_subscribe(const std::string &recipient, const std::vector<Instrument> &instruments, bool is_level2);
 
     private:
         std::shared_ptr<SubscriptionStorage> subscription_storage_;
         std::shared_ptr<MarketDataFeedHandler> feed_handler_;
+
+        Quote quote_buffer_;
+        Entrust entrust_buffer_;
+        Transaction transaction_buffer_;
     };
 
     class TdGatewayImpl: virtual public TdGateway, public GatewayImpl
@@ -134,6 +166,7 @@ namespace kungfu
         virtual ~TdGatewayImpl() {}
 
         virtual void init() override;
+        virtual void start() override;
         virtual void on_started() override;
         virtual void on_login(const std::string& recipient, const std::string& client_id) override;
 
@@ -167,6 +200,7 @@ namespace kungfu
         void on_quote(const Quote& quote);
         void on_1min_timer(long nano);
         void on_daily_timer(long nano);
+        void on_pnl_save_timer(long nano);
         void on_switch_day(const std::string& trading_day);
 
     private:
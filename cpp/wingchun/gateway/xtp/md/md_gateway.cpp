@@ -179,10 +179,10 @@ namespace kungfu
                                           int32_t max_ask1_count)
         {
             QUOTE_TRACE(to_string(*market_data));
-            Quote quote = {};
-            from_xtp(*market_data, quote);
-            quote.rcv_time = kungfu::yijinjing::getNanoTime();
-            on_quote(quote);
+            Quote* quote = reserve_quote();
+            from_xtp(*market_data, *quote);
+            quote->rcv_time = kungfu::yijinjing::getNanoTime();
+            commit_quote(quote);
         }
 
         void MdGateway::OnTickByTick(XTPTBT *tbt_data)
@@ -190,18 +190,18 @@ namespace kungfu
             if (tbt_data->type == XTP_TBT_ENTRUST)
             {
                 ENTRUST_TRACE(to_string(*tbt_data));
-                Entrust entrust = {};
-                from_xtp(*tbt_data, entrust);
-                entrust.rcv_time = kungfu::yijinjing::getNanoTime();
-                on_entrust(entrust);
+                Entrust* entrust = reserve_entrust();
+                from_xtp(*tbt_data, *entrust);
+                entrust->rcv_time = kungfu::yijinjing::getNanoTime();
+                commit_entrust(entrust);
             }
             else if (tbt_data->type == XTP_TBT_TRADE)
             {
                 TRANSACTION_TRACE(to_string(*tbt_data));
-                Transaction transaction = {};
-                from_xtp(*tbt_data, transaction);
-                transaction.rcv_time = kungfu::yijinjing::getNanoTime();
-                on_transaction(transaction);
+                Transaction* transaction = reserve_transaction();
+                from_xtp(*tbt_data, *transaction);
+                transaction->rcv_time = kungfu::yijinjing::getNanoTime();
+                commit_transaction(transaction);
             }
         }
     }
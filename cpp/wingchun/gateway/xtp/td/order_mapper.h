@@ -6,8 +6,13 @@
 #define WC_2_ORDER_MAPPER_H
 
 #include <string>
+#include <memory>
+#include <mutex>
+#include <cstring>
+#include <unordered_map>
 #include <spdlog/spdlog.h>
 #include <SQLiteCpp/SQLiteCpp.h>
+#include "storage/write_behind.h"
 
 namespace kungfu
 {
@@ -23,12 +28,18 @@ namespace kungfu
             char client_id[50];
         };
 
+        // xtp order ids of the orders inserted by the gateway, kept in memory and warmed from the db at start.
+        // new orders are persisted by a write behind thread, lookups never touch the db.
+        // add_order is called on the gateway event loop, lookups also on xtp callback threads.
         class OrderMapper
         {
         public:
             OrderMapper(const std::string &file_name) : db_(file_name.c_str(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
             {
                 create_table_if_not_exist();
+                load_orders();
+                writer_ = std::unique_ptr<storage::WriteBehindQueue<XtpOrder>>(new storage::WriteBehindQueue<XtpOrder>(db_,
+                        "INSERT INTO xtp_order VALUES(?, ?, ?, ?, ?, ?)", bind_order, "xtp_order"));
             }
 
             void create_table_if_not_exist()
@@ -46,108 +57,124 @@ namespace kungfu
 
             void add_order(const XtpOrder& order)
             {
-                try
-                {
-                    SQLite::Statement insert(db_, "INSERT INTO xtp_order VALUES(?, ?, ?, ?, ?, ?)");
-                    insert.bind(1, (long long) order.internal_order_id);
-                    insert.bind(2, (long long) order.xtp_order_id);
-                    insert.bind(3, (long long) order.parent_id);
-                    insert.bind(4, order.insert_time);
-                    insert.bind(5, order.trading_day);
-                    insert.bind(6, order.client_id);
-                    insert.exec();
-                }
-                catch (std::exception &e)
                 {
-                    SPDLOG_TRACE(e.what());
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (!index_order(order))
+                    {
+                        return;
+                    }
                 }
+                writer_->push(order);
             }
-            
+
             const XtpOrder get_order_by_xtp_order_id(const char* trading_day, const uint64_t xtp_order_id)
             {
-                XtpOrder order = {};
-                try 
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto day_iter = orders_.find(trading_day);
+                if (day_iter != orders_.end())
                 {
-                    SQLite::Statement query(db_, "SELECT * FROM xtp_order WHERE xtp_order_id = ? AND trading_day = ?");
-                    query.bind(1, (long long )xtp_order_id);
-                    query.bind(2, trading_day);
-                    if (query.executeStep())
+                    auto iter = day_iter->second.find(xtp_order_id);
+                    if (iter != day_iter->second.end())
                     {
-                        order.internal_order_id = (long long)(query.getColumn(0));
-                        order.xtp_order_id = xtp_order_id;
-                        order.parent_id = (long long)(query.getColumn(2));
-                        order.insert_time = (long long)(query.getColumn(3));
-                        strcpy(order.trading_day, query.getColumn(4));
-                        strcpy(order.client_id, query.getColumn(5));
+                        return iter->second;
                     }
                 }
-                catch (std::exception &e)
-                {
-                    SPDLOG_TRACE(e.what());
-                }
+                XtpOrder order = {};
                 return order;
             }
-            
+
             const uint64_t get_xtp_order_id(const uint64_t internal_order_id)
             {
-                uint64_t xtp_order_id = 0;
-                try
-                {
-                    SQLite::Statement query(db_, "SELECT xtp_order_id FROM xtp_order WHERE internal_order_id = ?");
-                    query.bind(1, (long long)internal_order_id);
-                    if (query.executeStep())
-                    {
-                       xtp_order_id = (long long)(query.getColumn(0));
-                    }
-                }
-                catch (std::exception &e)
-                {
-                    SPDLOG_TRACE(e.what());
-                }
-                return xtp_order_id;
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto iter = xtp_order_ids_.find(internal_order_id);
+                return iter == xtp_order_ids_.end() ? 0 : iter->second;
             }
 
             const uint64_t get_internal_order_id(const char* trading_day, const uint64_t xtp_order_id)
             {
+                return get_order_by_xtp_order_id(trading_day, xtp_order_id).internal_order_id;
+            }
+
+            // latest order of any trading day with xtp_order_id
+            const uint64_t get_internal_order_id(const uint64_t xtp_order_id)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
                 uint64_t internal_order_id = 0;
-                try
+                for (const auto& day : orders_)
                 {
-                    SQLite::Statement query(db_, "SELECT internal_order_id FROM xtp_order WHERE xtp_order_id = ? AND trading_day = ?");
-                    query.bind(1, (long long )xtp_order_id);
-                    query.bind(2, trading_day);
-                    if (query.executeStep())
+                    auto iter = day.second.find(xtp_order_id);
+                    if (iter != day.second.end() && iter->second.internal_order_id > internal_order_id)
                     {
-                        internal_order_id = (long long)(query.getColumn(0));
+                        internal_order_id = iter->second.internal_order_id;
                     }
                 }
-                catch (std::exception &e)
-                {
-                    SPDLOG_TRACE(e.what());
-                }
                 return internal_order_id;
             }
 
-            const uint64_t get_internal_order_id(const uint64_t xtp_order_id)
+            // block until added orders are in the db
+            void flush()
+            {
+                writer_->flush();
+            }
+
+            storage::WriteBehindStats get_stats() const
+            {
+                return writer_->get_stats();
+            }
+
+        private:
+            static void bind_order(SQLite::Statement& insert, const XtpOrder& order)
+            {
+                insert.bind(1, (long long) order.internal_order_id);
+                insert.bind(2, (long long) order.xtp_order_id);
+                insert.bind(3, (long long) order.parent_id);
+                insert.bind(4, order.insert_time);
+                insert.bind(5, order.trading_day);
+                insert.bind(6, order.client_id);
+            }
+
+            void load_orders()
             {
-                uint64_t internal_order_id = 0;
                 try
                 {
-                    SQLite::Statement query(db_, "SELECT internal_order_id FROM xtp_order WHERE xtp_order_id = ? ORDER BY internal_order_id desc");
-                    query.bind(1, (long long )xtp_order_id);
-                    if (query.executeStep())
+                    SQLite::Statement query(db_, "SELECT * FROM xtp_order");
+                    while (query.executeStep())
                     {
-                        internal_order_id = (long long)(query.getColumn(0));
+                        XtpOrder order = {};
+                        order.internal_order_id = (long long)(query.getColumn(0));
+                        order.xtp_order_id = (long long)(query.getColumn(1));
+                        order.parent_id = (long long)(query.getColumn(2));
+                        order.insert_time = (long long)(query.getColumn(3));
+                        strncpy(order.trading_day, query.getColumn(4), sizeof(order.trading_day) - 1);
+                        strncpy(order.client_id, query.getColumn(5), sizeof(order.client_id) - 1);
+                        index_order(order);
                     }
+                    SPDLOG_INFO("{} xtp orders loaded", xtp_order_ids_.size());
                 }
                 catch (std::exception &e)
                 {
-                    SPDLOG_TRACE(e.what());
+                    SPDLOG_ERROR("failed to load xtp orders, exception: {}", e.what());
                 }
-                return internal_order_id;
             }
 
-        private:
+            // false if internal_order_id is already mapped, the db keeps the first one
+            bool index_order(const XtpOrder& order)
+            {
+                if (!xtp_order_ids_.emplace(order.internal_order_id, order.xtp_order_id).second)
+                {
+                    SPDLOG_ERROR("duplicated internal_order_id {}, xtp_order_id {} ignored", order.internal_order_id, order.xtp_order_id);
+                    return false;
+                }
+                orders_[order.trading_day][order.xtp_order_id] = order;
+                return true;
+            }
+
             SQLite::Database db_;
+            std::unique_ptr<storage::WriteBehindQueue<XtpOrder>> writer_; // destroyed first, drains into db_
+
+            std::mutex mutex_;
+            std::unordered_map<uint64_t, uint64_t> xtp_order_ids_; // internal_order_id -> xtp_order_id
+            std::unordered_map<std::string, std::unordered_map<uint64_t, XtpOrder>> orders_; // trading_day -> xtp_order_id -> order
         };
     }
 }
@@ -40,7 +40,7 @@ namespace kungfu
         {
             login();
 
-            GatewayImpl::start();
+            TdGatewayImpl::start();
         }
 
         bool TdGateway::login()
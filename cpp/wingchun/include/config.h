@@ -21,9 +21,23 @@ namespace kungfu
 
 // calendar configuration
 #define CALENDAR_HOLIDAY_DB_FILE_FORMAT "{}/global/holidays.db"
+// trading sessions of these years are indexed by Calendar at startup, others are computed per call
+#define CALENDAR_SESSION_FROM_YEAR 2000
+#define CALENDAR_SESSION_TO_YEAR 2040
+
 #define CALENDAR_REP_URL "ipc://{}/calendar/rep.ipc"
 #define CALENDAR_PUB_URL "ipc://{}/calendar/pub.ipc"
 
+// oms configuration
+// finished orders an OrderManager keeps for get_order, the oldest are dropped beyond
+#define OMS_ORDER_ARCHIVE_CAPACITY 65536
+// order objects per slab of the oms order pools
+#define OMS_ORDER_POOL_SLAB_SIZE 1024
+
+// latency probes, see util/include/latency_probe.h
+#define LATENCY_REPORT_FILE_FORMAT "{}/latency/{}.log"
+#define LATENCY_REPORT_INTERVAL_SEC 60 // event loops dump their probes this often when KF_LATENCY_PROBE is set
+
 // gateway configuration
 
 #define MD_GATEWAY_NAME_FORMAT "md_{}"
@@ -46,6 +60,12 @@ namespace kungfu
 #define GATEWAY_PUB_URL(name) fmt::format(GATEWAY_PUB_URL_FORMAT, get_base_dir(), name)
 #define GATEWAY_REP_URL(name) fmt::format(GATEWAY_REP_URL_FORMAT, get_base_dir(), name)
 
+// encoding of gateway/strategy pub messages, see nn_publisher/nn_codec.h
+// chosen at compile time, there is no negotiation with subscribers: json subscribers (app, python)
+// subscribe with '{' prefix so they skip binary frames under Both, Binary drops json dump from event loop
+#define GATEWAY_PUB_ENCODING kungfu::NNEncoding::Json
+#define STRATEGY_PUB_ENCODING kungfu::NNEncoding::Json
+
 // journal related configuration
 #define STRATEGY_JOURNAL_FOLDER_FORMAT "{}/journal/strategy/"
 #define MD_JOURNAL_FOLDER_FORMAT "{}/journal/md/{}"
@@ -58,6 +78,11 @@ namespace kungfu
 #define MD_JOURNAL_FOLDER(source) fmt::format(MD_JOURNAL_FOLDER_FORMAT, get_base_dir(), source)
 #define TD_JOURNAL_FOLDER(source, account_id) fmt::format(TD_JOURNAL_FOLDER_FORMAT, get_base_dir(), source, account_id)
 
+// md journals roll pages all day long, strategy journals only carry order flow
+#define MD_JOURNAL_PAGE_SIZE (512 * kungfu::yijinjing::MB)
+#define TD_JOURNAL_PAGE_SIZE kungfu::yijinjing::JOURNAL_PAGE_SIZE
+#define STRATEGY_JOURNAL_PAGE_SIZE (16 * kungfu::yijinjing::MB)
+
 // commission configuration
 #define COMMISSION_DEFAULT_DB_FILE fmt::format("{}/global/commission.db", get_base_dir())
 #define COMMISSION_DB_FILE_FORMAT "{}/accounts/{}/commission.db"
@@ -128,6 +153,10 @@ namespace kungfu
 
 #define DAILY_STORAGE_TIME "15:30:00"
 
+// EventLoop::run idle behaviour, KF_EVENT_LOOP_WAIT=spin/yield/park/epoll overrides per process
+#define GATEWAY_EVENT_LOOP_WAIT kungfu::EventLoopWaitMode::BusySpin
+#define STRATEGY_EVENT_LOOP_WAIT kungfu::EventLoopWaitMode::SpinPark
+
 #define ACCOUNT_ONE_MIN_SNAPSHOT_TABLE_NAME "trading_account_1m_snapshots"
 #define ACCOUNT_ONE_DAY_SNAPSHOT_TABLE_NAME "trading_account_1d_snapshots"
 
@@ -30,6 +30,7 @@ namespace kungfu
     const int SOURCE_ID_LEN = 16;
     const int BROKER_ID_LEN = 32;
     const int ERROR_MSG_LEN = 32;
+    const int ALGO_TYPE_LEN = 32;
 
     typedef char InstrumentType;
     const InstrumentType InstrumentTypeUnknown = '0';
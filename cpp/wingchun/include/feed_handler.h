@@ -16,6 +16,13 @@ namespace kungfu
         virtual void on_quote(const Quote* quote) {};
         virtual void on_entrust(const Entrust* entrust) {};
         virtual void on_transaction(const Transaction* transaction) {}
+
+        // writable slots for gateways to build data in place, nullptr if not supported,
+        // reserved data is published by commit
+        virtual Quote* reserve_quote() { return nullptr; }
+        virtual Entrust* reserve_entrust() { return nullptr; }
+        virtual Transaction* reserve_transaction() { return nullptr; }
+        virtual void commit() {}
     };
 
     class TraderDataFeedHandler
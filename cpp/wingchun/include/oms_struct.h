@@ -276,13 +276,16 @@ namespace kungfu
         std::vector<PositionDiff> position_diffs;       //修改持仓
     };
 
+    //算法订单消息为定长头部, 后接var_length字节以'\0'结尾的变长参数(订单输入/操作/状态信息),
+    //在journal中原地读取, 见get_algo_msg_var
+
     //算法订单输入
     struct AlgoOrderInput
     {
         uint64_t order_id;                              //订单ID
-        std::string client_id;                          //Client ID
-        std::string algo_type;                          //算法订单类型
-        std::string input;                              //订单输入信息
+        char client_id[CLIENT_ID_LEN];                  //Client ID
+        char algo_type[ALGO_TYPE_LEN];                  //算法订单类型
+        uint32_t var_length;                            //订单输入信息长度, 含'\0'
     };
 
     //算法订单操作
@@ -290,16 +293,42 @@ namespace kungfu
     {
         uint64_t order_id;                              //订单ID
         uint64_t order_action_id;                       //订单操作ID
-        std::string action;                             //订单操作信息
+        uint32_t var_length;                            //订单操作信息长度, 含'\0'
     };
 
+    //算法订单状态
     struct AlgoOrderStatus
     {
-        uint64_t order_id;
-        std::string algo_type;
-        std::string status;
+        uint64_t order_id;                              //订单ID
+        char algo_type[ALGO_TYPE_LEN];                  //算法订单类型
+        uint32_t var_length;                            //订单状态信息长度, 含'\0'
     };
 
+    //变长参数, 紧跟在头部之后
+    template <typename T> inline const char* get_algo_msg_var(const T& msg)
+    {
+        return (const char*)(&msg + 1);
+    }
+
+    template <typename T> inline char* get_algo_msg_var(T& msg)
+    {
+        return (char*)(&msg + 1);
+    }
+
+    //头部加变长参数的总长度
+    template <typename T> inline size_t get_algo_msg_length(const T& msg)
+    {
+        return sizeof(T) + msg.var_length;
+    }
+
+    //data_length字节的data是否为完整的算法订单消息
+    template <typename T> inline bool is_algo_msg_valid(const void* data, size_t data_length)
+    {
+        const T* msg = (const T*)data;
+        return data_length >= sizeof(T) && msg->var_length > 0 && data_length >= get_algo_msg_length(*msg)
+               && get_algo_msg_var(*msg)[msg->var_length - 1] == '\0';
+    }
+
     //交易Session
     struct TradingSession
     {
@@ -416,48 +416,27 @@ namespace kungfu
         j["sender"] = rsp.sender;
     }
 
+    // algo order messages have to be followed by their variable part, as in journal
     inline void to_json(nlohmann::json& j, const AlgoOrderInput& input)
     {
         j["order_id"] = input.order_id;
-        j["client_id"] = input.client_id;
-        j["algo_type"] = input.algo_type;
-        j["input"] = input.input;
-    }
-
-    inline void from_json(const nlohmann::json& j, AlgoOrderInput& input)
-    {
-        input.order_id = j["order_id"];
-        input.client_id = j["client_id"];
-        input.algo_type = j["algo_type"];
-        input.input = j["input"];
+        j["client_id"] = std::string(input.client_id);
+        j["algo_type"] = std::string(input.algo_type);
+        j["input"] = std::string(get_algo_msg_var(input));
     }
 
     inline void to_json(nlohmann::json& j, const AlgoOrderStatus& status)
     {
         j["order_id"] = status.order_id;
-        j["algo_type"] = status.algo_type;
-        j["status"] = status.status;
-    }
-
-    inline void from_json(const nlohmann::json& j, AlgoOrderStatus& status)
-    {
-        status.order_id = j["order_id"];
-        status.algo_type = j["algo_type"];
-        status.status = j["status"];
+        j["algo_type"] = std::string(status.algo_type);
+        j["status"] = std::string(get_algo_msg_var(status));
     }
 
     inline void to_json(nlohmann::json& j, const AlgoOrderAction& action)
     {
         j["order_id"] = action.order_id;
         j["order_action_id"] = action.order_action_id;
-        j["action"] = action.action;
-    }
-
-    inline void from_json(const nlohmann::json& j, AlgoOrderAction& action)
-    {
-        action.order_id = j["order_id"];
-        action.order_action_id = j["order_action_id"];
-        action.action = j["action"];
+        j["action"] = std::string(get_algo_msg_var(action));
     }
 
     template<typename T> std::string to_string(const T& ori)
@@ -0,0 +1,81 @@
+//
+// Wire encodings of messages published by NNPublisher.
+//
+
+#ifndef KUNGFU_NN_CODEC_H
+#define KUNGFU_NN_CODEC_H
+
+#include "msg.h"
+#include <cstdint>
+#include <cstring>
+
+namespace kungfu
+{
+    // nanomsg subscribers pick an encoding by subscription prefix:
+    // json messages always start with '{', binary messages start with NN_BINARY_TOPIC
+#define NN_JSON_TOPIC "{"
+#define NN_BINARY_TOPIC "KFB"
+#define NN_BINARY_TOPIC_LEN 3
+#define NN_BINARY_VERSION 1
+
+    enum class NNEncoding: int
+    {
+        Json = 1,
+        Binary = 2,
+        Both = 3
+    };
+
+    inline bool has_encoding(NNEncoding encoding, NNEncoding flag)
+    {
+        return (int(encoding) & int(flag)) != 0;
+    }
+
+    // binary message: header followed by the raw struct (same layout as in journal)
+    struct NNBinaryHeader
+    {
+        char magic[NN_BINARY_TOPIC_LEN];  // NN_BINARY_TOPIC
+        uint8_t version;                  // NN_BINARY_VERSION
+        int32_t msg_type;                 // MsgType
+        int32_t length;                   // length of data after header
+    };
+
+#define NN_BINARY_DATA(header) ((const char*)(header) + sizeof(kungfu::NNBinaryHeader))
+
+    // write header and data to buf, which must hold sizeof(NNBinaryHeader) + length bytes, return bytes written
+    inline int encode_binary(char* buf, MsgType msg_type, const void* data, int length)
+    {
+        NNBinaryHeader* header = (NNBinaryHeader*)buf;
+        memcpy(header->magic, NN_BINARY_TOPIC, NN_BINARY_TOPIC_LEN);
+        header->version = NN_BINARY_VERSION;
+        header->msg_type = int32_t(msg_type);
+        header->length = length;
+        memcpy(buf + sizeof(NNBinaryHeader), data, length);
+        return sizeof(NNBinaryHeader) + length;
+    }
+
+    // return header of a received binary message, nullptr if it is json, unknown version or truncated
+    inline const NNBinaryHeader* decode_binary(const void* buf, int size)
+    {
+        const NNBinaryHeader* header = (const NNBinaryHeader*)buf;
+        if (size < (int)sizeof(NNBinaryHeader) || memcmp(header->magic, NN_BINARY_TOPIC, NN_BINARY_TOPIC_LEN) != 0
+            || header->version > NN_BINARY_VERSION || size < (int)sizeof(NNBinaryHeader) + header->length)
+        {
+            return nullptr;
+        }
+        return header;
+    }
+
+    // copy data of a binary message into T, false if msg length does not match (struct changed on one side)
+    template <typename T>
+    inline bool decode_binary_data(const NNBinaryHeader* header, T& data)
+    {
+        if (header->length != sizeof(T))
+        {
+            return false;
+        }
+        memcpy(&data, NN_BINARY_DATA(header), sizeof(T));
+        return true;
+    }
+}
+
+#endif //KUNGFU_NN_CODEC_H
@@ -9,7 +9,7 @@
 
 namespace kungfu
 {
-    NNPublisher::NNPublisher(const std::string& url)
+    NNPublisher::NNPublisher(const std::string& url, NNEncoding encoding): encoding_(encoding)
     {
         SPDLOG_TRACE(url);
         pub_socket_ = std::shared_ptr<nn::socket>(new nn::socket(AF_SP, NN_PUB));
@@ -26,39 +26,64 @@ namespace kungfu
         pub_socket_->send(js.c_str(), js.length() + 1, 0);
     }
 
+    void NNPublisher::publish_binary(kungfu::MsgType msg_type, const void* data, int length) const
+    {
+        void* buf = nn_allocmsg(sizeof(NNBinaryHeader) + length, 0);
+        encode_binary((char*)buf, msg_type, data, length);
+        SPDLOG_TRACE("binary msg_type {} length {}", int(msg_type), length);
+        // zero copy, nanomsg owns buf once sent
+        try
+        {
+            pub_socket_->send(&buf, NN_MSG, 0);
+        }
+        catch (...)
+        {
+            nn_freemsg(buf);
+            throw;
+        }
+    }
+
+    template <typename T>
+    void NNPublisher::publish_struct(kungfu::MsgType msg_type, const T& data) const
+    {
+        if (has_encoding(encoding_, NNEncoding::Binary))
+        {
+            publish_binary(msg_type, &data, sizeof(T));
+        }
+        if (has_encoding(encoding_, NNEncoding::Json))
+        {
+            nlohmann::json j = data;
+            publish(msg_type, j);
+        }
+    }
+
     void NNPublisher::publish_order(const kungfu::Order &order) const
     {
-        nlohmann::json j = order;
-        publish(kungfu::MsgType::Order, j);
+        publish_struct(kungfu::MsgType::Order, order);
     }
 
     void NNPublisher::publish_trade(const kungfu::Trade &trade) const
     {
-        nlohmann::json j = trade;
-        publish(kungfu::MsgType::Trade, j);
+        publish_struct(kungfu::MsgType::Trade, trade);
     }
 
     void NNPublisher::publish_pos(const kungfu::Position& pos) const
     {
-        nlohmann::json j = pos;
-        publish(kungfu::MsgType::Position, j);
+        publish_struct(kungfu::MsgType::Position, pos);
     }
 
     void NNPublisher::publish_portfolio_info(const kungfu::PortfolioInfo &portfolio, kungfu::MsgType msg_type) const
     {
-        nlohmann::json j = portfolio;
-        publish(msg_type, j);
+        publish_struct(msg_type, portfolio);
     }
 
     void NNPublisher::publish_strategy_used_account(const kungfu::StrategyUsedAccountInfo &info) const
     {
-        nlohmann::json j = info;
-        publish(kungfu::MsgType::StrategyUsedAccountUpdate, j);
+        publish_struct(kungfu::MsgType::StrategyUsedAccountUpdate, info);
     }
 
     void NNPublisher::publish_account_info(const kungfu::AccountInfo &account_info, kungfu::MsgType msg_type) const
     {
-        nlohmann::json j = account_info;
-        publish(msg_type, j);
+        publish_struct(msg_type, account_info);
     }
 }
\ No newline at end of file
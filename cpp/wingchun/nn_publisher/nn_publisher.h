@@ -7,6 +7,7 @@
 
 #include "msg.h"
 #include "oms_struct.h"
+#include "nn_codec.h"
 #include <string>
 #include <nn.hpp>
 #include "nlohmann/json.hpp"
@@ -16,7 +17,11 @@ namespace kungfu
     class NNPublisher
     {
     public:
-        NNPublisher(const std::string& url);
+        NNPublisher(const std::string& url, NNEncoding encoding = NNEncoding::Json);
+
+        // json keeps old subscribers working, binary skips json dump on the publishing thread
+        void set_encoding(NNEncoding encoding) { encoding_ = encoding; }
+        NNEncoding get_encoding() const { return encoding_; }
 
         void publish_order(const kungfu::Order& order) const;
         void publish_trade(const kungfu::Trade& trade) const ;
@@ -25,9 +30,14 @@ namespace kungfu
         void publish_account_info(const kungfu::AccountInfo& account_info, kungfu::MsgType msg_type = kungfu::MsgType::AccountInfo) const ;
         void publish_strategy_used_account(const kungfu::StrategyUsedAccountInfo& info) const;
         void publish(kungfu::MsgType msg_type, nlohmann::json& data) const ;
+        void publish_binary(kungfu::MsgType msg_type, const void* data, int length) const ;
 
     private:
+        template <typename T>
+        void publish_struct(kungfu::MsgType msg_type, const T& data) const;
+
         std::shared_ptr<nn::socket> pub_socket_;
+        NNEncoding encoding_;
     };
 }
 
@@ -0,0 +1,128 @@
+//
+// NNPublisher encoding benchmark.
+// encode order/trade/position/account info as json (what publish does) and as binary,
+// decode binary back and compare, report ns per encode and bytes per message.
+// usage: bench_encode [loop_num]
+//
+
+#include "nn_publisher/nn_codec.h"
+#include "serialize.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// same as NNPublisher::publish
+inline std::string encode_json(MsgType msg_type, const nlohmann::json& data)
+{
+    nlohmann::json j;
+    j["msg_type"] = int(msg_type);
+    j["data"] = data;
+    return j.dump();
+}
+
+template <typename T>
+void bench(const std::string& name, MsgType msg_type, const T& data, int loop_num)
+{
+    size_t json_bytes = 0;
+    int64_t start = now_nano();
+    for (int i = 0; i < loop_num; i++)
+    {
+        nlohmann::json j = data;
+        json_bytes = encode_json(msg_type, j).length() + 1;
+    }
+    int64_t json_ns = (now_nano() - start) / loop_num;
+
+    std::vector<char> buf(sizeof(NNBinaryHeader) + sizeof(T));
+    int binary_bytes = 0;
+    start = now_nano();
+    for (int i = 0; i < loop_num; i++)
+    {
+        binary_bytes = encode_binary(buf.data(), msg_type, &data, sizeof(T));
+    }
+    int64_t binary_ns = (now_nano() - start) / loop_num;
+
+    T decoded = {};
+    const NNBinaryHeader* header = decode_binary(buf.data(), binary_bytes);
+    bool ok = header != nullptr && header->msg_type == int(msg_type) && decode_binary_data(header, decoded)
+              && memcmp(&decoded, &data, sizeof(T)) == 0;
+
+    std::cout << name
+              << " [json] (ns) " << json_ns << " (bytes) " << json_bytes
+              << " [binary] (ns) " << binary_ns << " (bytes) " << binary_bytes
+              << " (decode) " << (ok ? "ok" : "FAILED") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int loop_num = (argc > 1) ? atoi(argv[1]) : 100000;
+
+    Order order = {};
+    order.order_id = 1234567890123456789;
+    order.rcv_time = order.insert_time = order.update_time = 1555555555123456789;
+    strcpy(order.trading_day, "20190418");
+    strcpy(order.instrument_id, "600000");
+    strcpy(order.exchange_id, EXCHANGE_SSE);
+    strcpy(order.account_id, "15040900");
+    strcpy(order.client_id, "bench");
+    order.instrument_type = InstrumentTypeStock;
+    order.limit_price = order.frozen_price = 11.23;
+    order.volume = order.volume_left = 300;
+    order.status = OrderStatusSubmitted;
+    order.side = SideBuy;
+    order.offset = OffsetOpen;
+    order.price_type = PriceTypeLimit;
+    order.volume_condition = VolumeConditionAny;
+    order.time_condition = TimeConditionGFD;
+
+    Trade trade = {};
+    trade.id = 1234567890123456790;
+    trade.order_id = order.order_id;
+    trade.rcv_time = trade.trade_time = order.update_time;
+    strcpy(trade.instrument_id, order.instrument_id);
+    strcpy(trade.exchange_id, order.exchange_id);
+    strcpy(trade.account_id, order.account_id);
+    strcpy(trade.client_id, order.client_id);
+    trade.instrument_type = InstrumentTypeStock;
+    trade.side = SideBuy;
+    trade.offset = OffsetOpen;
+    trade.price = 11.23;
+    trade.volume = 100;
+    trade.commission = 5;
+
+    Position pos = {};
+    pos.rcv_time = pos.update_time = order.update_time;
+    strcpy(pos.trading_day, order.trading_day);
+    strcpy(pos.instrument_id, order.instrument_id);
+    strcpy(pos.exchange_id, order.exchange_id);
+    strcpy(pos.account_id, order.account_id);
+    pos.instrument_type = InstrumentTypeStock;
+    pos.direction = DirectionLong;
+    pos.volume = 1000;
+    pos.yesterday_volume = 900;
+    pos.last_price = pos.cost_price = 11.23;
+
+    AccountInfo account = {};
+    account.rcv_time = account.update_time = order.update_time;
+    strcpy(account.trading_day, order.trading_day);
+    strcpy(account.account_id, order.account_id);
+    account.type = AccountTypeStock;
+    account.initial_equity = account.static_equity = account.dynamic_equity = 1000000;
+    account.avail = 988770;
+    account.market_value = 11230;
+
+    std::cout << "(loops) " << loop_num << std::endl;
+    bench("[order   ]", MsgType::Order, order, loop_num);
+    bench("[trade   ]", MsgType::Trade, trade, loop_num);
+    bench("[position]", MsgType::Position, pos, loop_num);
+    bench("[account ]", MsgType::AccountInfo, account, loop_num);
+    return 0;
+}
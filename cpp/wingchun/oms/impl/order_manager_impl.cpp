@@ -7,81 +7,266 @@
 
 #include "../include/def.h"
 #include "util/include/business_helper.h"
+#include "util/include/symbol_interner.h"
+#include "config.h"
 
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 #include <iostream>
 namespace kungfu
 {
     namespace oms
     {
+        // active orders live in a dense vector indexed by order id, instrument and parent id,
+        // so pending order queries cost O(active). finished orders are retired to a bounded archive.
         class OrderManagerImpl: public OrderManager
         {
         public:
-            OrderManagerImpl() {}
+            OrderManagerImpl(): archive_next_(0) {}
             virtual ~OrderManagerImpl() {}
 
             void on_order(const Order* order)
             {
-                if (order->parent_id != 0)
+                auto it = active_pos_.find(order->order_id);
+                if (it != active_pos_.end())
                 {
+                    if (active_[it->second].is_algo)
+                    {
+                        return;
+                    }
+                    OrderPtr simple_order = active_[it->second].order;
+                    static_cast<SimpleOrder*>(simple_order.get())->on_order(order);
+                    if (is_final_status(order->status))
+                    {
+                        remove_active(order->order_id);
+                        archive(order->order_id, std::move(simple_order), false);
+                    }
                     return;
                 }
-                else
+                auto archived = archive_pos_.find(order->order_id);
+                if (archived != archive_pos_.end())
                 {
-                    if (orders_.find(order->order_id) == orders_.end())
+                    // late update of a finished order
+                    ArchivedOrder& record = archive_[archived->second];
+                    if (!record.is_algo)
                     {
-                        auto simple_order = make_simple_order(*order);
-                        orders_[order->order_id] = simple_order;
-                    }
-                    else
-                    {
-                        auto simple_order = std::dynamic_pointer_cast<SimpleOrder>(orders_[order->order_id]);
-                        simple_order->on_order(order);
+                        static_cast<SimpleOrder*>(record.order.get())->on_order(order);
                     }
+                    return;
+                }
+                if (is_final_status(order->status))
+                {
+                    archive(order->order_id, make_simple_order(*order), false);
+                }
+                else
+                {
+                    OrderEntry entry = {make_simple_order(*order), false, order->order_id, order->parent_id,
+                                        SymbolInterner::get_interner().intern(order->instrument_id, order->exchange_id)};
+                    add_active(std::move(entry));
                 }
             };
 
             void on_algo_order_status(uint64_t order_id, const std::string& algo_type, const std::string& order_status)
             {
-                auto it = orders_.find(order_id);
-                if (it == orders_.end())
+                auto it = active_pos_.find(order_id);
+                if (it != active_pos_.end())
                 {
-                    AlgoOrderPtr order = AlgoOrderFactory::get()->create_order(algo_type);
-                    if (order != nullptr)
+                    if (!active_[it->second].is_algo)
                     {
-                        order->set_order_id(order_id);
-                        order->loads(order_status);
-                        orders_[order->get_order_id()] = order;
+                        return;
                     }
+                    OrderPtr order = active_[it->second].order;
+                    static_cast<AlgoOrder*>(order.get())->loads(order_status);
+                    if (!order->is_active())
+                    {
+                        remove_active(order_id);
+                        archive(order_id, std::move(order), true);
+                    }
+                    return;
                 }
-                else
+                auto archived = archive_pos_.find(order_id);
+                if (archived != archive_pos_.end())
                 {
-                    std::dynamic_pointer_cast<AlgoOrder>(it->second)->loads(order_status);
+                    const ArchivedOrder& record = archive_[archived->second];
+                    if (record.is_algo)
+                    {
+                        static_cast<AlgoOrder*>(record.order.get())->loads(order_status);
+                    }
+                    return;
+                }
+                AlgoOrderPtr order = AlgoOrderFactory::get()->create_order(algo_type);
+                if (order != nullptr)
+                {
+                    order->set_order_id(order_id);
+                    order->loads(order_status);
+                    if (order->is_active())
+                    {
+                        add_active(OrderEntry{order, true, order_id, 0, SYMBOL_ID_NONE});
+                    }
+                    else
+                    {
+                        archive(order_id, order, true);
+                    }
                 }
-
             }
 
             OrderPtr get_order(uint64_t order_id) const
             {
-                //TODO
+                auto it = active_pos_.find(order_id);
+                if (it != active_pos_.end())
+                {
+                    return active_[it->second].order;
+                }
+                auto archived = archive_pos_.find(order_id);
+                if (archived != archive_pos_.end())
+                {
+                    return archive_[archived->second].order;
+                }
                 return nullptr;
             }
 
             std::vector<OrderPtr> get_pending_orders() const
             {
                 std::vector<OrderPtr> order_vec;
-                for (const auto& element: orders_)
+                order_vec.reserve(active_.size());
+                for (const auto& entry: active_)
                 {
-                    if (element.second->is_active())
+                    if (entry.parent_id == 0)
                     {
-                        order_vec.push_back(element.second);
+                        order_vec.push_back(entry.order);
                     }
                 }
                 return order_vec;
             }
 
+            std::vector<OrderPtr> get_pending_orders(const std::string& instrument_id, const std::string& exchange_id) const
+            {
+                return get_indexed_orders(by_symbol_, SymbolInterner::get_interner().find(instrument_id.c_str(), exchange_id.c_str()));
+            }
+
+            std::vector<OrderPtr> get_child_orders(uint64_t parent_id) const
+            {
+                return get_indexed_orders(by_parent_, parent_id);
+            }
+
         private:
-            std::unordered_map<uint64_t, OrderPtr> orders_;
+            struct OrderEntry
+            {
+                OrderPtr order;
+                bool is_algo; // set on creation, orders are cast by it instead of dynamic_pointer_cast
+                uint64_t order_id;
+                uint64_t parent_id;
+                uint32_t symbol_id; // SYMBOL_ID_NONE for algo orders
+            };
+
+            // finished orders are kept as is, get_order returns the same object while it stays archived
+            struct ArchivedOrder
+            {
+                uint64_t order_id;
+                OrderPtr order;
+                bool is_algo;
+            };
+
+            template <typename Key>
+            std::vector<OrderPtr> get_indexed_orders(const std::unordered_map<Key, std::vector<uint64_t>>& index, Key key) const
+            {
+                std::vector<OrderPtr> order_vec;
+                auto it = index.find(key);
+                if (it != index.end())
+                {
+                    order_vec.reserve(it->second.size());
+                    for (uint64_t order_id : it->second)
+                    {
+                        order_vec.push_back(active_[active_pos_.at(order_id)].order);
+                    }
+                }
+                return order_vec;
+            }
+
+            template <typename Key>
+            static void remove_from_index(std::unordered_map<Key, std::vector<uint64_t>>& index, Key key, uint64_t order_id)
+            {
+                auto it = index.find(key);
+                if (it == index.end())
+                {
+                    return;
+                }
+                auto& ids = it->second;
+                ids.erase(std::remove(ids.begin(), ids.end(), order_id), ids.end());
+                if (ids.empty())
+                {
+                    index.erase(it);
+                }
+            }
+
+            void add_active(OrderEntry&& entry)
+            {
+                if (entry.symbol_id != SYMBOL_ID_NONE)
+                {
+                    by_symbol_[entry.symbol_id].push_back(entry.order_id);
+                }
+                if (entry.parent_id != 0)
+                {
+                    by_parent_[entry.parent_id].push_back(entry.order_id);
+                }
+                active_pos_[entry.order_id] = active_.size();
+                active_.push_back(std::move(entry));
+            }
+
+            void remove_active(uint64_t order_id)
+            {
+                auto it = active_pos_.find(order_id);
+                size_t pos = it->second;
+                active_pos_.erase(it);
+                const OrderEntry& entry = active_[pos];
+                if (entry.symbol_id != SYMBOL_ID_NONE)
+                {
+                    remove_from_index(by_symbol_, entry.symbol_id, order_id);
+                }
+                if (entry.parent_id != 0)
+                {
+                    remove_from_index(by_parent_, entry.parent_id, order_id);
+                }
+                // swap with the last one to keep active_ dense
+                if (pos + 1 != active_.size())
+                {
+                    active_[pos] = std::move(active_.back());
+                    active_pos_[active_[pos].order_id] = pos;
+                }
+                active_.pop_back();
+            }
+
+            // oldest archived order is dropped once the archive is full
+            void archive(uint64_t order_id, OrderPtr order, bool is_algo)
+            {
+                size_t slot;
+                if (archive_.size() < OMS_ORDER_ARCHIVE_CAPACITY)
+                {
+                    slot = archive_.size();
+                    archive_.emplace_back();
+                }
+                else
+                {
+                    slot = archive_next_;
+                    archive_next_ = (archive_next_ + 1) % OMS_ORDER_ARCHIVE_CAPACITY;
+                    archive_pos_.erase(archive_[slot].order_id);
+                }
+                ArchivedOrder& record = archive_[slot];
+                record.order_id = order_id;
+                record.order = std::move(order);
+                record.is_algo = is_algo;
+                archive_pos_[order_id] = slot;
+            }
+
+            std::vector<OrderEntry> active_;
+            std::unordered_map<uint64_t, size_t> active_pos_; // order_id -> position in active_
+            std::unordered_map<uint32_t, std::vector<uint64_t>> by_symbol_; // symbol id -> active order ids
+            std::unordered_map<uint64_t, std::vector<uint64_t>> by_parent_; // parent id -> active child order ids
+
+            std::vector<ArchivedOrder> archive_; // ring of OMS_ORDER_ARCHIVE_CAPACITY
+            std::unordered_map<uint64_t, size_t> archive_pos_; // order_id -> slot in archive_
+            size_t archive_next_; // slot to overwrite once full
         };
 
         OrderManagerPtr create_order_manager()
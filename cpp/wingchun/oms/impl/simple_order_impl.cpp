@@ -66,12 +66,12 @@ namespace kungfu
 
         SimpleOrderPtr make_simple_order(const OrderInput& input)
         {
-            return  SimpleOrderPtr(new SimpleOrderImpl(input));
+            return make_pooled<SimpleOrderImpl>(input);
         }
 
         SimpleOrderPtr make_simple_order(const Order& order)
         {
-            return SimpleOrderPtr(new SimpleOrderImpl(order));
+            return make_pooled<SimpleOrderImpl>(order);
         }
     }
 }
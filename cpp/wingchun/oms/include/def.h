@@ -7,6 +7,7 @@
 
 #include "oms_struct.h"
 #include "md_struct.h"
+#include "order_pool.h"
 
 #include "nlohmann/json.hpp"
 #include <cstring>
@@ -51,6 +52,7 @@ namespace kungfu
         };
 
         typedef std::shared_ptr<kungfu::oms::SimpleOrder> SimpleOrderPtr;
+        // allocated from OrderBlockPool
         SimpleOrderPtr make_simple_order(const OrderInput& input);
         SimpleOrderPtr make_simple_order(const Order& order);
 
@@ -225,7 +227,7 @@ namespace kungfu
             template <typename AlgoOrderDerived>
             static std::shared_ptr<AlgoOrder> createFunc()
             {
-                return std::shared_ptr<AlgoOrder>(new AlgoOrderDerived());
+                return make_pooled<AlgoOrderDerived>();
             }
 
             typedef AlgoOrderPtr (*PCreateFunc)();
@@ -241,8 +243,14 @@ namespace kungfu
         public:
             virtual void on_order(const Order* order) = 0;
             virtual void on_algo_order_status(uint64_t order_id, const std::string& algo_type, const std::string& order_status) = 0;
+            // active or archived order, nullptr if unknown or dropped from the archive.
+            // the same object is returned on every call while the order is kept
             virtual OrderPtr get_order(uint64_t order_id) const = 0;
+            // active orders except children of algo orders
             virtual std::vector<OrderPtr> get_pending_orders() const = 0;
+            virtual std::vector<OrderPtr> get_pending_orders(const std::string& instrument_id, const std::string& exchange_id) const = 0;
+            // active children of an algo order
+            virtual std::vector<OrderPtr> get_child_orders(uint64_t parent_id) const = 0;
         };
 
         typedef std::shared_ptr<OrderManager> OrderManagerPtr;
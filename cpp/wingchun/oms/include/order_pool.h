@@ -0,0 +1,136 @@
+//
+// Slab pools for oms order objects.
+//
+
+#ifndef KUNGFU_ORDER_POOL_H
+#define KUNGFU_ORDER_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "config.h"
+
+namespace kungfu
+{
+    namespace oms
+    {
+        struct OrderPoolStats
+        {
+            size_t block_size;
+            size_t slabs;           // slabs of OMS_ORDER_POOL_SLAB_SIZE blocks allocated
+            size_t blocks_in_use;
+        };
+
+        // fixed size blocks carved from slabs and recycled through a free list.
+        // slabs are never returned, a pool holds as many blocks as were ever in use at once.
+        template <size_t BlockSize>
+        class OrderBlockPool
+        {
+        public:
+            static OrderBlockPool& get()
+            {
+                static OrderBlockPool* pool = new OrderBlockPool(); // never destroyed, orders may outlive static destruction
+                return *pool;
+            }
+
+            void* allocate()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (free_ == nullptr)
+                {
+                    add_slab();
+                }
+                Block* block = free_;
+                free_ = block->next;
+                in_use_++;
+                return block;
+            }
+
+            void deallocate(void* p)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                Block* block = static_cast<Block*>(p);
+                block->next = free_;
+                free_ = block;
+                in_use_--;
+            }
+
+            OrderPoolStats get_stats()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return OrderPoolStats{sizeof(Block), slabs_.size(), in_use_};
+            }
+
+        private:
+            union Block
+            {
+                Block* next;
+                alignas(std::max_align_t) char data[BlockSize];
+            };
+
+            OrderBlockPool(): free_(nullptr), in_use_(0) {}
+
+            void add_slab()
+            {
+                slabs_.emplace_back(new Block[OMS_ORDER_POOL_SLAB_SIZE]);
+                Block* slab = slabs_.back().get();
+                for (size_t i = 0; i < OMS_ORDER_POOL_SLAB_SIZE; i++)
+                {
+                    slab[i].next = free_;
+                    free_ = &slab[i];
+                }
+            }
+
+            std::mutex mutex_;
+            std::vector<std::unique_ptr<Block[]>> slabs_;
+            Block* free_;
+            size_t in_use_;
+        };
+
+        // allocator for std::allocate_shared, the order and its control block share one pooled block
+        template <typename T>
+        class OrderPoolAllocator
+        {
+        public:
+            typedef T value_type;
+
+            OrderPoolAllocator() = default;
+            template <typename U>
+            OrderPoolAllocator(const OrderPoolAllocator<U>&) {}
+
+            T* allocate(size_t n)
+            {
+                if (n != 1)
+                {
+                    return static_cast<T*>(::operator new(n * sizeof(T)));
+                }
+                return static_cast<T*>(OrderBlockPool<sizeof(T)>::get().allocate());
+            }
+
+            void deallocate(T* p, size_t n)
+            {
+                if (n != 1)
+                {
+                    ::operator delete(p);
+                    return;
+                }
+                OrderBlockPool<sizeof(T)>::get().deallocate(p);
+            }
+        };
+
+        template <typename T, typename U>
+        inline bool operator==(const OrderPoolAllocator<T>&, const OrderPoolAllocator<U>&) { return true; }
+        template <typename T, typename U>
+        inline bool operator!=(const OrderPoolAllocator<T>&, const OrderPoolAllocator<U>&) { return false; }
+
+        template <typename T, typename... Args>
+        inline std::shared_ptr<T> make_pooled(Args&&... args)
+        {
+            return std::allocate_shared<T>(OrderPoolAllocator<T>(), std::forward<Args>(args)...);
+        }
+    }
+}
+#endif //KUNGFU_ORDER_POOL_H
@@ -0,0 +1,117 @@
+//
+// OrderManager order update benchmark.
+// a strategy sending waves of child orders: each order is submitted, partially filled a few times and filled,
+// then retired, so order objects are created and released all day long.
+// usage: bench_order_update [order_num] [fills_per_order] [wave_size]
+//
+
+#include "oms/include/def.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// same payload as a simple order, for allocation comparison
+struct PlainOrder: public oms::OmsOrder
+{
+    uint64_t get_order_id() const { return order.order_id; }
+    void execute() {}
+    void cancel() {}
+    bool is_algo() const { return false; }
+    bool is_active() const { return true; }
+    OrderInput input;
+    Order order;
+};
+
+int main(int argc, char** argv)
+{
+    int order_num = (argc > 1) ? atoi(argv[1]) : 200000;
+    int fills_per_order = (argc > 2) ? atoi(argv[2]) : 3;
+    int wave_size = (argc > 3) ? atoi(argv[3]) : 500;
+    std::cout << "(orders) " << order_num << " (fills per order) " << fills_per_order << " (wave) " << wave_size << std::endl;
+
+    std::vector<Order> wave(wave_size);
+    for (int i = 0; i < wave_size; i++)
+    {
+        Order& order = wave[i];
+        memset(&order, 0, sizeof(order));
+        sprintf(order.instrument_id, "%06d", 600000 + i % 50);
+        strcpy(order.exchange_id, "SSE");
+        order.volume = 100 * (fills_per_order + 1);
+        order.parent_id = 1;
+    }
+
+    oms::OrderManagerPtr manager = oms::create_order_manager();
+    long updates = 0;
+    int64_t start = now_nano();
+    for (int base = 0; base < order_num; base += wave_size)
+    {
+        int n = std::min(wave_size, order_num - base);
+        for (int step = 0; step <= fills_per_order + 1; step++)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                Order& order = wave[i];
+                order.order_id = 2 + base + i;
+                order.volume_traded = 100 * step;
+                order.volume_left = order.volume - order.volume_traded;
+                order.status = step == 0 ? OrderStatusSubmitted : (step <= fills_per_order ? OrderStatusPartialFilledActive : OrderStatusFilled);
+                manager->on_order(&order);
+                updates++;
+            }
+        }
+    }
+    int64_t manager_ns = now_nano() - start;
+    bool ok = manager->get_pending_orders().empty() && manager->get_child_orders(1).empty() && manager->get_order(order_num + 1) != nullptr;
+    // an archived order is the same object on every lookup
+    ok = ok && manager->get_order(order_num + 1) == manager->get_order(order_num + 1);
+    std::cout << "[order manager  ] (ns per update) " << (double)manager_ns / updates << " (updates) " << updates << std::endl;
+
+    // allocation of one order object, as in make_simple_order
+    start = now_nano();
+    for (int i = 0; i < order_num; i++)
+    {
+        oms::OrderPtr order(new PlainOrder());
+        ok = ok && order->get_order_id() == 0;
+    }
+    int64_t new_ns = now_nano() - start;
+    start = now_nano();
+    for (int i = 0; i < order_num; i++)
+    {
+        oms::OrderPtr order = oms::make_pooled<PlainOrder>();
+        ok = ok && order->get_order_id() == 0;
+    }
+    int64_t pooled_ns = now_nano() - start;
+    std::cout << "[shared_ptr new ] (ns per order) " << (double)new_ns / order_num << std::endl;
+    std::cout << "[allocate pooled] (ns per order) " << (double)pooled_ns / order_num << std::endl;
+
+    // the cast on every update
+    oms::OrderPtr order = oms::make_pooled<PlainOrder>();
+    start = now_nano();
+    long hits = 0;
+    for (int i = 0; i < order_num; i++)
+    {
+        hits += std::dynamic_pointer_cast<PlainOrder>(order) != nullptr;
+    }
+    int64_t dynamic_ns = now_nano() - start;
+    start = now_nano();
+    for (int i = 0; i < order_num; i++)
+    {
+        hits += !order->is_algo() && static_cast<PlainOrder*>(order.get()) != nullptr;
+    }
+    int64_t static_ns = now_nano() - start;
+    std::cout << "[dynamic cast   ] (ns per update) " << (double)dynamic_ns / order_num << std::endl;
+    std::cout << "[static tag     ] (ns per update) " << (double)static_ns / order_num << std::endl;
+    ok = ok && hits == 2L * order_num;
+
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -88,6 +88,8 @@ namespace kungfu
         void register_pnl_callback(PnLCallback cb) override;
         void set_initial_equity(double equity) override;
         void set_static_equity(double equity) override;
+        void on_timer(int64_t nano) override;
+        void flush() override;
         // IPnLDataHandler
 
         double calc_commission(const Trade* trade) const;
@@ -15,6 +15,9 @@ namespace kungfu
     typedef std::function<void (const AccountInfo&)> AccountCallback;
     typedef std::function<void (const PortfolioInfo&)> PnLCallback;
 
+    // 成交后的存盘在此间隔内合并为一次, 由 on_timer 保证间隔结束后写入
+#define PNL_SAVE_INTERVAL_NANO 500000000
+
     class IPosDataFetcher
     {
     public:
@@ -123,6 +126,12 @@ namespace kungfu
         virtual void register_pnl_callback(PnLCallback cb) = 0;
         virtual void set_initial_equity(double equity) = 0;
         virtual void set_static_equity(double equity) = 0;
+
+        // 存盘
+        // 定时调用(间隔PNL_SAVE_INTERVAL_NANO), 写入被合并推迟的存盘
+        virtual void on_timer(int64_t nano) {};
+        // 写入所有未存盘的数据, 退出前调用
+        virtual void flush() {};
     };
 }
 
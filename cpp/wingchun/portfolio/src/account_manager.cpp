@@ -345,6 +345,16 @@ namespace kungfu
         impl_->set_static_equity(equity);
     }
 
+    void AccountManager::on_timer(int64_t nano)
+    {
+        impl_->on_timer(nano);
+    }
+
+    void AccountManager::flush()
+    {
+        impl_->flush();
+    }
+
     double AccountManager::calc_commission(const kungfu::Trade *trade) const
     {
         return impl_->calc_commission(trade);
@@ -8,6 +8,7 @@
 #include "../include/account_manager.h"
 #include "../include/position_manager.h"
 #include "account_storage.h"
+#include "storage_common.h"
 #include "serialize.h"
 #include "util/include/business_helper.h"
 #include "commission/commission_manager.h"
@@ -97,6 +98,8 @@ namespace kungfu
         void register_pnl_callback(PnLCallback cb) override;
         void set_initial_equity(double equity) override;
         void set_static_equity(double equity) override;
+        void on_timer(int64_t nano) override;
+        void flush() override;
         // IPnLDataHandler
 
         double calc_commission(const Trade* trade) const;
@@ -104,6 +107,7 @@ namespace kungfu
         AccountInfo get_account_info() const;
 
     private:
+        void save();
         bool recalc_acc();
         void callback() const;
         void on_pos_callback(const Position& pos) const;
@@ -114,6 +118,7 @@ namespace kungfu
         CommissionManager                               commission_;
         PositionManager                                 pos_manager_;
         AccountStorage                                  storage_;
+        SaveThrottle                                    save_throttle_;
         AccountInfo                                     account_;
         std::map<std::string, double>                   bond_map_;
         std::map<int64_t, double>                       frozen_map_; // { order_id -> frozen_money }
@@ -132,8 +137,14 @@ namespace kungfu
     }
 
     AccountManager::impl::~impl()
+    {
+        save();
+    }
+
+    void AccountManager::impl::save()
     {
         storage_.save(last_update_, trading_day_, account_, bond_map_, frozen_map_);
+        save_throttle_.saved(last_update_);
     }
 
     int64_t AccountManager::impl::get_long_tot(const char *instrument_id, const char *exchange_id) const
@@ -407,6 +418,10 @@ namespace kungfu
         {
             callback();
         }
+        if (save_throttle_.due(last_update_))
+        {
+            save();
+        }
     }
 
     void AccountManager::impl::on_order(const kungfu::Order *order)
@@ -417,6 +432,10 @@ namespace kungfu
         }
 
         last_update_ = order->rcv_time;
+        if (save_throttle_.due(last_update_))
+        {
+            save();
+        }
         if (!is_final_status(order->status) || frozen_map_.find(order->order_id) == frozen_map_.end())
         {
             return;
@@ -485,8 +504,11 @@ namespace kungfu
         recalc_acc();
         callback();
 
-        // 成交时一定写一下数据库, 解决前端切换页面时读库问题
-        storage_.save(last_update_, trading_day_, account_, bond_map_, frozen_map_);
+        // 成交时一定写一下数据库, 解决前端切换页面时读库问题; 连续成交合并到一个时间窗口内写一次
+        if (save_throttle_.request(last_update_))
+        {
+            save();
+        }
 
         SPDLOG_TRACE("acc after: {}", to_string(account_));
     }
@@ -530,7 +552,7 @@ namespace kungfu
         account_.margin = account.margin;
         recalc_acc();
         callback();
-        storage_.save(last_update_, trading_day_, account_, bond_map_, frozen_map_);
+        save();
     }
 
     void AccountManager::impl::insert_order(const kungfu::OrderInput *input)
@@ -616,7 +638,7 @@ namespace kungfu
         account_.intraday_pnl_ratio = 0;
         callback();
 
-        storage_.save(last_update_, trading_day_, account_, bond_map_, frozen_map_);
+        save();
     }
 
     int64_t AccountManager::impl::get_last_update() const
@@ -671,6 +693,25 @@ namespace kungfu
         account_.static_equity = equity;
     }
 
+    void AccountManager::impl::on_timer(int64_t nano)
+    {
+        pos_manager_.on_timer(nano);
+        // the last fill of a burst is written here if no event follows it
+        if (save_throttle_.due(nano))
+        {
+            save();
+        }
+    }
+
+    void AccountManager::impl::flush()
+    {
+        pos_manager_.flush();
+        if (save_throttle_.pending())
+        {
+            save();
+        }
+    }
+
     double AccountManager::impl::calc_commission(const kungfu::Trade *trade) const
     {
         if (is_reverse_repurchase(trade->instrument_id, trade->exchange_id))
@@ -10,70 +10,160 @@
 
 namespace kungfu
 {
-    AccountStorage::AccountStorage(const char *account_id, const char *db_file) : account_id_(account_id), db_file_(db_file)
+    AccountStorage::AccountStorage(const char *account_id, const char *db_file) : account_id_(account_id), db_file_(db_file),
+                                                                                   saved_last_update_(0), saved_account_{}, last_saved_rows_(0)
     {
         create_pos_tables(db_file);
         create_acc_tables(db_file);
+        db_ = std::unique_ptr<SQLite::Database>(new SQLite::Database(db_file_, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE));
+        auto& db = *db_;
+        replace_account_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db,
+                "REPLACE INTO account("
+                "rcv_time, update_time, trading_day, account_id, type, broker_id, source_id, "
+                "initial_equity, static_equity, dynamic_equity, accumulated_pnl, accumulated_pnl_ratio, "
+                "intraday_pnl, intraday_pnl_ratio, avail, market_value, margin, accumulated_fee, "
+                "intraday_fee, frozen_cash, frozen_margin, frozen_fee, position_pnl, close_pnl"
+                ") "
+                "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+        delete_account_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM account WHERE account_id = ? and type = ? and source_id = ?"));
+        replace_bond_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "REPLACE INTO bond_expire(date, account_id, amount) VALUES(?, ?, ?)"));
+        delete_bond_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM bond_expire WHERE date = ? and account_id = ?"));
+        replace_frozen_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "REPLACE INTO acc_frozen(order_id, account_id, amount) VALUES(?, ?, ?)"));
+        delete_frozen_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM acc_frozen WHERE order_id = ?"));
+        reload_saved();
     }
 
     void AccountStorage::save(int64_t last_update, const std::string &trading_day, const kungfu::AccountInfo &account,
                               const std::map<std::string, double> &bond_map,
                               const std::map<int64_t, double> &frozen_map)
     {
-        SQLite::Database db(db_file_, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        auto& db = *db_;
+        int rows = 0;
         db.exec("BEGIN");
         try
         {
-            db.exec(fmt::format("DELETE FROM account WHERE account_id = '{}' and type = '{}' and source_id = '{}'",
-                    account_id_, account.type, account.source_id));
-            db.exec(fmt::format("DELETE FROM bond_expire where account_id = '{}'", account_id_));
-            db.exec(fmt::format("DELETE FROM acc_frozen WHERE account_id = '{}'", account_id_));
-            db.exec(fmt::format("DELETE FROM meta"));
-
-            db.exec(fmt::format("INSERT INTO account("
-                                "rcv_time, update_time, trading_day, account_id, type, broker_id, source_id, "
-                                "initial_equity, static_equity, dynamic_equity, accumulated_pnl, accumulated_pnl_ratio, "
-                                "intraday_pnl, intraday_pnl_ratio, avail, market_value, margin, accumulated_fee, "
-                                "intraday_fee, frozen_cash, frozen_margin, frozen_fee, position_pnl, close_pnl"
-                                ") "
-                                "VALUES({},{},'{}','{}','{}','{}','{}',{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{})",
-                                account.rcv_time, account.update_time, account.trading_day, account.account_id, account.type,
-                                account.broker_id, account.source_id, account.initial_equity, account.static_equity,
-                                account.dynamic_equity, account.accumulated_pnl, account.accumulated_pnl_ratio,
-                                account.intraday_pnl, account.intraday_pnl_ratio, account.avail, account.market_value,
-                                account.margin, account.accumulated_fee, account.intraday_fee, account.frozen_cash,
-                                account.frozen_margin, account.frozen_fee, account.position_pnl, account.close_pnl));
+            if (memcmp(&account, &saved_account_, sizeof(AccountInfo)) != 0)
+            {
+                // account row is keyed by type and source, drop the old row if the key moved
+                if (saved_account_.type != account.type || strcmp(saved_account_.source_id, account.source_id) != 0)
+                {
+                    delete_account_->reset();
+                    delete_account_->bind(1, account_id_);
+                    delete_account_->bind(2, std::string(1, saved_account_.type));
+                    delete_account_->bind(3, saved_account_.source_id);
+                    delete_account_->exec();
+                }
+                auto& stmt = *replace_account_;
+                stmt.reset();
+                stmt.bind(1, (long long)account.rcv_time);
+                stmt.bind(2, (long long)account.update_time);
+                stmt.bind(3, account.trading_day);
+                stmt.bind(4, account.account_id);
+                stmt.bind(5, std::string(1, account.type));
+                stmt.bind(6, account.broker_id);
+                stmt.bind(7, account.source_id);
+                stmt.bind(8, account.initial_equity);
+                stmt.bind(9, account.static_equity);
+                stmt.bind(10, account.dynamic_equity);
+                stmt.bind(11, account.accumulated_pnl);
+                stmt.bind(12, account.accumulated_pnl_ratio);
+                stmt.bind(13, account.intraday_pnl);
+                stmt.bind(14, account.intraday_pnl_ratio);
+                stmt.bind(15, account.avail);
+                stmt.bind(16, account.market_value);
+                stmt.bind(17, account.margin);
+                stmt.bind(18, account.accumulated_fee);
+                stmt.bind(19, account.intraday_fee);
+                stmt.bind(20, account.frozen_cash);
+                stmt.bind(21, account.frozen_margin);
+                stmt.bind(22, account.frozen_fee);
+                stmt.bind(23, account.position_pnl);
+                stmt.bind(24, account.close_pnl);
+                stmt.exec();
+                saved_account_ = account;
+                rows++;
+            }
 
             for (const auto& iter : bond_map)
             {
-                db.exec(fmt::format("INSERT INTO bond_expire(date, account_id, amount) VALUES('{}', '{}', {})",
-                        iter.first, account_id_, iter.second));
+                auto saved = saved_bond_map_.find(iter.first);
+                if (saved == saved_bond_map_.end() || saved->second != iter.second)
+                {
+                    replace_bond_->reset();
+                    replace_bond_->bind(1, iter.first);
+                    replace_bond_->bind(2, account_id_);
+                    replace_bond_->bind(3, iter.second);
+                    replace_bond_->exec();
+                    rows++;
+                }
             }
+            for (const auto& iter : saved_bond_map_)
+            {
+                if (bond_map.find(iter.first) == bond_map.end())
+                {
+                    delete_bond_->reset();
+                    delete_bond_->bind(1, iter.first);
+                    delete_bond_->bind(2, account_id_);
+                    delete_bond_->exec();
+                    rows++;
+                }
+            }
+            saved_bond_map_ = bond_map;
 
             for (const auto& iter : frozen_map)
             {
-                db.exec(fmt::format("INSERT INTO acc_frozen(order_id, account_id, amount) VALUES({}, '{}', {})",
-                        iter.first, account_id_, iter.second));
+                auto saved = saved_frozen_map_.find(iter.first);
+                if (saved == saved_frozen_map_.end() || saved->second != iter.second)
+                {
+                    replace_frozen_->reset();
+                    replace_frozen_->bind(1, (long long)iter.first);
+                    replace_frozen_->bind(2, account_id_);
+                    replace_frozen_->bind(3, iter.second);
+                    replace_frozen_->exec();
+                    rows++;
+                }
+            }
+            for (const auto& iter : saved_frozen_map_)
+            {
+                if (frozen_map.find(iter.first) == frozen_map.end())
+                {
+                    delete_frozen_->reset();
+                    delete_frozen_->bind(1, (long long)iter.first);
+                    delete_frozen_->exec();
+                    rows++;
+                }
             }
+            saved_frozen_map_ = frozen_map;
 
-            db.exec(fmt::format("INSERT INTO meta(update_time, trading_day) VALUES({}, '{}')", last_update, trading_day));
+            if (last_update != saved_last_update_ || trading_day != saved_trading_day_)
+            {
+                db.exec(fmt::format("DELETE FROM meta"));
+                db.exec(fmt::format("INSERT INTO meta(update_time, trading_day) VALUES({}, '{}')", last_update, trading_day));
+                saved_last_update_ = last_update;
+                saved_trading_day_ = trading_day;
+            }
 
             db.exec("COMMIT");
         } catch (std::exception& e)
         {
             SPDLOG_ERROR(e.what());
             db.exec("ROLLBACK");
+            // saved state was updated along the way, take it from db again
+            reload_saved();
         }
+        last_saved_rows_ = rows;
     }
 
     void AccountStorage::save_meta(int64_t last_update, const std::string &trading_day)
     {
-        SQLite::Database db(db_file_, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        auto& db = *db_;
         db.exec("BEGIN");
         try
         {
             db.exec(fmt::format("DELETE FROM meta"));
             db.exec(fmt::format("INSERT INTO meta(update_time, trading_day) VALUES({}, '{}')", last_update, trading_day));
+            saved_last_update_ = last_update;
+            saved_trading_day_ = trading_day;
 
             db.exec("COMMIT");
         } catch (std::exception& e)
@@ -86,7 +176,23 @@ namespace kungfu
     void AccountStorage::load(int64_t &last_update, std::string &trading_day, kungfu::AccountInfo &account,
                               std::map<std::string, double> &bond_map, std::map<int64_t, double> &frozen_map)
     {
-        SQLite::Database db(db_file_, SQLite::OPEN_READONLY);
+        reload_saved();
+        last_update = saved_last_update_;
+        trading_day = saved_trading_day_;
+        account = saved_account_;
+        bond_map = saved_bond_map_;
+        frozen_map = saved_frozen_map_;
+    }
+
+    void AccountStorage::reload_saved()
+    {
+        load_inner(saved_last_update_, saved_trading_day_, saved_account_, saved_bond_map_, saved_frozen_map_);
+    }
+
+    void AccountStorage::load_inner(int64_t &last_update, std::string &trading_day, kungfu::AccountInfo &account,
+                                    std::map<std::string, double> &bond_map, std::map<int64_t, double> &frozen_map)
+    {
+        auto& db = *db_;
         db.exec("BEGIN");
         try
         {
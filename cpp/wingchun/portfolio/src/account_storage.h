@@ -6,7 +6,9 @@
 #define KUNGFU_ACCOUNT_STORAGE_H
 
 #include "oms_struct.h"
+#include <SQLiteCpp/SQLiteCpp.h>
 #include <map>
+#include <memory>
 
 namespace kungfu
 {
@@ -15,6 +17,7 @@ namespace kungfu
     public:
         AccountStorage(const char* account_id, const char* db_file);
 
+        // only rows changed since last save (or load) are written
         void save(int64_t last_update, const std::string& trading_day, const AccountInfo& account,
                 const std::map<std::string, double>& bond_map, const std::map<int64_t, double>& frozen_map);
         void save_meta(int64_t last_update, const std::string& trading_day);
@@ -22,9 +25,34 @@ namespace kungfu
         void load(int64_t& last_update, std::string& trading_day, AccountInfo& account,
                 std::map<std::string, double>& bond_map, std::map<int64_t, double>& frozen_map);
 
+        // rows written by last save
+        int get_last_saved_rows() const { return last_saved_rows_; }
+
+    protected:
+        void load_inner(int64_t& last_update, std::string& trading_day, AccountInfo& account,
+                std::map<std::string, double>& bond_map, std::map<int64_t, double>& frozen_map);
+        void reload_saved();
+
     protected:
         std::string account_id_;
         std::string db_file_;
+
+        // one connection for the life of the manager, statements prepared once
+        std::unique_ptr<SQLite::Database> db_;
+        std::unique_ptr<SQLite::Statement> replace_account_;
+        std::unique_ptr<SQLite::Statement> delete_account_;
+        std::unique_ptr<SQLite::Statement> replace_bond_;
+        std::unique_ptr<SQLite::Statement> delete_bond_;
+        std::unique_ptr<SQLite::Statement> replace_frozen_;
+        std::unique_ptr<SQLite::Statement> delete_frozen_;
+
+        // what the db holds now, save compares against it
+        int64_t                         saved_last_update_;
+        std::string                     saved_trading_day_;
+        AccountInfo                     saved_account_;
+        std::map<std::string, double>   saved_bond_map_;
+        std::map<int64_t, double>       saved_frozen_map_;
+        int                             last_saved_rows_;
     };
 }
 
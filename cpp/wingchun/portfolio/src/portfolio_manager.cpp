@@ -171,6 +171,16 @@ namespace kungfu
         impl_->set_static_equity(equity);
     }
 
+    void PortfolioManager::on_timer(int64_t nano)
+    {
+        impl_->on_timer(nano);
+    }
+
+    void PortfolioManager::flush()
+    {
+        impl_->flush();
+    }
+
     const PortfolioInfo* PortfolioManager::get_pnl() const
     {
         return impl_->get_pnl();
@@ -94,6 +94,8 @@ namespace kungfu
         void register_pnl_callback(PnLCallback cb) override;
         void set_initial_equity(double equity) override;
         void set_static_equity(double equity) override;
+        void on_timer(int64_t nano) override;
+        void flush() override;
         // IPnLDataHandler
 
         const PortfolioInfo* get_pnl() const;
@@ -520,6 +522,29 @@ namespace kungfu
         boost::ignore_unused(equity);
     }
 
+    void PortfolioManager::impl::on_timer(int64_t nano)
+    {
+        for (const auto& iter : accounts_)
+        {
+            if (nullptr != iter.second)
+            {
+                iter.second->on_timer(nano);
+            }
+        }
+    }
+
+    void PortfolioManager::impl::flush()
+    {
+        for (const auto& iter : accounts_)
+        {
+            if (nullptr != iter.second)
+            {
+                iter.second->flush();
+            }
+        }
+        storage_.save(last_update_, trading_day_, pnl_);
+    }
+
     bool PortfolioManager::impl::recalc_pnl()
     {
         double old_dynamic = pnl_.dynamic_equity;
@@ -260,6 +260,16 @@ namespace kungfu
         impl_->set_static_equity(equity);
     }
 
+    void PositionManager::on_timer(int64_t nano)
+    {
+        impl_->on_timer(nano);
+    }
+
+    void PositionManager::flush()
+    {
+        impl_->flush();
+    }
+
     double PositionManager::get_market_value() const
     {
         return impl_->get_market_value();
@@ -7,7 +7,9 @@
 
 #include "../include/position_manager.h"
 #include "position_storage.h"
+#include "storage_common.h"
 #include "util/include/business_helper.h"
+#include "util/include/symbol_interner.h"
 #include "util/instrument/instrument.h"
 #include "serialize.h"
 #include <spdlog/spdlog.h>
@@ -74,11 +76,14 @@ namespace kungfu
         void register_pnl_callback(PnLCallback cb) override;
         void set_initial_equity(double equity) override;
         void set_static_equity(double equity) override;
+        void on_timer(int64_t nano) override;
+        void flush() override;
         // IPnLDataHandler
 
         double get_market_value() const; // for stock only
 
     private:
+        void save();
         double choose_price(const Position& pos) const;
         bool recalc_pos_by_price(Position& pos);
         void callback(const Position& pos) const;
@@ -96,8 +101,11 @@ namespace kungfu
         int64_t                                         last_update_;
         std::string                                     trading_day_;
         PositionStorage                                 storage_;
+        SaveThrottle                                    save_throttle_;
         std::map<std::string, Position>                 long_pos_map_; // { symbol -> pos }
         std::map<std::string, Position>                 short_pos_map_; // { symbol -> pos }
+        mutable SymbolMapIndex<Position>                long_pos_index_; // per tick lookups into long_pos_map_
+        mutable SymbolMapIndex<Position>                short_pos_index_;
         std::map<std::string, std::vector<Position>>    bond_map_;  // { expire_date -> [ bond_pos ] }
         std::map<std::string, std::vector<Position>>    long_detail_map_; // { symbol -> [ detail ] }
         std::map<std::string, std::vector<Position>>    short_detail_map_; // { symbol -> [ detail ] }
@@ -106,114 +114,107 @@ namespace kungfu
     };
 
     // impl
-    PositionManager::impl::impl(const char *account_id, const char *db) : last_update_(0), storage_(account_id, db)
+    PositionManager::impl::impl(const char *account_id, const char *db) : last_update_(0), storage_(account_id, db),
+        long_pos_index_(long_pos_map_), short_pos_index_(short_pos_map_)
     {
         storage_.load(last_update_, trading_day_, long_pos_map_, short_pos_map_, bond_map_, long_detail_map_, short_detail_map_, frozen_map_);
     }
 
     PositionManager::impl::~impl()
+    {
+        save();
+    }
+
+    void PositionManager::impl::save()
     {
         storage_.save(last_update_, trading_day_, long_pos_map_, short_pos_map_, bond_map_, long_detail_map_, short_detail_map_, frozen_map_);
+        save_throttle_.saved(last_update_);
     }
 
     int64_t PositionManager::impl::get_long_tot(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.volume;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->volume;
     }
 
     int64_t PositionManager::impl::get_long_tot_avail(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : (iter->second.yesterday_volume - iter->second.frozen_total);
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : (pos->yesterday_volume - pos->frozen_total);
     }
 
     int64_t PositionManager::impl::get_long_tot_fro(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.frozen_total;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->frozen_total;
     }
 
     int64_t PositionManager::impl::get_long_yd(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.yesterday_volume;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->yesterday_volume;
     }
 
     int64_t PositionManager::impl::get_long_yd_avail(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.yesterday_volume - iter->second.frozen_yesterday;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->yesterday_volume - pos->frozen_yesterday;
     }
 
     int64_t PositionManager::impl::get_long_yd_fro(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.frozen_yesterday;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->frozen_yesterday;
     }
 
     double PositionManager::impl::get_long_realized_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.realized_pnl;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->realized_pnl;
     }
 
     double PositionManager::impl::get_long_unrealized_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.unrealized_pnl;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->unrealized_pnl;
     }
 
     double PositionManager::impl::get_long_open_price(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.open_price;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->open_price;
     }
 
     double PositionManager::impl::get_long_cost_price(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.cost_price;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->cost_price;
     }
 
     double PositionManager::impl::get_long_margin(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.margin;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->margin;
     }
 
     double PositionManager::impl::get_long_position_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.position_pnl;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->position_pnl;
     }
 
     double PositionManager::impl::get_long_close_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        return iter == long_pos_map_.end() ? 0 : iter->second.close_pnl;
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->close_pnl;
     }
 
     Position PositionManager::impl::get_long_pos(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        if (iter != long_pos_map_.end())
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        if (pos != nullptr)
         {
-            return iter->second;
+            return *pos;
         }
         else
         {
@@ -227,102 +228,88 @@ namespace kungfu
 
     int64_t PositionManager::impl::get_short_tot(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.volume;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->volume;
     }
 
     int64_t PositionManager::impl::get_short_tot_avail(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : (iter->second.volume - iter->second.frozen_total);
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : (pos->volume - pos->frozen_total);
     }
 
     int64_t PositionManager::impl::get_short_tot_fro(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.frozen_total;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->frozen_total;
     }
 
     int64_t PositionManager::impl::get_short_yd(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.yesterday_volume;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->yesterday_volume;
     }
 
     int64_t PositionManager::impl::get_short_yd_avail(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : (iter->second.yesterday_volume - iter->second.frozen_yesterday);
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : (pos->yesterday_volume - pos->frozen_yesterday);
     }
 
     int64_t PositionManager::impl::get_short_yd_fro(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.frozen_yesterday;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->frozen_yesterday;
     }
 
     double PositionManager::impl::get_short_realized_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.realized_pnl;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->realized_pnl;
     }
 
     double PositionManager::impl::get_short_unrealized_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.unrealized_pnl;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->unrealized_pnl;
     }
 
     double PositionManager::impl::get_short_open_price(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.open_price;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->open_price;
     }
 
     double PositionManager::impl::get_short_cost_price(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.cost_price;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->cost_price;
     }
 
     double PositionManager::impl::get_short_margin(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.margin;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->margin;
     }
 
     double PositionManager::impl::get_short_position_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.position_pnl;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->position_pnl;
     }
 
     double PositionManager::impl::get_short_close_pnl(const char* instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        return iter == short_pos_map_.end() ? 0 : iter->second.close_pnl;
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        return pos == nullptr ? 0 : pos->close_pnl;
     }
 
     Position PositionManager::impl::get_short_pos(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = short_pos_map_.find(key);
-        if (iter != short_pos_map_.end())
+        const Position* pos = short_pos_index_.find(instrument_id, exchange_id);
+        if (pos != nullptr)
         {
-            return iter->second;
+            return *pos;
         }
         else
         {
@@ -336,16 +323,15 @@ namespace kungfu
 
     double PositionManager::impl::get_last_price(const char *instrument_id, const char *exchange_id) const
     {
-        auto key = get_symbol(instrument_id, exchange_id);
-        auto iter = long_pos_map_.find(key);
-        if (iter != long_pos_map_.end())
+        const Position* pos = long_pos_index_.find(instrument_id, exchange_id);
+        if (pos != nullptr)
         {
-            return iter->second.last_price;
+            return pos->last_price;
         }
-        auto iter1 = short_pos_map_.find(key);
-        if (iter1 != short_pos_map_.end())
+        pos = short_pos_index_.find(instrument_id, exchange_id);
+        if (pos != nullptr)
         {
-            return iter1->second.last_price;
+            return pos->last_price;
         }
         return 0;
     }
@@ -382,12 +368,11 @@ namespace kungfu
     void PositionManager::impl::on_quote(const kungfu::Quote *quote)
     {
         last_update_ = quote->rcv_time;
-        auto key = get_symbol(quote->instrument_id, quote->exchange_id);
-        auto func = [&](std::map<std::string, Position>& m) {
-            auto long_iter = m.find(key);
-            if (long_iter != m.end())
+        auto func = [&](SymbolMapIndex<Position>& index) {
+            Position* found = index.find(quote->instrument_id, quote->exchange_id);
+            if (found != nullptr)
             {
-                auto& pos = long_iter->second;
+                auto& pos = *found;
                 if (!is_zero(quote->last_price))
                 {
                     pos.last_price = quote->last_price;
@@ -414,13 +399,21 @@ namespace kungfu
                 }
             }
         };
-        func(long_pos_map_);
-        func(short_pos_map_);
+        func(long_pos_index_);
+        func(short_pos_index_);
+        if (save_throttle_.due(last_update_))
+        {
+            save();
+        }
     }
 
     void PositionManager::impl::on_order(const kungfu::Order *order)
     {
         last_update_ = order->rcv_time;
+        if (save_throttle_.due(last_update_))
+        {
+            save();
+        }
         if (!is_final_status(order->status) || frozen_map_.find(order->order_id) == frozen_map_.end())
         {
             return;
@@ -453,8 +446,11 @@ namespace kungfu
             on_trade_future(trade);
         }
 
-        // 成交时一定写一下数据库, 解决前端切换页面时读库问题
-        storage_.save(last_update_, trading_day_, long_pos_map_, short_pos_map_, bond_map_, long_detail_map_, short_detail_map_, frozen_map_);
+        // 成交时一定写一下数据库, 解决前端切换页面时读库问题; 连续成交合并到一个时间窗口内写一次
+        if (save_throttle_.request(last_update_))
+        {
+            save();
+        }
     }
 
     void PositionManager::impl::on_positions(const vector<kungfu::Position> &positions)
@@ -501,7 +497,7 @@ namespace kungfu
                 }
             }
         }
-        storage_.save(last_update_, trading_day_, long_pos_map_, short_pos_map_, bond_map_, long_detail_map_, short_detail_map_, frozen_map_);
+        save();
     }
 
     void PositionManager::impl::on_position_details(const vector<kungfu::Position> &details)
@@ -673,7 +669,7 @@ namespace kungfu
         calc_func(long_pos_map_);
         calc_func(short_pos_map_);
 
-        storage_.save(last_update_, trading_day_, long_pos_map_, short_pos_map_, bond_map_, long_detail_map_, short_detail_map_, frozen_map_);
+        save();
     }
 
     int64_t PositionManager::impl::get_last_update() const
@@ -726,6 +722,23 @@ namespace kungfu
         boost::ignore_unused(equity);
     }
 
+    void PositionManager::impl::on_timer(int64_t nano)
+    {
+        // the last fill of a burst is written here if no event follows it
+        if (save_throttle_.due(nano))
+        {
+            save();
+        }
+    }
+
+    void PositionManager::impl::flush()
+    {
+        if (save_throttle_.pending())
+        {
+            save();
+        }
+    }
+
     double PositionManager::impl::get_market_value() const
     {
         double market_value = 0.0;
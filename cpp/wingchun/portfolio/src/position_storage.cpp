@@ -8,11 +8,31 @@
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
+#define POS_REPLACE_SQL(table) "REPLACE INTO " table "(" \
+    "rcv_time, update_time, instrument_id, instrument_type, exchange_id, account_id, client_id, " \
+    "direction, volume, yesterday_volume, frozen_total, frozen_yesterday, last_price, open_price, " \
+    "cost_price, close_price, pre_close_price, settlement_price, pre_settlement_price, margin, " \
+    "position_pnl, close_pnl, realized_pnl, unrealized_pnl, open_date, expire_date" \
+    ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+
 namespace kungfu
 {
-    PositionStorage::PositionStorage(const char *account_id, const char *db_file) : account_id_(account_id), db_file_(db_file)
+    PositionStorage::PositionStorage(const char *account_id, const char *db_file) : account_id_(account_id), db_file_(db_file),
+                                                                                     saved_last_update_(0), last_saved_rows_(0)
     {
         create_pos_tables(db_file);
+        db_ = std::unique_ptr<SQLite::Database>(new SQLite::Database(db_file_.c_str(), SQLite::OPEN_READWRITE));
+        auto& db = *db_;
+        replace_pos_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, POS_REPLACE_SQL("position")));
+        delete_pos_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db,
+                "DELETE FROM position WHERE instrument_id = ? and exchange_id = ? and instrument_type = ? and account_id = ? and client_id = ? and direction = ?"));
+        delete_bond_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM bond_position WHERE account_id = ?"));
+        insert_bond_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, POS_REPLACE_SQL("bond_position")));
+        delete_detail_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM pos_detail WHERE account_id = ?"));
+        insert_detail_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, POS_REPLACE_SQL("pos_detail")));
+        replace_frozen_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "REPLACE INTO pos_frozen(order_id, account_id, frozen_vol) VALUES(?, ?, ?)"));
+        delete_frozen_ = std::unique_ptr<SQLite::Statement>(new SQLite::Statement(db, "DELETE FROM pos_frozen WHERE order_id = ?"));
+        reload_saved();
     }
 
     void PositionStorage::save(int64_t last_update, const std::string &trading_day,
@@ -23,60 +43,69 @@ namespace kungfu
                                const std::map<std::string, std::vector<kungfu::Position>> &short_detail_map,
                                const std::map<int64_t, int64_t> &frozen_map)
     {
-        SQLite::Database db(db_file_.c_str(), SQLite::OPEN_READWRITE);
+        auto& db = *db_;
+        int rows = 0;
         db.exec("BEGIN");
         try
         {
-            db.exec(fmt::format("DELETE FROM position WHERE account_id = '{}' and instrument_type != '{}'", account_id_, InstrumentTypeFuture));
-            db.exec(fmt::format("DELETE FROM bond_position WHERE account_id = '{}'", account_id_));
-            db.exec(fmt::format("DELETE FROM pos_frozen WHERE account_id = '{}'", account_id_));
+            rows += save_pos_map(long_pos_map, saved_long_pos_map_);
+            rows += save_pos_map(short_pos_map, saved_short_pos_map_);
 
-            for (const auto& iter : long_pos_map)
+            // bond and detail rows have no key, rewrite the account's rows once anything changed
+            if (!same_pos_list_map(bond_map, saved_bond_map_))
             {
-                save_single_pos(db, "position", iter.second);
+                rows += save_pos_list(*delete_bond_, *insert_bond_, bond_map);
+                saved_bond_map_ = bond_map;
             }
-            for (const auto& iter : short_pos_map)
+            if (!same_pos_list_map(long_detail_map, saved_long_detail_map_) || !same_pos_list_map(short_detail_map, saved_short_detail_map_))
             {
-                save_single_pos(db, "position", iter.second);
-            }
-
-            for (const auto& iter : bond_map)
-            {
-                for (const auto& bond : iter.second)
-                {
-                    save_single_pos(db, "bond_position", bond);
-                }
+                rows += save_pos_list(*delete_detail_, *insert_detail_, long_detail_map);
+                rows += insert_pos_list(*insert_detail_, short_detail_map);
+                saved_long_detail_map_ = long_detail_map;
+                saved_short_detail_map_ = short_detail_map;
             }
 
-            for (const auto& iter : long_detail_map)
+            for (const auto& iter : frozen_map)
             {
-                for (const auto& detail : iter.second)
+                auto saved = saved_frozen_map_.find(iter.first);
+                if (saved == saved_frozen_map_.end() || saved->second != iter.second)
                 {
-                    save_single_pos(db, "pos_detail", detail);
+                    replace_frozen_->reset();
+                    replace_frozen_->bind(1, (long long)iter.first);
+                    replace_frozen_->bind(2, account_id_);
+                    replace_frozen_->bind(3, (long long)iter.second);
+                    replace_frozen_->exec();
+                    rows++;
                 }
             }
-            for (const auto& iter : short_detail_map)
+            for (const auto& iter : saved_frozen_map_)
             {
-                for (const auto& detail : iter.second)
+                if (frozen_map.find(iter.first) == frozen_map.end())
                 {
-                    save_single_pos(db, "pos_detail", detail);
+                    delete_frozen_->reset();
+                    delete_frozen_->bind(1, (long long)iter.first);
+                    delete_frozen_->exec();
+                    rows++;
                 }
             }
+            saved_frozen_map_ = frozen_map;
 
-            for (const auto& iter : frozen_map)
+            if (last_update != saved_last_update_ || trading_day != saved_trading_day_)
             {
-                db.exec(fmt::format("INSERT INTO pos_frozen(order_id, account_id, frozen_vol) VALUES({}, '{}', {})",
-                        iter.first, account_id_, iter.second));
+                save_meta_inner(db, last_update, trading_day);
+                saved_last_update_ = last_update;
+                saved_trading_day_ = trading_day;
             }
 
-            save_meta_inner(db, last_update, trading_day);
-
             db.exec("COMMIT");
         } catch (std::exception& e)
         {
             SPDLOG_ERROR(e.what());
             db.exec("ROLLBACK");
+            // saved state was updated along the way, take it from db again
+            reload_saved();
         }
+        last_saved_rows_ = rows;
     }
 
     void PositionStorage::load(int64_t &last_update, std::string &trading_day,
@@ -87,7 +116,96 @@ namespace kungfu
                                std::map<std::string, std::vector<kungfu::Position>> &short_detail_map,
                                std::map<int64_t, int64_t> &frozen_map)
     {
-        SQLite::Database db(db_file_.c_str(), SQLite::OPEN_READONLY);
+        reload_saved();
+        last_update = saved_last_update_;
+        trading_day = saved_trading_day_;
+        long_pos_map = saved_long_pos_map_;
+        short_pos_map = saved_short_pos_map_;
+        bond_map = saved_bond_map_;
+        long_detail_map = saved_long_detail_map_;
+        short_detail_map = saved_short_detail_map_;
+        frozen_map = saved_frozen_map_;
+    }
+
+    void PositionStorage::reload_saved()
+    {
+        load_inner(saved_last_update_, saved_trading_day_, saved_long_pos_map_, saved_short_pos_map_, saved_bond_map_,
+                   saved_long_detail_map_, saved_short_detail_map_, saved_frozen_map_);
+    }
+
+    int PositionStorage::save_pos_map(const std::map<std::string, Position>& pos_map, std::map<std::string, Position>& saved_map)
+    {
+        int rows = 0;
+        for (const auto& iter : pos_map)
+        {
+            auto saved = saved_map.find(iter.first);
+            if (saved == saved_map.end() || !same_pos(saved->second, iter.second))
+            {
+                replace_pos_->reset();
+                bind_single_pos(*replace_pos_, iter.second);
+                replace_pos_->exec();
+                saved_map[iter.first] = iter.second;
+                rows++;
+            }
+        }
+        for (auto iter = saved_map.begin(); iter != saved_map.end();)
+        {
+            // future rows are kept as before, they are only replaced
+            if (pos_map.find(iter->first) == pos_map.end() && iter->second.instrument_type != InstrumentTypeFuture)
+            {
+                const auto& pos = iter->second;
+                delete_pos_->reset();
+                delete_pos_->bind(1, pos.instrument_id);
+                delete_pos_->bind(2, pos.exchange_id);
+                delete_pos_->bind(3, std::string(1, pos.instrument_type));
+                delete_pos_->bind(4, pos.account_id);
+                delete_pos_->bind(5, pos.client_id);
+                delete_pos_->bind(6, std::string(1, pos.direction));
+                delete_pos_->exec();
+                iter = saved_map.erase(iter);
+                rows++;
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+        return rows;
+    }
+
+    int PositionStorage::save_pos_list(SQLite::Statement& del, SQLite::Statement& insert, const std::map<std::string, std::vector<Position>>& pos_list_map)
+    {
+        del.reset();
+        del.bind(1, account_id_);
+        del.exec();
+        return insert_pos_list(insert, pos_list_map);
+    }
+
+    int PositionStorage::insert_pos_list(SQLite::Statement& insert, const std::map<std::string, std::vector<Position>>& pos_list_map)
+    {
+        int rows = 0;
+        for (const auto& iter : pos_list_map)
+        {
+            for (const auto& pos : iter.second)
+            {
+                insert.reset();
+                bind_single_pos(insert, pos);
+                insert.exec();
+                rows++;
+            }
+        }
+        return rows;
+    }
+
+    void PositionStorage::load_inner(int64_t &last_update, std::string &trading_day,
+                                     std::map<std::string, kungfu::Position> &long_pos_map,
+                                     std::map<std::string, kungfu::Position> &short_pos_map,
+                                     std::map<std::string, std::vector<kungfu::Position>> &bond_map,
+                                     std::map<std::string, std::vector<kungfu::Position>> &long_detail_map,
+                                     std::map<std::string, std::vector<kungfu::Position>> &short_detail_map,
+                                     std::map<int64_t, int64_t> &frozen_map)
+    {
+        auto& db = *db_;
         db.exec("BEGIN");
         try
         {
@@ -149,22 +267,34 @@ namespace kungfu
         }
     }
 
-    void PositionStorage::save_single_pos(SQLite::Database &db, const char *table, const kungfu::Position &pos)
+    void PositionStorage::bind_single_pos(SQLite::Statement &stmt, const kungfu::Position &pos)
     {
-        std::string s =fmt::format("REPLACE INTO {}("
-                                   "rcv_time, update_time, instrument_id, instrument_type, exchange_id, account_id, client_id, "
-                                   "direction, volume, yesterday_volume, frozen_total, frozen_yesterday, last_price, open_price, "
-                                   "cost_price, close_price, pre_close_price, settlement_price, pre_settlement_price, margin, "
-                                   "position_pnl, close_pnl, realized_pnl, unrealized_pnl, open_date, expire_date"
-                                   ") "
-                                   "VALUES({},{},'{}','{}','{}','{}','{}','{}',{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},'{}','{}')",
-                                   table, pos.rcv_time, pos.update_time, pos.instrument_id, pos.instrument_type, pos.exchange_id,
-                                   pos.account_id, pos.client_id, pos.direction, pos.volume, pos.yesterday_volume, pos.frozen_total,
-                                   pos.frozen_yesterday, pos.last_price, pos.open_price, pos.cost_price, pos.close_price,
-                                   pos.pre_close_price, pos.settlement_price, pos.pre_settlement_price, pos.margin, pos.position_pnl,
-                                   pos.close_pnl, pos.realized_pnl, pos.unrealized_pnl, pos.open_date, pos.expire_date);
-
-        db.exec(s);
+        stmt.bind(1, (long long)pos.rcv_time);
+        stmt.bind(2, (long long)pos.update_time);
+        stmt.bind(3, pos.instrument_id);
+        stmt.bind(4, std::string(1, pos.instrument_type));
+        stmt.bind(5, pos.exchange_id);
+        stmt.bind(6, pos.account_id);
+        stmt.bind(7, pos.client_id);
+        stmt.bind(8, std::string(1, pos.direction));
+        stmt.bind(9, (long long)pos.volume);
+        stmt.bind(10, (long long)pos.yesterday_volume);
+        stmt.bind(11, (long long)pos.frozen_total);
+        stmt.bind(12, (long long)pos.frozen_yesterday);
+        stmt.bind(13, pos.last_price);
+        stmt.bind(14, pos.open_price);
+        stmt.bind(15, pos.cost_price);
+        stmt.bind(16, pos.close_price);
+        stmt.bind(17, pos.pre_close_price);
+        stmt.bind(18, pos.settlement_price);
+        stmt.bind(19, pos.pre_settlement_price);
+        stmt.bind(20, pos.margin);
+        stmt.bind(21, pos.position_pnl);
+        stmt.bind(22, pos.close_pnl);
+        stmt.bind(23, pos.realized_pnl);
+        stmt.bind(24, pos.unrealized_pnl);
+        stmt.bind(25, pos.open_date);
+        stmt.bind(26, pos.expire_date);
     }
 
     void PositionStorage::load_single_pos(SQLite::Statement &query, kungfu::Position &pos)
@@ -9,6 +9,7 @@
 #include <SQLiteCpp/SQLiteCpp.h>
 #include <map>
 #include <vector>
+#include <memory>
 
 namespace kungfu
 {
@@ -17,6 +18,7 @@ namespace kungfu
     public:
         PositionStorage(const char* account_id, const char* db_file);
 
+        // only rows changed since last save (or load) are written
         void save(int64_t last_update,
                   const std::string& trading_day,
                   const std::map<std::string, Position>& long_pos_map,
@@ -35,8 +37,24 @@ namespace kungfu
                   std::map<std::string, std::vector<Position>>& short_detail_map,
                   std::map<int64_t, int64_t>& frozen_map);
 
+        // rows written by last save
+        int get_last_saved_rows() const { return last_saved_rows_; }
+
     protected:
-        static void save_single_pos(SQLite::Database& db, const char* table, const Position& pos);
+        void load_inner(int64_t& last_update,
+                        std::string& trading_day,
+                        std::map<std::string, Position>& long_pos_map,
+                        std::map<std::string, Position>& short_pos_map,
+                        std::map<std::string, std::vector<Position>>& bond_map,
+                        std::map<std::string, std::vector<Position>>& long_detail_map,
+                        std::map<std::string, std::vector<Position>>& short_detail_map,
+                        std::map<int64_t, int64_t>& frozen_map);
+        void reload_saved();
+        int save_pos_map(const std::map<std::string, Position>& pos_map, std::map<std::string, Position>& saved_map);
+        int save_pos_list(SQLite::Statement& del, SQLite::Statement& insert, const std::map<std::string, std::vector<Position>>& pos_list_map);
+        int insert_pos_list(SQLite::Statement& insert, const std::map<std::string, std::vector<Position>>& pos_list_map);
+
+        static void bind_single_pos(SQLite::Statement& stmt, const Position& pos);
         static void load_single_pos(SQLite::Statement& query, Position& pos);
         static void save_meta_inner(SQLite::Database& db, int64_t last_update, const std::string& trading_day);
         static void load_meta_inner(SQLite::Database& db, int64_t& last_update, std::string& trading_day);
@@ -44,6 +62,28 @@ namespace kungfu
     protected:
         std::string account_id_;
         std::string db_file_;
+
+        // one connection for the life of the manager, statements prepared once
+        std::unique_ptr<SQLite::Database> db_;
+        std::unique_ptr<SQLite::Statement> replace_pos_;
+        std::unique_ptr<SQLite::Statement> delete_pos_;
+        std::unique_ptr<SQLite::Statement> delete_bond_;
+        std::unique_ptr<SQLite::Statement> insert_bond_;
+        std::unique_ptr<SQLite::Statement> delete_detail_;
+        std::unique_ptr<SQLite::Statement> insert_detail_;
+        std::unique_ptr<SQLite::Statement> replace_frozen_;
+        std::unique_ptr<SQLite::Statement> delete_frozen_;
+
+        // what the db holds now, save compares against it
+        int64_t                                         saved_last_update_;
+        std::string                                     saved_trading_day_;
+        std::map<std::string, Position>                 saved_long_pos_map_;
+        std::map<std::string, Position>                 saved_short_pos_map_;
+        std::map<std::string, std::vector<Position>>    saved_bond_map_;
+        std::map<std::string, std::vector<Position>>    saved_long_detail_map_;
+        std::map<std::string, std::vector<Position>>    saved_short_detail_map_;
+        std::map<int64_t, int64_t>                      saved_frozen_map_;
+        int                                             last_saved_rows_;
     };
 }
 
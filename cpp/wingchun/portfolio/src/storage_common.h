@@ -5,12 +5,86 @@
 #ifndef KUNGFU_STORAGE_COMMON_H
 #define KUNGFU_STORAGE_COMMON_H
 
+#include "oms_struct.h"
+#include "../include/pnl_def.h"
 #include <SQLiteCpp/SQLiteCpp.h>
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
+#include <cstring>
+#include <algorithm>
+#include <map>
 
 namespace kungfu
 {
+    // columns stored in position tables, padding bytes and trading_day are not compared
+    inline bool same_pos(const Position& a, const Position& b)
+    {
+        return a.rcv_time == b.rcv_time && a.update_time == b.update_time
+               && strcmp(a.instrument_id, b.instrument_id) == 0 && a.instrument_type == b.instrument_type
+               && strcmp(a.exchange_id, b.exchange_id) == 0 && strcmp(a.account_id, b.account_id) == 0
+               && strcmp(a.client_id, b.client_id) == 0 && a.direction == b.direction
+               && a.volume == b.volume && a.yesterday_volume == b.yesterday_volume
+               && a.frozen_total == b.frozen_total && a.frozen_yesterday == b.frozen_yesterday
+               && a.last_price == b.last_price && a.open_price == b.open_price && a.cost_price == b.cost_price
+               && a.close_price == b.close_price && a.pre_close_price == b.pre_close_price
+               && a.settlement_price == b.settlement_price && a.pre_settlement_price == b.pre_settlement_price
+               && a.margin == b.margin && a.position_pnl == b.position_pnl && a.close_pnl == b.close_pnl
+               && a.realized_pnl == b.realized_pnl && a.unrealized_pnl == b.unrealized_pnl
+               && strcmp(a.open_date, b.open_date) == 0 && strcmp(a.expire_date, b.expire_date) == 0;
+    }
+
+    inline bool same_pos_list_map(const std::map<std::string, std::vector<Position>>& a, const std::map<std::string, std::vector<Position>>& b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib)
+        {
+            if (ia->first != ib->first || !std::equal(ia->second.begin(), ia->second.end(), ib->second.begin(), ib->second.end(), same_pos))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // saves asked for within PNL_SAVE_INTERVAL_NANO (pnl_def.h) of the last one are held back,
+    // the next event or on_timer after the interval writes them, flush / exit writes them at once
+    class SaveThrottle
+    {
+    public:
+        SaveThrottle(): pending_(false), last_save_nano_(0) {}
+
+        // data changed at nano, true if it should be saved right now
+        bool request(int64_t nano)
+        {
+            pending_ = true;
+            return due(nano);
+        }
+
+        // true if a held back save should be done at nano
+        bool due(int64_t nano) const
+        {
+            return pending_ && (nano - last_save_nano_ >= PNL_SAVE_INTERVAL_NANO || nano < last_save_nano_);
+        }
+
+        bool pending() const
+        {
+            return pending_;
+        }
+
+        void saved(int64_t nano)
+        {
+            pending_ = false;
+            last_save_nano_ = nano;
+        }
+
+    private:
+        bool pending_;
+        int64_t last_save_nano_;
+    };
+
     inline void create_pos_tables(const char *db_file)
     {
         static std::string pos_columns = "rcv_time INTEGER, "
@@ -10,9 +10,41 @@ namespace kungfu
 {
     namespace storage
     {
+        static void bind_order(SQLite::Statement& insert, const Order& order)
+        {
+            insert.bind(1, std::to_string(order.order_id));
+            insert.bind(2, (long long)order.rcv_time);
+            insert.bind(3, order.insert_time);
+            insert.bind(4, order.update_time);
+            insert.bind(5, order.trading_day);
+            insert.bind(6, order.instrument_id);
+            insert.bind(7, order.exchange_id);
+            insert.bind(8, order.account_id);
+            insert.bind(9, order.client_id);
+            insert.bind(10, std::string(1, order.instrument_type));
+            insert.bind(11, order.limit_price);
+            insert.bind(12, order.frozen_price);
+            insert.bind(13, order.volume);
+            insert.bind(14, order.volume_traded);
+            insert.bind(15, order.volume_left);
+            insert.bind(16, order.tax);
+            insert.bind(17, order.commission);
+            insert.bind(18, std::string(1, order.status));
+            insert.bind(19, order.error_id);
+            insert.bind(20, order.error_msg);
+            insert.bind(21, std::string(1, order.side));
+            insert.bind(22, std::string(1, order.offset));
+            insert.bind(23, std::string(1, order.price_type));
+            insert.bind(24, std::string(1, order.volume_condition));
+            insert.bind(25, std::string(1, order.time_condition));
+            insert.bind(26, std::to_string(order.parent_id));
+        }
+
         OrderStorage::OrderStorage(const std::string& file_path) : db_(file_path.c_str(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
         {
             create_table_if_not_exist();
+            writer_ = std::unique_ptr<WriteBehindQueue<Order>>(new WriteBehindQueue<Order>(db_,
+                    "INSERT OR REPLACE INTO orders VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", bind_order, "orders"));
         }
 
         void OrderStorage::create_table_if_not_exist()
@@ -56,46 +88,23 @@ namespace kungfu
 
         void OrderStorage::add_order(uint64_t order_id, const Order &order)
         {
-            try
-            {
-                SQLite::Statement insert(db_, "INSERT OR REPLACE INTO orders VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                insert.bind(1, std::to_string(order.order_id));
-                insert.bind(2, (long long)order.rcv_time);
-                insert.bind(3, order.insert_time);
-                insert.bind(4, order.update_time);
-                insert.bind(5, order.trading_day);
-                insert.bind(6, order.instrument_id);
-                insert.bind(7, order.exchange_id);
-                insert.bind(8, order.account_id);
-                insert.bind(9, order.client_id);
-                insert.bind(10, std::string(1, order.instrument_type));
-                insert.bind(11, order.limit_price);
-                insert.bind(12, order.frozen_price);
-                insert.bind(13, order.volume);
-                insert.bind(14, order.volume_traded);
-                insert.bind(15, order.volume_left);
-                insert.bind(16, order.tax);
-                insert.bind(17, order.commission);
-                insert.bind(18, std::string(1, order.status));
-                insert.bind(19, order.error_id);
-                insert.bind(20, order.error_msg);
-                insert.bind(21, std::string(1, order.side));
-                insert.bind(22, std::string(1, order.offset));
-                insert.bind(23, std::string(1, order.price_type));
-                insert.bind(24, std::string(1, order.volume_condition));
-                insert.bind(25, std::string(1, order.time_condition));
-                insert.bind(26, std::to_string(order.parent_id));
-                insert.exec();
-            }
-            catch (std::exception &e)
-            {
-                SPDLOG_ERROR("failed to add order[{}], exception: {}", to_string(order), e.what());
-            }
+            writer_->push(order);
+        }
+
+        void OrderStorage::flush()
+        {
+            writer_->flush();
+        }
+
+        WriteBehindStats OrderStorage::get_stats() const
+        {
+            return writer_->get_stats();
         }
 
         const Order OrderStorage::get_order(uint64_t order_id)
         {
             Order result = {};
+            flush();
             try
             {
                 SQLite::Statement query(db_, "SELECT * FROM orders WHERE order_id = ?");
@@ -6,8 +6,10 @@
 #define KUNGFU_ORDER_STORAGE_H
 
 #include <string>
+#include <memory>
 #include <SQLiteCpp/SQLiteCpp.h>
 #include "oms_struct.h"
+#include "write_behind.h"
 
 namespace kungfu
 {
@@ -18,10 +20,15 @@ namespace kungfu
         public:
             OrderStorage(const std::string& file_path);
             void create_table_if_not_exist();
+            // queued, inserted by the write behind thread
             void add_order(uint64_t order_id, const Order &order);
             const Order get_order(uint64_t order_id);
+            // block until queued orders are committed
+            void flush();
+            WriteBehindStats get_stats() const;
         private:
             SQLite::Database db_;
+            std::unique_ptr<WriteBehindQueue<Order>> writer_;
         };
     }
 }
@@ -0,0 +1,106 @@
+//
+// OrderStorage benchmark.
+// time add_order on the caller thread with an autocommit insert per order (the old path)
+// and with the write behind queue, then flush and check every order is stored.
+// usage: bench_order_storage [order_num]
+//
+
+#include "storage/order_storage.h"
+
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline Order make_order(uint64_t order_id)
+{
+    Order order = {};
+    order.order_id = order_id;
+    strcpy(order.instrument_id, "600000");
+    strcpy(order.exchange_id, EXCHANGE_SSE);
+    strcpy(order.account_id, "15040900");
+    order.limit_price = 11.23;
+    order.volume = order.volume_left = 300;
+    order.status = OrderStatusSubmitted;
+    return order;
+}
+
+void report(const std::string& name, std::vector<int64_t>& latencies, int64_t stored)
+{
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name
+              << " (p50 ns) " << latencies[latencies.size() / 2]
+              << " (p99 ns) " << latencies[latencies.size() * 99 / 100]
+              << " (max ns) " << latencies.back()
+              << " (stored) " << stored << std::endl;
+}
+
+int64_t count_orders(const std::string& file)
+{
+    SQLite::Database db(file.c_str(), SQLite::OPEN_READONLY);
+    return db.execAndGet("SELECT COUNT(*) FROM orders").getInt64();
+}
+
+int main(int argc, char** argv)
+{
+    int order_num = (argc > 1) ? atoi(argv[1]) : 2000;
+    std::string file = "/tmp/bench_order_storage." + std::to_string(getpid()) + ".db";
+    std::vector<int64_t> latencies(order_num);
+    std::cout << "(orders) " << order_num << std::endl;
+
+    {
+        std::remove(file.c_str());
+        storage::OrderStorage order_storage(file);
+        order_storage.flush();
+        SQLite::Database db(file.c_str(), SQLite::OPEN_READWRITE);
+        for (int i = 0; i < order_num; i++)
+        {
+            Order order = make_order(i + 1);
+            int64_t start = now_nano();
+            SQLite::Statement insert(db, "INSERT OR REPLACE INTO orders (order_id, instrument_id, limit_price, volume) VALUES(?, ?, ?, ?)");
+            insert.bind(1, std::to_string(order.order_id));
+            insert.bind(2, order.instrument_id);
+            insert.bind(3, order.limit_price);
+            insert.bind(4, order.volume);
+            insert.exec();
+            latencies[i] = now_nano() - start;
+        }
+        report("[autocommit  ]", latencies, count_orders(file));
+    }
+
+    {
+        std::remove(file.c_str());
+        storage::OrderStorage order_storage(file);
+        for (int i = 0; i < order_num; i++)
+        {
+            Order order = make_order(i + 1);
+            int64_t start = now_nano();
+            order_storage.add_order(order.order_id, order);
+            latencies[i] = now_nano() - start;
+        }
+        int64_t start = now_nano();
+        order_storage.flush();
+        int64_t flush_ns = now_nano() - start;
+        storage::WriteBehindStats stats = order_storage.get_stats();
+        report("[write behind]", latencies, count_orders(file));
+        std::cout << "               (flush ns) " << flush_ns
+                  << " (batches) " << stats.batches
+                  << " (max queue) " << stats.max_queue_depth
+                  << " (avg commit ns) " << (stats.batches > 0 ? stats.total_commit_ns / stats.batches : 0)
+                  << " (max commit ns) " << stats.max_commit_ns << std::endl;
+        Order back = order_storage.get_order(order_num);
+        std::cout << "               (get_order) " << (back.order_id == (uint64_t)order_num && back.volume == 300 ? "ok" : "FAILED") << std::endl;
+    }
+
+    std::remove(file.c_str());
+    return 0;
+}
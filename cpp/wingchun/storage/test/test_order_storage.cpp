@@ -2,7 +2,95 @@
 // Created by qlu on 2019/3/22.
 //
 
-int main()
+#include "gtest/gtest.h"
+#include "storage/order_storage.h"
+#include "storage/trade_storage.h"
+
+#include <thread>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace kungfu;
+
+static Order make_order(uint64_t order_id)
+{
+    Order order = {};
+    order.order_id = order_id;
+    strcpy(order.instrument_id, "600000");
+    strcpy(order.exchange_id, EXCHANGE_SSE);
+    strcpy(order.account_id, "15040900");
+    order.limit_price = 11.23;
+    order.volume = order.volume_left = 300;
+    order.status = OrderStatusSubmitted;
+    return order;
+}
+
+static int64_t count_rows(const std::string& file, const std::string& table)
+{
+    SQLite::Database db(file.c_str(), SQLite::OPEN_READONLY);
+    return db.execAndGet("SELECT COUNT(*) FROM " + table).getInt64();
+}
+
+// order updates arrive from the event loop (insert_order) and the XTP callback thread (OnOrderEvent)
+TEST(OrderStorageTest, TwoProducers)
+{
+    const int order_num = 20000;
+    std::string file = "/tmp/test_order_storage." + std::to_string(getpid()) + ".db";
+    {
+        storage::OrderStorage order_storage(file);
+        auto produce = [&](uint64_t first)
+        {
+            for (uint64_t i = first; i < order_num; i += 2)
+            {
+                order_storage.add_order(i + 1, make_order(i + 1));
+            }
+        };
+        std::thread loop_thread(produce, 0);
+        std::thread callback_thread(produce, 1);
+        loop_thread.join();
+        callback_thread.join();
+        order_storage.flush();
+
+        EXPECT_EQ(order_storage.get_stats().pushed, order_num);
+        EXPECT_EQ(order_storage.get_stats().failed, 0);
+        EXPECT_EQ(order_storage.get_order(order_num).order_id, order_num);
+    }
+    EXPECT_EQ(count_rows(file, "orders"), order_num);
+    std::remove(file.c_str());
+}
+
+TEST(TradeStorageTest, TwoProducers)
 {
+    const int trade_num = 20000;
+    std::string file = "/tmp/test_trade_storage." + std::to_string(getpid()) + ".db";
+    {
+        storage::TradeStorage trade_storage(file);
+        auto produce = [&]()
+        {
+            Trade trade = {};
+            strcpy(trade.instrument_id, "600000");
+            trade.volume = 100;
+            for (int i = 0; i < trade_num / 2; i++)
+            {
+                trade.order_id = i + 1;
+                trade_storage.add_trade(trade);
+            }
+        };
+        std::thread loop_thread(produce);
+        std::thread callback_thread(produce);
+        loop_thread.join();
+        callback_thread.join();
+        trade_storage.flush();
+
+        // a duplicated id would fail the primary key and be counted here
+        EXPECT_EQ(trade_storage.get_stats().failed, 0);
+    }
+    EXPECT_EQ(count_rows(file, "trade"), trade_num);
+    std::remove(file.c_str());
+}
 
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
 }
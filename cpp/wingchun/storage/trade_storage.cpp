@@ -10,9 +10,39 @@ namespace kungfu
 {
     namespace storage
     {
-        TradeStorage::TradeStorage(const std::string &file_path) : db_(file_path.c_str(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE)
+        static void bind_trade(SQLite::Statement& insert, const Trade& trade)
+        {
+            insert.bind(1, (long long)trade.id);
+            insert.bind(2, std::to_string(trade.order_id));
+            insert.bind(3, trade.trade_time);
+            insert.bind(4, trade.instrument_id);
+            insert.bind(5, trade.exchange_id);
+            insert.bind(6, trade.account_id);
+            insert.bind(7, trade.client_id);
+            insert.bind(8, std::string(1, trade.instrument_type));
+            insert.bind(9, std::string(1, trade.side));
+            insert.bind(10, std::string(1, trade.offset));
+            insert.bind(11, trade.price);
+            insert.bind(12, trade.volume);
+            insert.bind(13, trade.tax);
+            insert.bind(14, trade.commission);
+        }
+
+        TradeStorage::TradeStorage(const std::string &file_path) : db_(file_path.c_str(), SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE), next_id_(1)
         {
             create_table_if_not_exist();
+            try
+            {
+                // this process is the only writer of the file, ids continue from what is stored
+                next_id_ = db_.execAndGet("SELECT IFNULL(MAX(id), 0) FROM trade").getInt64() + 1;
+            }
+            catch (std::exception &e)
+            {
+                SPDLOG_ERROR("failed to get max trade id, exception: {}", e.what());
+            }
+            writer_ = std::unique_ptr<WriteBehindQueue<Trade>>(new WriteBehindQueue<Trade>(db_,
+                    "INSERT INTO trade (id, order_id, trade_time, instrument_id, exchange_id, account_id, client_id, instrument_type, side, offset, price, volume, tax, commission)"
+                    " VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", bind_trade, "trade"));
         }
 
         void TradeStorage::create_table_if_not_exist()
@@ -44,31 +74,20 @@ namespace kungfu
 
         long long TradeStorage::add_trade(const Trade &trade)
         {
-            try
-            {
-                SQLite::Statement insert(db_, "INSERT INTO trade (order_id, trade_time, instrument_id, exchange_id, account_id, client_id, instrument_type, side, offset, price, volume, tax, commission)"
-                        " VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-                insert.bind(1, std::to_string(trade.order_id));
-                insert.bind(2, trade.trade_time);
-                insert.bind(3, trade.instrument_id);
-                insert.bind(4, trade.exchange_id);
-                insert.bind(5, trade.account_id);
-                insert.bind(6, trade.client_id);
-                insert.bind(7, std::string(1, trade.instrument_type));
-                insert.bind(8, std::string(1, trade.side));
-                insert.bind(9, std::string(1, trade.offset));
-                insert.bind(10, trade.price);
-                insert.bind(11, trade.volume);
-                insert.bind(12, trade.tax);
-                insert.bind(13, trade.commission);
-                insert.exec();
-                return  db_.getLastInsertRowid();
-            }
-            catch (std::exception &e)
-            {
-                SPDLOG_ERROR("failed to insert trade[{}], exception: {}\n", to_string(trade) ,e.what());
-                return 0;
-            }
+            Trade record = trade;
+            record.id = next_id_.fetch_add(1);
+            writer_->push(record);
+            return record.id;
+        }
+
+        void TradeStorage::flush()
+        {
+            writer_->flush();
+        }
+
+        WriteBehindStats TradeStorage::get_stats() const
+        {
+            return writer_->get_stats();
         }
     }
 }
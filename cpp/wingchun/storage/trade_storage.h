@@ -6,9 +6,12 @@
 #define KUNGFU_TRADE_STORAGE_H
 
 #include <string>
+#include <memory>
+#include <atomic>
 #include <SQLiteCpp/SQLiteCpp.h>
 
 #include "oms_struct.h"
+#include "write_behind.h"
 
 namespace kungfu
 {
@@ -19,9 +22,15 @@ namespace kungfu
         public:
             TradeStorage(const std::string& file_path);
             void create_table_if_not_exist();
+            // trade id is assigned here, the insert is queued to the write behind thread
             long long add_trade(const Trade &trade);
+            // block until queued trades are committed
+            void flush();
+            WriteBehindStats get_stats() const;
         private:
             SQLite::Database db_;
+            std::atomic<long long> next_id_;
+            std::unique_ptr<WriteBehindQueue<Trade>> writer_;
         };
     }
 }
@@ -0,0 +1,251 @@
+//
+// Write-behind persistence for records inserted on the event loop thread.
+//
+
+#ifndef KUNGFU_WRITE_BEHIND_H
+#define KUNGFU_WRITE_BEHIND_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <condition_variable>
+#include <SQLiteCpp/SQLiteCpp.h>
+#include <spdlog/spdlog.h>
+
+namespace kungfu
+{
+    namespace storage
+    {
+#define WRITE_BEHIND_QUEUE_CAPACITY 8192 // records, power of 2
+#define WRITE_BEHIND_MAX_BATCH 1024 // records committed in one transaction at most
+#define WRITE_BEHIND_IDLE_WAIT_MS 100 // writer thread wakes up at least this often
+
+        struct WriteBehindStats
+        {
+            int64_t pushed;             // records queued since start
+            int64_t committed;          // records committed
+            int64_t failed;             // records dropped by insert or commit errors
+            int64_t batches;            // transactions committed
+            int64_t queue_depth;        // records waiting now
+            int64_t max_queue_depth;    // highest queue depth seen
+            int64_t full_waits;         // pushes blocked by a full queue
+            int64_t last_commit_ns;     // latency of last transaction, begin to commit
+            int64_t max_commit_ns;
+            int64_t total_commit_ns;
+        };
+
+        // bounded multi producer single consumer queue, drained by a writer thread
+        // which inserts with one cached statement and group commits whatever is queued.
+        // producers (event loop and gateway callback threads) are serialized by push_mutex_,
+        // records are never dropped: a full queue blocks the producer.
+        template <typename T>
+        class WriteBehindQueue
+        {
+        public:
+            typedef std::function<void(SQLite::Statement&, const T&)> Binder;
+
+            WriteBehindQueue(SQLite::Database& db, const std::string& sql, Binder binder, const std::string& name,
+                             size_t capacity = WRITE_BEHIND_QUEUE_CAPACITY, size_t max_batch = WRITE_BEHIND_MAX_BATCH):
+                    db_(db), insert_(db, sql), binder_(binder), name_(name), ring_(capacity), mask_(capacity - 1), max_batch_(max_batch),
+                    head_(0), tail_(0), sleeping_(false), running_(true), done_(0), failed_(0), batches_(0), max_depth_(0), full_waits_(0),
+                    last_commit_ns_(0), max_commit_ns_(0), total_commit_ns_(0)
+            {
+                if (capacity == 0 || (capacity & mask_) != 0)
+                {
+                    throw std::invalid_argument("write behind queue capacity must be power of 2");
+                }
+                thread_ = std::thread(&WriteBehindQueue::run, this);
+            }
+
+            ~WriteBehindQueue()
+            {
+                stop();
+            }
+
+            void push(const T& record)
+            {
+                std::lock_guard<std::mutex> push_lock(push_mutex_);
+                uint64_t tail = tail_.load(std::memory_order_relaxed);
+                if (tail - head_.load(std::memory_order_acquire) > mask_)
+                {
+                    full_waits_++;
+                    wake();
+                    while (tail - head_.load(std::memory_order_acquire) > mask_)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                ring_[tail & mask_] = record;
+                tail_.store(tail + 1, std::memory_order_seq_cst);
+                int64_t depth = tail + 1 - head_.load(std::memory_order_relaxed);
+                if (depth > max_depth_.load(std::memory_order_relaxed))
+                {
+                    max_depth_.store(depth, std::memory_order_relaxed);
+                }
+                if (sleeping_.load(std::memory_order_seq_cst))
+                {
+                    wake();
+                }
+            }
+
+            // block until every record pushed so far is committed (or failed)
+            void flush()
+            {
+                uint64_t target = tail_.load(std::memory_order_acquire);
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.notify_one();
+                flushed_cv_.wait(lock, [&]{ return done_.load() >= target || !thread_.joinable(); });
+            }
+
+            // drain what is queued and join the writer thread, called on shutdown
+            void stop()
+            {
+                if (!thread_.joinable())
+                {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    running_ = false;
+                }
+                cv_.notify_one();
+                thread_.join();
+                flushed_cv_.notify_all();
+                SPDLOG_INFO("{} write behind stopped, committed {} failed {} batches {}", name_, done_.load() - failed_.load(), failed_.load(), batches_.load());
+            }
+
+            WriteBehindStats get_stats() const
+            {
+                WriteBehindStats stats = {};
+                stats.pushed = tail_.load();
+                stats.failed = failed_.load();
+                stats.committed = done_.load() - stats.failed;
+                stats.batches = batches_.load();
+                stats.queue_depth = stats.pushed - head_.load();
+                stats.max_queue_depth = max_depth_.load();
+                stats.full_waits = full_waits_.load();
+                stats.last_commit_ns = last_commit_ns_.load();
+                stats.max_commit_ns = max_commit_ns_.load();
+                stats.total_commit_ns = total_commit_ns_.load();
+                return stats;
+            }
+
+        private:
+            void wake()
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cv_.notify_one();
+            }
+
+            void run()
+            {
+                while (true)
+                {
+                    uint64_t head = head_.load(std::memory_order_relaxed);
+                    uint64_t tail = tail_.load(std::memory_order_acquire);
+                    if (head == tail)
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        sleeping_.store(true, std::memory_order_seq_cst);
+                        if (tail_.load(std::memory_order_seq_cst) == head)
+                        {
+                            if (!running_)
+                            {
+                                break;
+                            }
+                            flushed_cv_.notify_all();
+                            cv_.wait_for(lock, std::chrono::milliseconds(WRITE_BEHIND_IDLE_WAIT_MS));
+                        }
+                        sleeping_.store(false, std::memory_order_relaxed);
+                        continue;
+                    }
+                    commit_batch(head, std::min<uint64_t>(tail, head + max_batch_));
+                }
+            }
+
+            void commit_batch(uint64_t head, uint64_t end)
+            {
+                auto start = std::chrono::steady_clock::now();
+                int64_t failed = 0;
+                try
+                {
+                    SQLite::Transaction transaction(db_);
+                    for (uint64_t i = head; i < end; i++)
+                    {
+                        const T& record = ring_[i & mask_];
+                        try
+                        {
+                            insert_.reset();
+                            insert_.clearBindings();
+                            binder_(insert_, record);
+                            insert_.exec();
+                        }
+                        catch (std::exception &e)
+                        {
+                            failed++;
+                            SPDLOG_ERROR("{} write behind failed to insert, exception: {}", name_, e.what());
+                        }
+                        // values are copied by bind, slot can be reused
+                        head_.store(i + 1, std::memory_order_release);
+                    }
+                    transaction.commit();
+                    batches_++;
+                }
+                catch (std::exception &e)
+                {
+                    failed = end - head;
+                    head_.store(end, std::memory_order_release);
+                    SPDLOG_ERROR("{} write behind failed to commit {} records, exception: {}", name_, end - head, e.what());
+                }
+                int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                last_commit_ns_ = latency;
+                total_commit_ns_ += latency;
+                if (latency > max_commit_ns_)
+                {
+                    max_commit_ns_ = latency;
+                }
+                failed_ += failed;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_ += end - head;
+                }
+                flushed_cv_.notify_all();
+            }
+
+            SQLite::Database& db_;
+            SQLite::Statement insert_;
+            Binder binder_;
+            std::string name_;
+
+            std::vector<T> ring_;
+            const uint64_t mask_;
+            const uint64_t max_batch_;
+            std::atomic<uint64_t> head_;
+            std::atomic<uint64_t> tail_;
+
+            std::mutex push_mutex_;
+
+            std::thread thread_;
+            std::mutex mutex_;
+            std::condition_variable cv_;
+            std::condition_variable flushed_cv_;
+            std::atomic<bool> sleeping_;
+            bool running_;
+
+            std::atomic<uint64_t> done_;
+            std::atomic<int64_t> failed_;
+            std::atomic<int64_t> batches_;
+            std::atomic<int64_t> max_depth_;
+            std::atomic<int64_t> full_waits_;
+            std::atomic<int64_t> last_commit_ns_;
+            std::atomic<int64_t> max_commit_ns_;
+            std::atomic<int64_t> total_commit_ns_;
+        };
+    }
+}
+#endif //KUNGFU_WRITE_BEHIND_H
@@ -47,6 +47,8 @@ PYBIND11_MODULE(pystrategy, m)
 
     .def("on_push_by_min", &kungfu::StrategyUtil::on_push_by_min)
     .def("on_push_by_day", &kungfu::StrategyUtil::on_push_by_day)
+    .def("on_pnl_save_timer", &kungfu::StrategyUtil::on_pnl_save_timer, py::arg("nano"))
+    .def("flush_pnl", &kungfu::StrategyUtil::flush_pnl)
 
     .def("get_initial_equity", &kungfu::StrategyUtil::get_initial_equity)
     .def("get_static_equity", &kungfu::StrategyUtil::get_static_equity)
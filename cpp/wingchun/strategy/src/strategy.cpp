@@ -6,6 +6,7 @@
 
 #include "strategy/include/strategy.h"
 #include "strategy_util.h"
+#include "portfolio/include/pnl_def.h"
 #include "event_loop/event_loop.h"
 #include "msg.h"
 
@@ -23,7 +24,11 @@ namespace kungfu
     class Strategy::impl
     {
     public:
-        impl(Strategy* strategy, const std::string& name) : strategy_(strategy), name_(name), event_loop_(new EventLoop(name)), util_(new StrategyUtil(name)) {}
+        impl(Strategy* strategy, const std::string& name) : strategy_(strategy), name_(name), event_loop_(new EventLoop(name)), util_(new StrategyUtil(name)),
+                                                            md_filter_(new DispatchFilter())
+        {
+            event_loop_->set_wait_mode(STRATEGY_EVENT_LOOP_WAIT);
+        }
 
         StrategyUtilPtr get_util() const { return util_; }
 
@@ -39,6 +44,15 @@ namespace kungfu
             return get_util()->add_md(source_id);
         }
 
+        void subscribe(const std::string& source, const std::vector<std::string>& instruments, const std::string& exchange_id, bool is_level2)
+        {
+            for (const auto& instrument_id : instruments)
+            {
+                md_filter_->add_instrument(source, instrument_id, exchange_id);
+            }
+            util_->subscribe(source, instruments, exchange_id, is_level2);
+        }
+
         bool add_account(const std::string& source_id, const std::string& account_id, const double cash_limit)
         {
             event_loop_->subscribe_yjj_journal(TD_JOURNAL_FOLDER(source_id, account_id), TD_JOURNAL_NAME(source_id, account_id), yijinjing::getNanoTime());
@@ -57,10 +71,12 @@ namespace kungfu
 
             event_loop_->register_nanotime_callback(nseconds_next_min(yijinjing::getNanoTime()), std::bind(&Strategy::impl::on_1min_timer, this, std::placeholders::_1));
             event_loop_->register_nanotime_callback(nseconds_next_day(yijinjing::getNanoTime()), std::bind(&Strategy::impl::on_daily_timer, this, std::placeholders::_1));
+            event_loop_->register_nanotime_interval_callback(PNL_SAVE_INTERVAL_NANO, std::bind(&StrategyUtil::on_pnl_save_timer, util_.get(), std::placeholders::_1));
 
-            event_loop_->register_quote_callback(quote_callback);
-            event_loop_->register_entrust_callback(entrust_callback);
-            event_loop_->register_transaction_callback(transaction_callback);
+            // md journals are shared by all strategies, only subscribed instruments reach this one
+            event_loop_->register_quote_callback(quote_callback, md_filter_);
+            event_loop_->register_entrust_callback(entrust_callback, md_filter_);
+            event_loop_->register_transaction_callback(transaction_callback, md_filter_);
 
             event_loop_->register_order_callback(order_callback);
             event_loop_->register_trade_callback(trade_callback);
@@ -72,6 +88,7 @@ namespace kungfu
             strategy_->pre_run();
 
             event_loop_->run();
+            util_->flush_pnl();
         }
 
         void stop()
@@ -82,11 +99,8 @@ namespace kungfu
 
         void process_quote(const Quote& quote)
         {
-            if (util_->is_subscribed(quote.source_id, quote.instrument_id, quote.exchange_id))
-            {
-                util_->on_quote(quote);
-                strategy_->on_quote(quote);
-            }
+            util_->on_quote(quote);
+            strategy_->on_quote(quote);
         }
         void process_order(const Order& order)
         {
@@ -129,6 +143,7 @@ namespace kungfu
         std::string name_;
         EventLoopPtr event_loop_;
         StrategyUtilPtr util_;
+        DispatchFilterPtr md_filter_; // subscribed instruments
     };
 
     Strategy::Strategy(const std::string& name) : impl_(new impl(this, name)) {}
@@ -189,7 +204,7 @@ namespace kungfu
 
     void Strategy::subscribe(const std::string &source, const std::vector<std::string> &instruments, const std::string& exchange_id, bool is_level2)
     {
-        impl_->get_util()->subscribe(source, instruments, exchange_id, is_level2);
+        impl_->subscribe(source, instruments, exchange_id, is_level2);
     }
 
     uint64_t Strategy::insert_limit_order(const std::string& instrument_id, const std::string& exchange_id, const std::string& account_id,
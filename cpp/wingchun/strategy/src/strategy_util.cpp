@@ -12,6 +12,7 @@
 
 #include "util/include/env.h"
 #include "util/include/filesystem_util.h"
+#include "util/include/latency_probe.h"
 #include "storage/account_list_storage.h"
 #include "storage/snapshot_storage.h"
 
@@ -37,7 +38,7 @@ namespace kungfu
         create_folder_if_not_exists(STRATEGY_FOLDER(name));
 
         std::string pub_url = STRATEGY_PUB_URL(name);
-        publisher_ = std::shared_ptr<NNPublisher>(new NNPublisher(pub_url));
+        publisher_ = std::shared_ptr<NNPublisher>(new NNPublisher(pub_url, STRATEGY_PUB_ENCODING));
 
         storage::SnapshotStorage s1(STRATEGY_SNAPSHOT_DB_FILE(name), PORTFOLIO_ONE_DAY_SNAPSHOT_TABLE_NAME, true, false);
         storage::SnapshotStorage s2(STRATEGY_SNAPSHOT_DB_FILE(name), PORTFOLIO_ONE_MIN_SNAPSHOT_TABLE_NAME, false, false);
@@ -52,7 +53,7 @@ namespace kungfu
         }
         uid_generator_ = std::unique_ptr<UidGenerator>(new UidGenerator(worker_id, UID_EPOCH_SECONDS));
 
-        writer_ = kungfu::yijinjing::JournalWriter::create(fmt::format(STRATEGY_JOURNAL_FOLDER_FORMAT, get_base_dir()), this->name_, this->name_);
+        writer_ = kungfu::yijinjing::JournalWriter::create(fmt::format(STRATEGY_JOURNAL_FOLDER_FORMAT, get_base_dir()), this->name_, this->name_, STRATEGY_JOURNAL_PAGE_SIZE);
 
         init_portfolio_manager();
 
@@ -124,7 +125,7 @@ namespace kungfu
     void StrategyUtil::on_quote(const kungfu::Quote& quote)
     {
         SPDLOG_TRACE("instrument_id: {}, last_price: {}", quote.instrument_id, quote.last_price);
-        quote_map_[get_symbol(quote.instrument_id, quote.exchange_id)] = quote;
+        quote_table_[SymbolInterner::get_interner().intern(quote.instrument_id, quote.exchange_id)] = quote;
         portfolio_manager_->on_quote(&quote);
     }
 
@@ -264,10 +265,10 @@ namespace kungfu
         strcpy(input.instrument_id, instrument_id.c_str());
         strcpy(input.exchange_id, exchange_id.c_str());
         strcpy(input.account_id, account_id.c_str());
-        auto iter = quote_map_.find(get_symbol(instrument_id, exchange_id));
-        if (iter != quote_map_.end())
+        auto quote = get_last_md(instrument_id, exchange_id);
+        if (quote != nullptr)
         {
-            input.frozen_price = iter->second.last_price;
+            input.frozen_price = quote->last_price;
         }
         input.volume = volume;
         input.side = side;
@@ -299,7 +300,13 @@ namespace kungfu
         uint64_t uid = next_id();
         order_input.order_id = uid;
         strcpy(order_input.client_id, this->name_.c_str());
-        writer_->write_frame(&order_input, sizeof(OrderInput), -1, (int)MsgType::OrderInput, 1, -1);
+        // md nano of the quote being handled travels with the order to the td gateway
+        int64_t origin_nano = latency_origin_nano();
+        int64_t nano = writer_->write_frame_extra(&order_input, sizeof(OrderInput), -1, (int)MsgType::OrderInput, 1, -1, origin_nano);
+        if (origin_nano > 0)
+        {
+            LATENCY_PROBE("strategy.md_to_order_input", nano - origin_nano);
+        }
         return uid;
     }
 
@@ -320,15 +327,18 @@ namespace kungfu
     uint64_t StrategyUtil::insert_algo_order(const std::string& algo_type, const std::string& order_input_msg)
     {
         uint64_t uid = next_id();
-        AlgoOrderInput input = {};
+        uint32_t var_length = order_input_msg.length() + 1;
+
+        // filled in place in journal
+        AlgoOrderInput* input = (AlgoOrderInput*)writer_->reserve(sizeof(AlgoOrderInput) + var_length, -1, (int)MsgType::AlgoOrderInput, true, -1);
+        memset(input, 0, sizeof(AlgoOrderInput));
+        input->order_id = uid;
+        strncpy(input->client_id, this->name_.c_str(), CLIENT_ID_LEN - 1);
+        strncpy(input->algo_type, algo_type.c_str(), ALGO_TYPE_LEN - 1);
+        input->var_length = var_length;
+        memcpy(get_algo_msg_var(*input), order_input_msg.c_str(), var_length);
+        writer_->commit();
 
-        input.algo_type = algo_type;
-        input.order_id = uid;
-        input.client_id = std::string(this->name_.c_str());
-        input.input = order_input_msg;
-        std::string js = to_string(input);
-        
-        writer_->write_frame(js.c_str(), js.length() + 1, -1, (int)MsgType::AlgoOrderInput, true, -1 );
         return uid;
     }
 
@@ -336,14 +346,15 @@ namespace kungfu
     {
         uint64_t uid = next_id();
 
-        AlgoOrderAction action = {};
-        action.order_action_id = uid;
-        action.order_id = order_id;
-        action.action = cmd;
+        uint32_t var_length = cmd.length() + 1;
 
-        std::string js = to_string(action);
-
-        writer_->write_frame(js.c_str(), js.length() + 1, -1, (int)MsgType::AlgoOrderAction, true, -1);
+        AlgoOrderAction* action = (AlgoOrderAction*)writer_->reserve(sizeof(AlgoOrderAction) + var_length, -1, (int)MsgType::AlgoOrderAction, true, -1);
+        memset(action, 0, sizeof(AlgoOrderAction));
+        action->order_action_id = uid;
+        action->order_id = order_id;
+        action->var_length = var_length;
+        memcpy(get_algo_msg_var(*action), cmd.c_str(), var_length);
+        writer_->commit();
 
         return uid;
     }
@@ -370,15 +381,8 @@ namespace kungfu
 
     const Quote* const StrategyUtil::get_last_md(const std::string& instrument_id, const std::string& exchange_id) const
     {
-        auto iter = quote_map_.find(get_symbol(instrument_id, exchange_id));
-        if (iter == quote_map_.end())
-        {
-            return nullptr;
-        }
-        else
-        {
-            return & iter->second;
-        }
+        uint32_t id = SymbolInterner::get_interner().find(instrument_id.c_str(), exchange_id.c_str());
+        return id == SYMBOL_ID_NONE ? nullptr : quote_table_.find(id);
     }
 
     uintptr_t StrategyUtil::get_last_md_py(const std::string& instrument_id, const std::string& exchange_id) const
@@ -415,6 +419,16 @@ namespace kungfu
         DUMP_1D_SNAPSHOT(name_, pnl);
     }
 
+    void StrategyUtil::on_pnl_save_timer(long nano)
+    {
+        portfolio_manager_->on_timer(nano);
+    }
+
+    void StrategyUtil::flush_pnl()
+    {
+        portfolio_manager_->flush();
+    }
+
     double StrategyUtil::get_initial_equity() const
     {
         return portfolio_manager_->get_initial_equity();
@@ -603,15 +617,15 @@ namespace kungfu
                 names.emplace_back(TD_JOURNAL_NAME(account.source_id, account.account_id));
             }
             kungfu::yijinjing::JournalReaderPtr reader = kungfu::yijinjing::JournalReader::create(folders, names, last_update);
-            kungfu::yijinjing::FramePtr frame = reader->getNextFrame();
-            while (frame != nullptr)
+            kungfu::yijinjing::Frame frame(nullptr);
+            while (reader->getNextFrame(frame))
             {
-                int msg_type = frame->getMsgType();
+                int msg_type = frame.getMsgType();
                 switch (msg_type)
                 {
                     case (int) MsgType::Quote:
                     {
-                        auto quote = (const Quote*) frame->getData();
+                        auto quote = (const Quote*) frame.getData();
                         if (quote->rcv_time > last_update)
                         {
                             portfolio_manager_->on_quote(quote);
@@ -620,7 +634,7 @@ namespace kungfu
                     }
                     case (int) MsgType::Order:
                     {
-                        auto* order = (const Order*) frame->getData();
+                        auto* order = (const Order*) frame.getData();
                         if (strcmp(order->client_id, this->name_.c_str()) == 0 && order->rcv_time > last_update)
                         {
                             portfolio_manager_->on_order(order);
@@ -629,7 +643,7 @@ namespace kungfu
                     }
                     case (int) MsgType::Trade:
                     {
-                        auto* trade = (const Trade* ) frame->getData();
+                        auto* trade = (const Trade* ) frame.getData();
                         if (strcmp(trade->client_id, this->name_.c_str()) == 0 && trade->rcv_time > last_update)
                         {
                             portfolio_manager_->on_trade(trade);
@@ -641,7 +655,6 @@ namespace kungfu
                         break;
                     }
                 }
-                frame = reader->getNextFrame();
             }
             SPDLOG_INFO("forward portfolio manager from {}|{} to {}|{}", last_update, kungfu::yijinjing::parseNano(last_update, "%Y%m%d-%H:%M:%S"), portfolio_manager_->get_last_update(), kungfu::yijinjing::parseNano(portfolio_manager_->get_last_update(), "%Y%m%d-%H:%M:%S"));
         }
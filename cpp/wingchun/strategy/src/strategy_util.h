@@ -16,6 +16,7 @@
 #include "storage/account_list_storage.h"
 #include "gateway/include/util.hpp"
 #include "calendar/include/calendar.h"
+#include "util/include/symbol_interner.h"
 
 #include "nlohmann/json.hpp"
 
@@ -81,6 +82,8 @@ namespace kungfu
 
         void on_push_by_min();
         void on_push_by_day();
+        void on_pnl_save_timer(long nano); // 每 PNL_SAVE_INTERVAL_NANO 调用, 写入成交后被合并推迟的存盘
+        void flush_pnl(); // 退出前写入所有未存盘的持仓/账户
 
         double get_initial_equity() const;
         double get_static_equity() const;
@@ -127,7 +130,7 @@ namespace kungfu
         std::shared_ptr<oms::OrderManager> order_manager_;
         yijinjing::JournalWriterPtr writer_;
         std::unique_ptr<UidGenerator> uid_generator_;
-        std::map<std::string, Quote> quote_map_;
+        SymbolTable<Quote> quote_table_; // { symbol id -> last quote }
         bool has_stock_account_;
         bool has_future_account_;
         std::map<std::string, std::set<std::string>> subscribed_;
@@ -5,9 +5,12 @@
 #include "task_scheduler.h"
 #include "Timer.h"
 
+#include <algorithm>
+
 namespace kungfu
 {
-    TaskScheduler::TaskScheduler() : started_(false), nano_(0)
+    TaskScheduler::TaskScheduler(int async_worker_num) : started_(false), nano_(0), next_nano_(LONG_MAX), last_id_(TS_INVALID_HANDLE), last_seq_(0),
+                                                         stale_(0), async_worker_num_(std::max(async_worker_num, 1)), workers_running_(false)
     {
 
     }
@@ -29,31 +32,22 @@ namespace kungfu
 
     void TaskScheduler::stop()
     {
-        if (!started_)
-        {
-            return;
-        }
-
         started_ = false;
+        // async callbacks already handed to workers still run before join
+        stop_workers();
     }
 
-    void TaskScheduler::insert_callback_at(long nano, kungfu::TSCallback cb, bool async)
+    TSHandle TaskScheduler::insert_callback_at(long nano, kungfu::TSCallback cb, bool async)
     {
-        int id = get_id();
-        TSCallbackUnit unit{id, nano, cb, async};
-        cbs_[id] = unit;
-        if (nano <= nano_)
-        {
-            update_nano(nano_); // trigger
-        }
+        return insert_unit(nano, 0, std::move(cb), async);
     }
 
-    void TaskScheduler::insert_callback_after(int msec, kungfu::TSCallback cb, bool async)
+    TSHandle TaskScheduler::insert_callback_after(int msec, kungfu::TSCallback cb, bool async)
     {
-        insert_callback_at(nano_ + msec * 1000000, cb, async);
+        return insert_callback_at(nano_ + msec * 1000000L, std::move(cb), async);
     }
 
-    void TaskScheduler::insert_callback_at_next(const char *time_str, kungfu::TSCallback cb, bool async)
+    TSHandle TaskScheduler::insert_callback_at_next(const char *time_str, kungfu::TSCallback cb, bool async)
     {
         string cur_time_str = yijinjing::parseNano(nano_, "%Y%m%d-");
         string date_time_str = cur_time_str + time_str;
@@ -62,54 +56,236 @@ namespace kungfu
         {
             nano += yijinjing::NANOSECONDS_PER_DAY;
         }
-        insert_callback_at(nano, cb, async);
+        return insert_callback_at(nano, std::move(cb), async);
+    }
+
+    TSHandle TaskScheduler::insert_callback_every(long interval_nano, kungfu::TSCallback cb, bool async, long first_nano)
+    {
+        if (interval_nano <= 0)
+        {
+            return TS_INVALID_HANDLE;
+        }
+        return insert_unit(first_nano > 0 ? first_nano : nano_ + interval_nano, interval_nano, std::move(cb), async);
+    }
+
+    bool TaskScheduler::cancel(TSHandle handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cbs_.erase(handle) == 0)
+        {
+            return false;
+        }
+        // heap entry is left behind and skipped when it reaches the top
+        stale_++;
+        compact();
+        return true;
+    }
+
+    bool TaskScheduler::reschedule(TSHandle handle, long nano)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = cbs_.find(handle);
+        if (it == cbs_.end())
+        {
+            return false;
+        }
+        it->second.nano_ = nano;
+        push_entry(it->second);
+        stale_++;
+        compact();
+        update_next_nano();
+        return true;
+    }
+
+    bool TaskScheduler::is_pending(TSHandle handle) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cbs_.find(handle) != cbs_.end();
+    }
+
+    size_t TaskScheduler::size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return cbs_.size();
     }
 
     void TaskScheduler::update_nano(long nano)
     {
-        if (nano <= nano_)
+        if (nano > nano_)
+        {
+            nano_ = nano;
+        }
+        nano = nano_;
+        if (nano < next_nano_)
         {
             return;
         }
-        nano_ = nano;
-        for (auto it = cbs_.begin(); it != cbs_.end();)
+
+        // callbacks inserted by callbacks below wait for the next update, as before
+        uint64_t max_seq;
         {
-            if (it->second.nano_ <= nano)
+            std::lock_guard<std::mutex> lock(mutex_);
+            max_seq = last_seq_;
+        }
+        AsyncJob job;
+        bool async = false;
+        while (pop_due(nano, max_seq, job, async))
+        {
+            if (async)
             {
-                if (it->second.async_)
-                {
-                    auto thread = std::make_shared<std::thread>(&TaskScheduler::run_async_unit, this, it->second);
-                    threads_[it->second.id_] = thread;
-                }
-                else
+                run_async(std::move(job));
+            }
+            else
+            {
+                (*job.cb_)(nano);
+            }
+        }
+    }
+
+    TSHandle TaskScheduler::insert_unit(long nano, long interval, kungfu::TSCallback cb, bool async)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TSHandle id = ++last_id_;
+        TSCallbackUnit& unit = cbs_[id];
+        unit.id_ = id;
+        unit.nano_ = nano;
+        unit.interval_ = interval;
+        unit.cb_ = std::make_shared<const TSCallback>(std::move(cb));
+        unit.async_ = async;
+        push_entry(unit);
+        update_next_nano();
+        return id;
+    }
+
+    void TaskScheduler::push_entry(TSCallbackUnit& unit)
+    {
+        unit.seq_ = ++last_seq_;
+        heap_.push_back(HeapEntry{unit.nano_, unit.seq_, unit.id_});
+        std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+    }
+
+    bool TaskScheduler::pop_due(long nano, uint64_t max_seq, AsyncJob& job, bool& async)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!heap_.empty() && heap_.front().nano_ <= nano)
+        {
+            HeapEntry top = heap_.front();
+            std::pop_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+            heap_.pop_back();
+
+            auto it = cbs_.find(top.id_);
+            if (it == cbs_.end() || it->second.seq_ != top.seq_)
+            {
+                stale_--;
+                continue;
+            }
+            if (top.seq_ > max_seq)
+            {
+                deferred_.push_back(top);
+                continue;
+            }
+
+            TSCallbackUnit& unit = it->second;
+            job.cb_ = unit.cb_;
+            job.nano_ = nano;
+            async = unit.async_;
+            if (unit.interval_ > 0)
+            {
+                long next = unit.nano_ + unit.interval_;
+                if (next <= nano)
                 {
-                    it->second.cb_(nano_);
-                    it = cbs_.erase(it);
-                    continue;
+                    next += ((nano - next) / unit.interval_ + 1) * unit.interval_;
                 }
+                unit.nano_ = next;
+                push_entry(unit);
+            }
+            else
+            {
+                cbs_.erase(it);
             }
-            ++it;
+            update_next_nano();
+            return true;
+        }
+
+        for (const auto& entry : deferred_)
+        {
+            heap_.push_back(entry);
+            std::push_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+        }
+        deferred_.clear();
+        update_next_nano();
+        return false;
+    }
+
+    void TaskScheduler::compact()
+    {
+        if (stale_ < TS_HEAP_COMPACT_MIN || stale_ <= cbs_.size())
+        {
+            return;
+        }
+        heap_.clear();
+        deferred_.clear();
+        for (const auto& iter : cbs_)
+        {
+            const TSCallbackUnit& unit = iter.second;
+            heap_.push_back(HeapEntry{unit.nano_, unit.seq_, unit.id_});
         }
+        std::make_heap(heap_.begin(), heap_.end(), std::greater<HeapEntry>());
+        stale_ = 0;
+        update_next_nano();
     }
 
-    int TaskScheduler::get_id() const
+    void TaskScheduler::update_next_nano()
     {
-        static int id = 0;
-        return ++id;
+        next_nano_ = heap_.empty() ? LONG_MAX : heap_.front().nano_;
     }
 
-    void TaskScheduler::run_async_unit(const TSCallbackUnit &unit)
+    void TaskScheduler::run_async(AsyncJob&& job)
     {
-        unit.cb_(nano_);
+        std::lock_guard<std::mutex> lock(job_mutex_);
+        if (!workers_running_)
+        {
+            workers_running_ = true;
+            for (int i = 0; i < async_worker_num_; i++)
+            {
+                workers_.emplace_back(&TaskScheduler::worker_loop, this);
+            }
+        }
+        jobs_.emplace_back(std::move(job));
+        job_cv_.notify_one();
+    }
 
-        if (started_)
+    void TaskScheduler::worker_loop()
+    {
+        while (true)
         {
-            insert_callback_at(0, std::bind(&TaskScheduler::remove_async_unit, this, std::placeholders::_1, unit.id_));
+            AsyncJob job;
+            {
+                std::unique_lock<std::mutex> lock(job_mutex_);
+                job_cv_.wait(lock, [&]{ return !jobs_.empty() || !workers_running_; });
+                if (jobs_.empty())
+                {
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            (*job.cb_)(job.nano_);
         }
     }
 
-    void TaskScheduler::remove_async_unit(long nano, int id)
+    void TaskScheduler::stop_workers()
     {
-        cbs_.erase(id);
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(job_mutex_);
+            workers_running_ = false;
+            workers.swap(workers_);
+        }
+        job_cv_.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
     }
-}
\ No newline at end of file
+}
@@ -8,56 +8,119 @@
 #include <functional>
 #include <thread>
 #include <atomic>
-#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <climits>
 
 namespace kungfu
 {
+#define TS_INVALID_HANDLE 0
+#define TS_ASYNC_WORKER_NUM 2 // threads running async callbacks, started on first async callback
+#define TS_HEAP_COMPACT_MIN 1024 // rebuild heap when it holds this many cancelled entries and more than live ones
+
     /*
      * 时间触发的任务调度器，nano time 由外部输入，可以注册并执行定时任务。
      *
-     * insert_callback_xx函数用于注册回调
+     * insert_callback_xx函数用于注册回调, 返回handle, 可用于cancel和reschedule
      * 如果async = false，则在update_nano返回前回调
-     * 如果async = true, 则在新线程中回调
+     * 如果async = true, 则交给固定的工作线程池回调
      *
      * 触发器依赖upate_nano来更新时间，即所有回调都将由此函数触发
+     * 定时任务保存在以触发时间排序的最小堆中，没有到期任务时update_nano只比较一次时间
      *
      * insert_callback_at_next中time_str格式为"09:01:07"
+     * insert_callback_every注册周期任务，直到cancel为止
      */
     typedef std::function<void (long)> TSCallback;
+    typedef int64_t TSHandle;
+
     class TaskScheduler
     {
     public:
-        TaskScheduler();
+        explicit TaskScheduler(int async_worker_num = TS_ASYNC_WORKER_NUM);
         virtual ~TaskScheduler();
         void run();
         void stop();
 
-        void insert_callback_at(long nano, TSCallback cb, bool async = false);
-        void insert_callback_after(int msec, TSCallback cb, bool async = false);
-        void insert_callback_at_next(const char* time_str, TSCallback cb, bool async= false);
+        // nano <= current nano triggers at next update_nano
+        TSHandle insert_callback_at(long nano, TSCallback cb, bool async = false);
+        TSHandle insert_callback_after(int msec, TSCallback cb, bool async = false);
+        TSHandle insert_callback_at_next(const char* time_str, TSCallback cb, bool async= false);
+        // every interval_nano from first_nano (0 for one interval from now), missed periods are skipped
+        TSHandle insert_callback_every(long interval_nano, TSCallback cb, bool async = false, long first_nano = 0);
+
+        // false if the handle already fired (one-shot) or was cancelled
+        bool cancel(TSHandle handle);
+        bool reschedule(TSHandle handle, long nano);
+        bool is_pending(TSHandle handle) const;
 
         void update_nano(long nano);
         long get_nano() const { return nano_; }
+        long get_next_nano() const { return next_nano_; } // LONG_MAX if nothing registered
+        size_t size() const;
+
     protected:
         struct TSCallbackUnit
         {
-            int         id_;
+            TSHandle                            id_;
+            long                                nano_;
+            long                                interval_;   // 0 for one-shot
+            std::shared_ptr<const TSCallback>   cb_;
+            bool                                async_;
+            uint64_t                            seq_;        // matches the live heap entry, older entries are stale
+        };
+
+        struct HeapEntry
+        {
             long        nano_;
-            TSCallback  cb_;
-            bool        async_;
+            uint64_t    seq_;       // insertion order, callbacks due at the same nano fire in order
+            TSHandle    id_;
+
+            bool operator>(const HeapEntry& other) const
+            {
+                return nano_ > other.nano_ || (nano_ == other.nano_ && seq_ > other.seq_);
+            }
+        };
+
+        struct AsyncJob
+        {
+            std::shared_ptr<const TSCallback>   cb_;
+            long                                nano_;
         };
 
     protected:
-        int get_id() const;
-        void run_async_unit(const TSCallbackUnit& unit);
-        void remove_async_unit(long nano, int id);
+        TSHandle insert_unit(long nano, long interval, TSCallback cb, bool async);
+        void push_entry(TSCallbackUnit& unit);
+        bool pop_due(long nano, uint64_t max_seq, AsyncJob& job, bool& async);
+        void compact();
+        void update_next_nano();
+        void run_async(AsyncJob&& job);
+        void worker_loop();
+        void stop_workers();
 
     protected:
-        std::map<int, std::shared_ptr<std::thread>>     threads_;
         std::atomic<bool>                               started_;
         std::atomic<long>                               nano_;
-        std::map<int, TSCallbackUnit>                   cbs_;
-        // TODO: consider priority_queue
+        std::atomic<long>                               next_nano_;
+
+        mutable std::mutex                              mutex_; // guards timers, callbacks run without it
+        std::unordered_map<TSHandle, TSCallbackUnit>    cbs_;
+        std::vector<HeapEntry>                          heap_;
+        TSHandle                                        last_id_;
+        uint64_t                                        last_seq_;
+        size_t                                          stale_;     // heap entries of cancelled or rescheduled callbacks
+        std::vector<HeapEntry>                          deferred_;  // due entries inserted during this update
+
+        int                                             async_worker_num_;
+        std::vector<std::thread>                        workers_;
+        std::mutex                                      job_mutex_;
+        std::condition_variable                         job_cv_;
+        std::deque<AsyncJob>                            jobs_;
+        bool                                            workers_running_;
     };
 }
 
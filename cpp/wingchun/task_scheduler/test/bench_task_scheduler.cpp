@@ -0,0 +1,99 @@
+//
+// TaskScheduler benchmark with many registered timers.
+// measures insert, update_nano when nothing is due (what every EventLoop::iteration pays),
+// firing everything in order, cancel, and periodic timers.
+// usage: bench_task_scheduler [timer_num] [idle_update_num]
+//
+
+#include "../task_scheduler.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#define BENCH_BASE_NANO 1000000000000L
+#define BENCH_SPREAD_NANO 60000000000L // timers spread over one minute
+
+int main(int argc, char** argv)
+{
+    int timer_num = (argc > 1) ? atoi(argv[1]) : 10000;
+    int idle_update_num = (argc > 2) ? atoi(argv[2]) : 1000000;
+    std::cout << "(timers) " << timer_num << std::endl;
+
+    TaskScheduler scheduler;
+    scheduler.update_nano(BENCH_BASE_NANO);
+    long fired = 0;
+    long last_nano = 0;
+    bool in_order = true;
+    TSCallback cb = [&](long nano) { fired++; in_order = in_order && nano >= last_nano; last_nano = nano; };
+
+    std::vector<TSHandle> handles(timer_num);
+    int64_t start = now_nano();
+    for (int i = 0; i < timer_num; i++)
+    {
+        long nano = BENCH_BASE_NANO + 1000 + (long)((i * 2654435761u) % timer_num) * (BENCH_SPREAD_NANO / timer_num);
+        handles[i] = scheduler.insert_callback_at(nano, cb);
+    }
+    std::cout << "[insert          ] (ns per timer) " << (now_nano() - start) / timer_num << std::endl;
+
+    start = now_nano();
+    for (int i = 0; i < idle_update_num; i++)
+    {
+        scheduler.update_nano(BENCH_BASE_NANO + (i % 1000));
+    }
+    std::cout << "[update, none due] (ns per call) " << (now_nano() - start) / idle_update_num << std::endl;
+
+    // cancel every fourth
+    start = now_nano();
+    int cancelled = 0;
+    for (int i = 0; i < timer_num; i += 4)
+    {
+        cancelled += scheduler.cancel(handles[i]) ? 1 : 0;
+    }
+    std::cout << "[cancel          ] (ns per timer) " << (now_nano() - start) / std::max(cancelled, 1) << std::endl;
+
+    // advance one millisecond per update through the minute
+    int update_num = 0;
+    start = now_nano();
+    for (long nano = BENCH_BASE_NANO; nano <= BENCH_BASE_NANO + BENCH_SPREAD_NANO + 1000; nano += 1000000)
+    {
+        scheduler.update_nano(nano);
+        update_num++;
+    }
+    int64_t fire_ns = now_nano() - start;
+    std::cout << "[fire            ] (ns per timer) " << fire_ns / std::max(fired, 1L)
+              << " (updates) " << update_num << " (fired) " << fired
+              << " (expected) " << timer_num - cancelled << " (in order) " << (in_order ? "yes" : "NO") << std::endl;
+
+    // periodic timers, each with its own period between 1 and 10 seconds
+    fired = 0;
+    last_nano = 0;
+    long base = scheduler.get_nano();
+    for (int i = 0; i < timer_num; i++)
+    {
+        scheduler.insert_callback_every((i % 10 + 1) * 1000000000L, cb);
+    }
+    long expected = 0;
+    for (int i = 0; i < timer_num; i++)
+    {
+        expected += 60 / (i % 10 + 1);
+    }
+    start = now_nano();
+    for (long nano = base; nano <= base + BENCH_SPREAD_NANO; nano += 1000000)
+    {
+        scheduler.update_nano(nano);
+    }
+    std::cout << "[periodic        ] (ns per fire) " << (now_nano() - start) / std::max(fired, 1L)
+              << " (fired) " << fired << " (expected) " << expected << std::endl;
+
+    bool ok = fired == expected && in_order;
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
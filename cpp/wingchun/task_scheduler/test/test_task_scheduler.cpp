@@ -50,12 +50,88 @@ TEST_F(TaskSchedulerTest, UniqueIDNotEqual)
 {
     long n = 0;
     task_scheduler->update_nano(100);
-    TSCallback lambda = [](long n) { ++n; };
+    TSCallback lambda = [&n](long nano) { ++n; };
     task_scheduler->insert_callback_at(200, lambda);
     task_scheduler->update_nano(200);
     EXPECT_TRUE(n == 1) << "task scheduler sync task call failed" << std::endl;
 }
 
+TEST_F(TaskSchedulerTest, FireInNanoOrder)
+{
+    std::vector<int> fired;
+    task_scheduler->update_nano(100);
+    task_scheduler->insert_callback_at(300, [&](long n) { fired.push_back(3); });
+    task_scheduler->insert_callback_at(200, [&](long n) { fired.push_back(1); });
+    task_scheduler->insert_callback_at(200, [&](long n) { fired.push_back(2); });
+    task_scheduler->update_nano(150);
+    EXPECT_TRUE(fired.empty());
+    EXPECT_EQ(task_scheduler->get_next_nano(), 200);
+    task_scheduler->update_nano(300);
+    EXPECT_EQ(fired, std::vector<int>({1, 2, 3}));
+    EXPECT_EQ(task_scheduler->size(), 0);
+}
+
+TEST_F(TaskSchedulerTest, CancelAndReschedule)
+{
+    int count = 0;
+    task_scheduler->update_nano(100);
+    TSHandle cancelled = task_scheduler->insert_callback_at(200, [&](long n) { count += 1; });
+    TSHandle moved = task_scheduler->insert_callback_at(200, [&](long n) { count += 10; });
+    EXPECT_TRUE(task_scheduler->cancel(cancelled));
+    EXPECT_FALSE(task_scheduler->cancel(cancelled));
+    EXPECT_TRUE(task_scheduler->reschedule(moved, 400));
+    task_scheduler->update_nano(300);
+    EXPECT_EQ(count, 0);
+    task_scheduler->update_nano(400);
+    EXPECT_EQ(count, 10);
+    EXPECT_FALSE(task_scheduler->is_pending(moved));
+}
+
+TEST_F(TaskSchedulerTest, Periodic)
+{
+    std::vector<long> fired;
+    task_scheduler->update_nano(1000);
+    TSHandle handle = task_scheduler->insert_callback_every(100, [&](long n) { fired.push_back(n); });
+    task_scheduler->update_nano(1100);
+    task_scheduler->update_nano(1150);
+    task_scheduler->update_nano(1200);
+    // missed periods are skipped, phase is kept
+    task_scheduler->update_nano(1550);
+    task_scheduler->update_nano(1600);
+    EXPECT_EQ(fired, std::vector<long>({1100, 1200, 1550, 1600}));
+    EXPECT_TRUE(task_scheduler->cancel(handle));
+    task_scheduler->update_nano(2000);
+    EXPECT_EQ(fired.size(), 4);
+}
+
+TEST_F(TaskSchedulerTest, InsertFromCallbackFiresAtNextUpdate)
+{
+    int count = 0;
+    task_scheduler->update_nano(100);
+    TSCallback again = [&](long n) { count++; task_scheduler->insert_callback_at(0, [&](long n) { count++; }); };
+    task_scheduler->insert_callback_at(0, again);
+    task_scheduler->update_nano(100);
+    EXPECT_EQ(count, 1);
+    task_scheduler->update_nano(100);
+    EXPECT_EQ(count, 2);
+}
+
+TEST_F(TaskSchedulerTest, AsyncOnWorkerPool)
+{
+    std::atomic<int> count(0);
+    std::thread::id main_id = std::this_thread::get_id();
+    std::atomic<bool> other_thread(true);
+    task_scheduler->update_nano(100);
+    for (int i = 0; i < 100; i++)
+    {
+        task_scheduler->insert_callback_at(200, [&](long n) { count++; other_thread = other_thread && std::this_thread::get_id() != main_id; }, true);
+    }
+    task_scheduler->update_nano(200);
+    task_scheduler->stop(); // joins workers after queued callbacks ran
+    EXPECT_EQ(count, 100);
+    EXPECT_TRUE(other_thread);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,273 @@
+//
+// Latency histograms at named probe points of the tick to order pipeline.
+// each thread records into its own histogram of a probe without locks, reports merge them.
+// probes record nothing unless KF_LATENCY_PROBE is set.
+//
+
+#ifndef KUNGFU_LATENCY_PROBE_H
+#define KUNGFU_LATENCY_PROBE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace kungfu
+{
+#define LATENCY_PROBE_ENV "KF_LATENCY_PROBE"
+#define LATENCY_HISTOGRAM_SUB_BITS 5 // 32 buckets per power of 2, values within 3%
+#define LATENCY_HISTOGRAM_MAX_BITS 40 // ~18 minutes in nanos, longer ones count in the last bucket
+#define LATENCY_HISTOGRAM_BUCKETS ((LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS + 1) << LATENCY_HISTOGRAM_SUB_BITS)
+
+    // log-linear buckets as HdrHistogram, one writer thread, any reader thread
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram(): max_(0)
+        {
+            for (auto& count : counts_)
+            {
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void record(int64_t ns)
+        {
+            if (ns < 0)
+            {
+                ns = 0;
+            }
+            // single writer, no locked instruction needed
+            auto& count = counts_[bucket_of(ns)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (ns > max_.load(std::memory_order_relaxed))
+            {
+                max_.store(ns, std::memory_order_relaxed);
+            }
+        }
+
+        void merge_into(std::vector<uint64_t>& counts, int64_t& max) const
+        {
+            for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+            {
+                counts[i] += counts_[i].load(std::memory_order_relaxed);
+            }
+            max = std::max(max, max_.load(std::memory_order_relaxed));
+        }
+
+        static size_t bucket_of(int64_t ns)
+        {
+            uint64_t value = (uint64_t)ns;
+            if (value < (1u << LATENCY_HISTOGRAM_SUB_BITS))
+            {
+                return value;
+            }
+            int msb = 63 - __builtin_clzll(value);
+            if (msb >= LATENCY_HISTOGRAM_MAX_BITS)
+            {
+                return LATENCY_HISTOGRAM_BUCKETS - 1;
+            }
+            int shift = msb - LATENCY_HISTOGRAM_SUB_BITS;
+            return ((shift + 1) << LATENCY_HISTOGRAM_SUB_BITS) + (value >> shift) - (1u << LATENCY_HISTOGRAM_SUB_BITS);
+        }
+
+        // middle of the bucket
+        static int64_t value_of(size_t bucket)
+        {
+            if (bucket < (1u << LATENCY_HISTOGRAM_SUB_BITS))
+            {
+                return bucket;
+            }
+            int shift = (bucket >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+            int64_t lower = (int64_t)((bucket & ((1u << LATENCY_HISTOGRAM_SUB_BITS) - 1)) + (1u << LATENCY_HISTOGRAM_SUB_BITS)) << shift;
+            return lower + ((1L << shift) >> 1);
+        }
+
+    private:
+        std::atomic<uint64_t> counts_[LATENCY_HISTOGRAM_BUCKETS];
+        std::atomic<int64_t> max_;
+    };
+
+    struct LatencyReport
+    {
+        std::string name;
+        uint64_t count;
+        int64_t p50;
+        int64_t p99;
+        int64_t p999;
+        int64_t max;
+    };
+
+    class LatencyProbe
+    {
+    public:
+        LatencyProbe(const std::string& name, size_t id): name_(name), id_(id) {}
+
+        void record(int64_t ns)
+        {
+            get_local()->record(ns);
+        }
+
+        // cumulative since start
+        LatencyReport report() const
+        {
+            std::vector<uint64_t> counts(LATENCY_HISTOGRAM_BUCKETS, 0);
+            LatencyReport report = {name_, 0, 0, 0, 0, 0};
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto& histogram : histograms_)
+                {
+                    histogram->merge_into(counts, report.max);
+                }
+            }
+            for (uint64_t count : counts)
+            {
+                report.count += count;
+            }
+            report.p50 = percentile(counts, report.count, 0.5);
+            report.p99 = percentile(counts, report.count, 0.99);
+            report.p999 = percentile(counts, report.count, 0.999);
+            return report;
+        }
+
+        const std::string& get_name() const { return name_; }
+
+    private:
+        // histogram of the calling thread, created on its first record
+        LatencyHistogram* get_local()
+        {
+            thread_local std::vector<LatencyHistogram*> locals;
+            if (locals.size() <= id_)
+            {
+                locals.resize(id_ + 1, nullptr);
+            }
+            if (locals[id_] == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                histograms_.emplace_back(new LatencyHistogram());
+                locals[id_] = histograms_.back().get();
+            }
+            return locals[id_];
+        }
+
+        static int64_t percentile(const std::vector<uint64_t>& counts, uint64_t total, double ratio)
+        {
+            if (total == 0)
+            {
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(total * ratio);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts.size(); i++)
+            {
+                seen += counts[i];
+                if (seen > rank)
+                {
+                    return LatencyHistogram::value_of(i);
+                }
+            }
+            return LatencyHistogram::value_of(counts.size() - 1);
+        }
+
+        std::string name_;
+        size_t id_;
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<LatencyHistogram>> histograms_; // kept after their thread exits
+    };
+
+    class LatencyRegistry
+    {
+    public:
+        static LatencyRegistry& get()
+        {
+            static LatencyRegistry* registry = new LatencyRegistry(); // never destroyed, threads may record during exit
+            return *registry;
+        }
+
+        bool enabled() const { return enabled_; }
+
+        LatencyProbe* get_probe(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = probe_index_.find(name);
+            if (it != probe_index_.end())
+            {
+                return probes_[it->second].get();
+            }
+            probes_.emplace_back(new LatencyProbe(name, probes_.size()));
+            probe_index_[name] = probes_.size() - 1;
+            return probes_.back().get();
+        }
+
+        std::vector<LatencyReport> report() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<LatencyReport> reports;
+            for (const auto& probe : probes_)
+            {
+                reports.push_back(probe->report());
+            }
+            return reports;
+        }
+
+        // one line per probe, micro seconds
+        std::string to_string() const
+        {
+            std::string result;
+            for (const auto& r : report())
+            {
+                result += fmt::format("{:<32} (count) {} (p50 us) {:.3f} (p99 us) {:.3f} (p99.9 us) {:.3f} (max us) {:.3f}\n",
+                                      r.name, r.count, r.p50 / 1000.0, r.p99 / 1000.0, r.p999 / 1000.0, r.max / 1000.0);
+            }
+            return result;
+        }
+
+        // append a report stamped with nano to file_path
+        bool dump(const std::string& file_path, int64_t nano) const
+        {
+            std::ofstream file(file_path, std::ios::app);
+            if (!file)
+            {
+                return false;
+            }
+            file << "(nano) " << nano << "\n" << to_string() << std::endl;
+            return true;
+        }
+
+    private:
+        LatencyRegistry(): enabled_(getenv(LATENCY_PROBE_ENV) != nullptr) {}
+
+        bool enabled_;
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<LatencyProbe>> probes_;
+        std::unordered_map<std::string, size_t> probe_index_;
+    };
+
+    // originating md nano (quote rcv_time) of what the current thread is handling, 0 if none.
+    // set by EventLoop per frame, written to journal frames as extra_nano so it travels to the next process
+    inline int64_t& latency_origin_nano()
+    {
+        thread_local int64_t origin_nano = 0;
+        return origin_nano;
+    }
+
+// record ns at the probe point name, ns is not evaluated unless probes are enabled
+#define LATENCY_PROBE(name, ns) \
+    do \
+    { \
+        if (kungfu::LatencyRegistry::get().enabled()) \
+        { \
+            static kungfu::LatencyProbe* latency_probe_ = kungfu::LatencyRegistry::get().get_probe(name); \
+            latency_probe_->record(ns); \
+        } \
+    } while (0)
+}
+
+#endif //KUNGFU_LATENCY_PROBE_H
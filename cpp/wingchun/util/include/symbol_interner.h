@@ -0,0 +1,282 @@
+//
+// Process wide symbol interner and tables indexed by symbol id.
+//
+
+#ifndef KUNGFU_SYMBOL_INTERNER_H
+#define KUNGFU_SYMBOL_INTERNER_H
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kungfu
+{
+#define SYMBOL_ID_NONE 0xffffffffu
+#define SYMBOL_INTERNER_INIT_SLOTS 4096 // power of 2, grows when half full
+
+    // maps (instrument_id, exchange_id) to a dense id, 0, 1, 2... in order of first sight.
+    // lookup of a known symbol hashes the two c strings and never allocates.
+    // thread safe: the td gateway interns from the event loop and from the api callback threads
+    // (PositionManager on_trade / on_position), every access holds mutex_.
+    // ids and symbol references never change once assigned, so they may be kept without the lock.
+    class SymbolInterner
+    {
+    public:
+        static SymbolInterner& get_interner()
+        {
+            static SymbolInterner interner;
+            return interner;
+        }
+
+        // id of the symbol, assigned if seen for the first time
+        uint32_t intern(const char* instrument_id, const char* exchange_id)
+        {
+            size_t instrument_len, exchange_len;
+            uint32_t hash = hash_symbol(instrument_id, exchange_id, instrument_len, exchange_len);
+            std::lock_guard<std::mutex> lock(mutex_);
+            size_t slot = find_slot(hash, instrument_id, instrument_len, exchange_id, exchange_len);
+            if (slots_[slot].id != SYMBOL_ID_NONE)
+            {
+                return slots_[slot].id;
+            }
+
+            uint32_t id = symbols_.size();
+            std::string symbol;
+            symbol.reserve(instrument_len + 1 + exchange_len);
+            symbol.append(instrument_id, instrument_len).append(1, '.').append(exchange_id, exchange_len);
+            symbols_.emplace_back(std::move(symbol));
+            instrument_lens_.push_back(instrument_len);
+            slots_[slot].hash = hash;
+            slots_[slot].id = id;
+            if (symbols_.size() * 2 > slots_.size())
+            {
+                rehash(slots_.size() * 2);
+            }
+            return id;
+        }
+
+        // id of the symbol, SYMBOL_ID_NONE if never interned
+        uint32_t find(const char* instrument_id, const char* exchange_id) const
+        {
+            size_t instrument_len, exchange_len;
+            uint32_t hash = hash_symbol(instrument_id, exchange_id, instrument_len, exchange_len);
+            std::lock_guard<std::mutex> lock(mutex_);
+            return slots_[find_slot(hash, instrument_id, instrument_len, exchange_id, exchange_len)].id;
+        }
+
+        // same as get_symbol(instrument_id, exchange_id) in business_helper.h, without the copy
+        const std::string& get_symbol(uint32_t id) const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return symbols_[id];
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return symbols_.size();
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t hash;
+            uint32_t id;
+        };
+
+        SymbolInterner(): slots_(SYMBOL_INTERNER_INIT_SLOTS, Slot{0, SYMBOL_ID_NONE}) {}
+        SymbolInterner(const SymbolInterner&) = delete;
+        SymbolInterner& operator=(const SymbolInterner&) = delete;
+
+        // fnv-1a over instrument_id '.' exchange_id, measures both strings on the way
+        static uint32_t hash_symbol(const char* instrument_id, const char* exchange_id, size_t& instrument_len, size_t& exchange_len)
+        {
+            uint32_t hash = 2166136261u;
+            const char* p = instrument_id;
+            for (; *p != 0; p++)
+            {
+                hash = (hash ^ (uint8_t)*p) * 16777619u;
+            }
+            instrument_len = p - instrument_id;
+            hash = (hash ^ (uint8_t)'.') * 16777619u;
+            for (p = exchange_id; *p != 0; p++)
+            {
+                hash = (hash ^ (uint8_t)*p) * 16777619u;
+            }
+            exchange_len = p - exchange_id;
+            return hash;
+        }
+
+        // slot holding the symbol, or the empty slot where it would go
+        size_t find_slot(uint32_t hash, const char* instrument_id, size_t instrument_len, const char* exchange_id, size_t exchange_len) const
+        {
+            size_t mask = slots_.size() - 1;
+            for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                const Slot& s = slots_[slot];
+                if (s.id == SYMBOL_ID_NONE)
+                {
+                    return slot;
+                }
+                if (s.hash == hash && instrument_lens_[s.id] == instrument_len)
+                {
+                    const std::string& symbol = symbols_[s.id];
+                    if (symbol.size() == instrument_len + 1 + exchange_len
+                        && memcmp(symbol.data(), instrument_id, instrument_len) == 0
+                        && memcmp(symbol.data() + instrument_len + 1, exchange_id, exchange_len) == 0)
+                    {
+                        return slot;
+                    }
+                }
+            }
+        }
+
+        void rehash(size_t slot_num)
+        {
+            std::vector<Slot> slots(slot_num, Slot{0, SYMBOL_ID_NONE});
+            size_t mask = slot_num - 1;
+            for (const Slot& s : slots_)
+            {
+                if (s.id != SYMBOL_ID_NONE)
+                {
+                    size_t slot = s.hash & mask;
+                    while (slots[slot].id != SYMBOL_ID_NONE)
+                    {
+                        slot = (slot + 1) & mask;
+                    }
+                    slots[slot] = s;
+                }
+            }
+            slots_.swap(slots);
+        }
+
+        mutable std::mutex mutex_;
+        std::vector<Slot> slots_;
+        std::deque<std::string> symbols_;  // { id -> "instrument_id.exchange_id" }, deque keeps get_symbol references valid
+        std::vector<size_t> instrument_lens_;
+    };
+
+    // values indexed by symbol id. backed by a deque, so growing never moves values
+    // and pointers returned by find stay valid until the value is erased.
+    template <typename T>
+    class SymbolTable
+    {
+    public:
+        SymbolTable(): size_(0) {}
+
+        T* find(uint32_t id)
+        {
+            return id < present_.size() && present_[id] ? &values_[id] : nullptr;
+        }
+
+        const T* find(uint32_t id) const
+        {
+            return id < present_.size() && present_[id] ? &values_[id] : nullptr;
+        }
+
+        // value of id, value initialized if absent
+        T& operator[](uint32_t id)
+        {
+            if (id >= present_.size())
+            {
+                values_.resize(id + 1);
+                present_.resize(id + 1, 0);
+            }
+            if (!present_[id])
+            {
+                values_[id] = T();
+                present_[id] = 1;
+                size_++;
+            }
+            return values_[id];
+        }
+
+        bool erase(uint32_t id)
+        {
+            if (id >= present_.size() || !present_[id])
+            {
+                return false;
+            }
+            present_[id] = 0;
+            size_--;
+            return true;
+        }
+
+        void clear()
+        {
+            present_.assign(present_.size(), 0);
+            size_ = 0;
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        // f(id, value) for each present value, in id order
+        template <typename F>
+        void for_each(F f) const
+        {
+            for (uint32_t id = 0; id < present_.size(); id++)
+            {
+                if (present_[id])
+                {
+                    f(id, values_[id]);
+                }
+            }
+        }
+
+    private:
+        std::deque<T> values_;
+        std::vector<uint8_t> present_;
+        size_t size_;
+    };
+
+    // symbol id index over a std::map keyed by get_symbol, for maps which must stay
+    // string keyed (persisted, iterated in order) but are looked up per tick.
+    // pointers into the map are cached per id and dropped whenever the map size changes,
+    // call reset() if a key is erased and another inserted between two lookups.
+    template <typename T>
+    class SymbolMapIndex
+    {
+    public:
+        explicit SymbolMapIndex(std::map<std::string, T>& map): map_(map), map_size_(0) {}
+
+        // value for the symbol, nullptr if the map does not hold it
+        T* find(const char* instrument_id, const char* exchange_id)
+        {
+            SymbolInterner& interner = SymbolInterner::get_interner();
+            uint32_t id = interner.intern(instrument_id, exchange_id);
+            if (map_.size() != map_size_)
+            {
+                reset();
+            }
+            T** cached = index_.find(id);
+            if (cached != nullptr)
+            {
+                return *cached;
+            }
+            auto iter = map_.find(interner.get_symbol(id));
+            T* value = iter == map_.end() ? nullptr : &iter->second;
+            index_[id] = value;
+            return value;
+        }
+
+        void reset()
+        {
+            index_.clear();
+            map_size_ = map_.size();
+        }
+
+    private:
+        std::map<std::string, T>& map_;
+        size_t map_size_;
+        SymbolTable<T*> index_;
+    };
+}
+
+#endif //KUNGFU_SYMBOL_INTERNER_H
@@ -7,7 +7,7 @@
 
 namespace kungfu
 {
-    void JournalPrinter::print_data(const void* data, kungfu::MsgType msg_type)
+    void JournalPrinter::print_data(const void* data, size_t length, kungfu::MsgType msg_type)
     {
         try
         {
@@ -36,7 +36,29 @@ namespace kungfu
                 }
                 case kungfu::MsgType::AlgoOrderInput:
                 {
-                    j = nlohmann::json::parse(std::string((char *) data));
+                    if (!kungfu::is_algo_msg_valid<kungfu::AlgoOrderInput>(data, length))
+                    {
+                        throw std::runtime_error("incomplete algo order msg");
+                    }
+                    j = *(const kungfu::AlgoOrderInput *) data;
+                    break;
+                }
+                case kungfu::MsgType::AlgoOrderStatus:
+                {
+                    if (!kungfu::is_algo_msg_valid<kungfu::AlgoOrderStatus>(data, length))
+                    {
+                        throw std::runtime_error("incomplete algo order msg");
+                    }
+                    j = *(const kungfu::AlgoOrderStatus *) data;
+                    break;
+                }
+                case kungfu::MsgType::AlgoOrderAction:
+                {
+                    if (!kungfu::is_algo_msg_valid<kungfu::AlgoOrderAction>(data, length))
+                    {
+                        throw std::runtime_error("incomplete algo order msg");
+                    }
+                    j = *(const kungfu::AlgoOrderAction *) data;
                     break;
                 }
                 default:
@@ -48,7 +70,7 @@ namespace kungfu
         }
         catch (std::exception& e)
         {
-            std::cerr << "parse data error, data " << (char*)data << " exception: " <<  e.what() << std::endl;
+            std::cerr << "parse data error, msg type " << (int)msg_type << " exception: " <<  e.what() << std::endl;
         }
     }
 
@@ -60,46 +82,46 @@ namespace kungfu
         int i = 0;
         do
         {
-            kungfu::yijinjing::FramePtr frame = reader->getNextFrame();
-            while (frame.get() != nullptr && end_nano > frame->getNano())
+            kungfu::yijinjing::Frame frame(nullptr);
+            while (reader->getNextFrame(frame) && end_nano > frame.getNano())
             {
-                short msgType = frame->getMsgType();
+                short msgType = frame.getMsgType();
                 bool toPrint = true;
                 if (toPrint)
                 {
                     std::cout << "[" << i++ << "]"
-                              << " (st)" << (short)frame->getStatus()
-                              << " (so)" << frame->getSource()
-                              << " (na)" << frame->getNano()
-                              << " (en)" << frame->getExtraNano();
+                              << " (st)" << (short)frame.getStatus()
+                              << " (so)" << frame.getSource()
+                              << " (na)" << frame.getNano()
+                              << " (en)" << frame.getExtraNano();
                     if (to_time_visual_)
                     {
-                        std::cout << " (vn)" << kungfu::yijinjing::parseNano(frame->getNano(), TIME_FORMAT);
+                        std::cout << " (vn)" << kungfu::yijinjing::parseNano(frame.getNano(), TIME_FORMAT);
                     }
-                    std::cout << " (fl)" << frame->getFrameLength()
-                              << " (dl)" << frame->getDataLength()
-                              << " (hl)" << frame->getHeaderLength()
-                              << " (hs)" << frame->getHashCode()
-                              << " (mt)" << frame->getMsgType()
-                              << " (lf)" << (short)frame->getLastFlag()
-                              << " (id)" << frame->getRequestId()
-                              << " (er)" << frame->getErrorId();
-                    if (frame->getErrorMsg() != nullptr)
+                    std::cout << " (fl)" << frame.getFrameLength()
+                              << " (dl)" << frame.getDataLength()
+                              << " (hl)" << frame.getHeaderLength()
+                              << " (hs)" << frame.getHashCode()
+                              << " (mt)" << frame.getMsgType()
+                              << " (lf)" << (short)frame.getLastFlag()
+                              << " (id)" << frame.getRequestId()
+                              << " (er)" << frame.getErrorId();
+                    if (frame.getErrorMsg() != nullptr)
                     {
-                        std::cout << " (em)" << frame->getErrorMsg();
+                        std::cout << " (em)" << frame.getErrorMsg();
                     }
                     if (length_ > 0)
                     {
-                        std::cout << " (cn)" << string((char*)frame->getData(), std::min(length_, frame->getDataLength()));
+                        std::cout << " (cn)" << string((char*)frame.getData(), std::min(length_, frame.getDataLength()));
                     }
                     if (to_verify_)
                     {
-                        kungfu::yijinjing::FH_TYPE_HASHNM hash = kungfu::yijinjing::MurmurHash2(frame->getData(), frame->getDataLength(), kungfu::yijinjing::HASH_SEED);
-                        if (hash != frame->getHashCode())
+                        kungfu::yijinjing::FH_TYPE_HASHNM hash = kungfu::yijinjing::MurmurHash2(frame.getData(), frame.getDataLength(), kungfu::yijinjing::HASH_SEED);
+                        if (hash != frame.getHashCode())
                         {
                             std::cerr << std::endl << std::endl
                                       << "Hash Code mismatch: "
-                                      << "[frame] " << frame->getHashCode()
+                                      << "[frame] " << frame.getHashCode()
                                       << "  [actual] " << hash << std::endl;
                             return;
                         }
@@ -111,10 +133,9 @@ namespace kungfu
                     std::cout << std::endl;
                     if (need_detail_)
                     {
-                        print_data(frame->getData(), (kungfu::MsgType)msgType);
+                        print_data(frame.getData(), frame.getDataLength(), (kungfu::MsgType)msgType);
                     }
                 }
-                frame = reader->getNextFrame();
             }
         }
         while (keep);
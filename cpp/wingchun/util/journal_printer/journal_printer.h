@@ -49,7 +49,7 @@ namespace kungfu
         bool to_time_visual_;
         bool need_detail_;
 
-        void print_data(const void* data, kungfu::MsgType msg_type);
+        void print_data(const void* data, size_t length, kungfu::MsgType msg_type);
     };
 }
 #endif //KUNGFU_JOURNAL_PRINTER_H
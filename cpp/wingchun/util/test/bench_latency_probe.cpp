@@ -0,0 +1,92 @@
+//
+// Latency probe benchmark.
+// cost of recording at a probe point from several threads, and percentiles of the merged histograms
+// against exact percentiles of the same samples.
+// usage: bench_latency_probe [sample_num] [thread_num]
+//
+
+#include "util/include/latency_probe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv)
+{
+    int sample_num = (argc > 1) ? atoi(argv[1]) : 2000000;
+    int thread_num = (argc > 2) ? atoi(argv[2]) : 2;
+    setenv(LATENCY_PROBE_ENV, "1", 1);
+    std::cout << "(samples) " << sample_num << " (threads) " << thread_num << std::endl;
+
+    // log-normal latencies around 5us with a long tail
+    std::vector<std::vector<int64_t>> samples(thread_num);
+    for (int t = 0; t < thread_num; t++)
+    {
+        std::mt19937_64 rng(t);
+        std::lognormal_distribution<double> dist(std::log(5000.0), 0.8);
+        samples[t].resize(sample_num / thread_num);
+        for (auto& sample : samples[t])
+        {
+            sample = (int64_t)dist(rng);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<int64_t> thread_ns(thread_num);
+    for (int t = 0; t < thread_num; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            int64_t start = now_nano();
+            for (int64_t sample : samples[t])
+            {
+                LATENCY_PROBE("bench.sample", sample);
+            }
+            thread_ns[t] = now_nano() - start;
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    int64_t total_ns = 0;
+    for (int64_t ns : thread_ns)
+    {
+        total_ns += ns;
+    }
+    std::cout << "[record] (ns per sample) " << (double)total_ns / sample_num << std::endl;
+
+    std::vector<int64_t> all;
+    for (const auto& s : samples)
+    {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+    LatencyReport report = LatencyRegistry::get().get_probe("bench.sample")->report();
+    bool ok = report.count == all.size() && report.max == all.back();
+    auto check = [&](const char* name, int64_t value, double ratio)
+    {
+        int64_t exact = all[(size_t)(all.size() * ratio)];
+        double error = std::abs((double)(value - exact)) / exact;
+        std::cout << "(" << name << ") histogram " << value << " exact " << exact << " (error %) " << error * 100 << std::endl;
+        ok = ok && error < 0.04;
+    };
+    check("p50", report.p50, 0.5);
+    check("p99", report.p99, 0.99);
+    check("p99.9", report.p999, 0.999);
+    std::cout << LatencyRegistry::get().to_string();
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+//
+// Symbol lookup benchmark.
+// per tick quote store and position lookup keyed by get_symbol in std::map (the old path)
+// against symbol ids from SymbolInterner with SymbolTable / SymbolMapIndex.
+// usage: bench_symbol_interner [symbol_num] [tick_num]
+//
+
+#include "util/include/symbol_interner.h"
+#include "util/include/business_helper.h"
+#include "md_struct.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+using namespace kungfu;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv)
+{
+    int symbol_num = (argc > 1) ? atoi(argv[1]) : 4000;
+    int tick_num = (argc > 2) ? atoi(argv[2]) : 2000000;
+
+    std::vector<Quote> quotes(symbol_num);
+    std::map<std::string, Position> pos_map;
+    for (int i = 0; i < symbol_num; i++)
+    {
+        Quote& quote = quotes[i];
+        snprintf(quote.instrument_id, sizeof(quote.instrument_id), "%06d", 600000 + i);
+        strcpy(quote.exchange_id, i % 2 == 0 ? EXCHANGE_SSE : EXCHANGE_SZE);
+        quote.last_price = i;
+        // one in four symbols held
+        if (i % 4 == 0)
+        {
+            Position& pos = pos_map[get_symbol(quote.instrument_id, quote.exchange_id)];
+            strcpy(pos.instrument_id, quote.instrument_id);
+            strcpy(pos.exchange_id, quote.exchange_id);
+        }
+    }
+    std::cout << "(symbols) " << symbol_num << " (held) " << pos_map.size() << " (ticks) " << tick_num << std::endl;
+
+    // ticks hit symbols in a scattered order
+    std::vector<int> order(tick_num);
+    for (int i = 0; i < tick_num; i++)
+    {
+        order[i] = (int)((i * 2654435761u) % symbol_num);
+    }
+
+    double checksum_map = 0;
+    std::map<std::string, Quote> quote_map;
+    int64_t start = now_nano();
+    for (int i = 0; i < tick_num; i++)
+    {
+        const Quote& quote = quotes[order[i]];
+        quote_map[get_symbol(quote.instrument_id, quote.exchange_id)] = quote;
+        auto iter = pos_map.find(get_symbol(quote.instrument_id, quote.exchange_id));
+        if (iter != pos_map.end())
+        {
+            iter->second.last_price = quote.last_price;
+            checksum_map += iter->second.last_price;
+        }
+    }
+    int64_t map_ns = now_nano() - start;
+
+    double checksum_id = 0;
+    SymbolTable<Quote> quote_table;
+    SymbolMapIndex<Position> pos_index(pos_map);
+    SymbolInterner& interner = SymbolInterner::get_interner();
+    start = now_nano();
+    for (int i = 0; i < tick_num; i++)
+    {
+        const Quote& quote = quotes[order[i]];
+        quote_table[interner.intern(quote.instrument_id, quote.exchange_id)] = quote;
+        Position* pos = pos_index.find(quote.instrument_id, quote.exchange_id);
+        if (pos != nullptr)
+        {
+            pos->last_price = quote.last_price;
+            checksum_id += pos->last_price;
+        }
+    }
+    int64_t id_ns = now_nano() - start;
+
+    bool ok = checksum_map == checksum_id && quote_table.size() == quote_map.size() && interner.size() == (size_t)symbol_num;
+    for (int i = 0; ok && i < symbol_num; i++)
+    {
+        const Quote& quote = quotes[i];
+        uint32_t id = interner.find(quote.instrument_id, quote.exchange_id);
+        ok = id != SYMBOL_ID_NONE && interner.get_symbol(id) == get_symbol(quote.instrument_id, quote.exchange_id)
+             && quote_table.find(id) != nullptr && quote_table.find(id)->last_price == quote.last_price;
+    }
+    ok = ok && interner.find("000000", EXCHANGE_SSE) == SYMBOL_ID_NONE;
+
+    std::cout << "[std::map + get_symbol] (ns per tick) " << map_ns / tick_num << std::endl;
+    std::cout << "[symbol id            ] (ns per tick) " << id_ns / tick_num << std::endl;
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -86,8 +86,14 @@ public:
     void setErrorData(FH_TYPE_ERR_ID, const char* errorMsg, const void* data, size_t dataLen);
     /** set data with length */
     void setData(const void*, size_t);
+    /** set length for data filled in place via getData (no error msg) */
+    void setDataLength(size_t);
+    /** hash data filled in place, only effective with FRAME_AUTO_SET_HASHCODE */
+    void setDataHashCode();
     /** mark status as written */
     void setStatusWritten();
+    /** mark status as written, leave next frame untouched (already reserved in the same batch) */
+    void setStatusWrittenInBatch();
     /** mark status as page closed */
     void setStatusPageClosed();
     /** move the frame forward by length */
@@ -290,6 +296,24 @@ inline void Frame::setData(const void* data, size_t dataLength)
 #endif
 }
 
+inline void Frame::setDataLength(size_t dataLength)
+{
+    frame->err_id = 0;
+    setFrameLength(BASIC_FRAME_HEADER_LENGTH + dataLength);
+}
+
+inline void Frame::setDataHashCode()
+{
+#ifdef FRAME_AUTO_SET_HASHCODE
+    setHashCode(MurmurHash2(getData(), getDataLength(), HASH_SEED));
+#endif
+}
+
+inline void Frame::setStatusWrittenInBatch()
+{
+    setStatus(JOURNAL_FRAME_STATUS_WRITTEN);
+}
+
 inline void Frame::setStatusWritten()
 {
     /** just make sure next frame won't be wrongly read */
@@ -33,8 +33,9 @@ FORWARD_DECLARE_PTR(Page);
 class IPageProvider
 {
 public:
-    /** return wrapped Page via directory / journal short name / serviceIdx assigned / page number */
-    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum) = 0;
+    /** return wrapped Page via directory / journal short name / serviceIdx assigned / page number,
+     * pageSize is only used when a new page is created */
+    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum, int pageSize) = 0;
     /** release page after using */
     virtual void releasePage(void* buffer, int size, int serviceIdx) = 0;
     /** return true if this is for writing */
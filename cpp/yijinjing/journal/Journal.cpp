@@ -42,24 +42,43 @@ void Journal::seekTime(int64_t time)
 {
     // before seek to time, should release current page first
     if (curPage.get() != nullptr)
-        pageProvider->releasePage(curPage->getBuffer(), JOURNAL_PAGE_SIZE, serviceIdx);
+    {
+        pageProvider->releasePage(curPage->getBuffer(), curPage->getPageSize(), serviceIdx);
+        curPage.reset();
+    }
 
     if (time == TIME_TO_LAST)
     {
         vector<short> pageNums = PageUtil::GetPageNums(directory, shortName);
-        curPage = pageProvider->getPage(directory, shortName, serviceIdx, (pageNums.size() > 0) ? pageNums.back() : 1);
+        curPage = pageProvider->getPage(directory, shortName, serviceIdx, (pageNums.size() > 0) ? pageNums.back() : 1, pageSize);
         if (curPage.get() != nullptr)
             curPage->passWrittenFrame();
     }
     else if (time == TIME_FROM_FIRST)
     {
         vector<short> pageNums = PageUtil::GetPageNums(directory, shortName);
-        curPage = pageProvider->getPage(directory, shortName, serviceIdx, (pageNums.size() > 0) ? pageNums.front() : 1);
+        curPage = pageProvider->getPage(directory, shortName, serviceIdx, (pageNums.size() > 0) ? pageNums.front() : 1, pageSize);
     }
     else
     {
-        short pageNum = PageUtil::GetPageNumWithTime(directory, shortName, time);
-        curPage = pageProvider->getPage(directory, shortName, serviceIdx, pageNum);
+        // O(log n) through time index, then walk at most one index interval
+        JournalIndexEntry entry;
+        JournalIndexPtr timeIndex = JournalIndex::openForRead(directory, shortName);
+        if (timeIndex.get() != nullptr && timeIndex->lookup(time, entry))
+        {
+            curPage = pageProvider->getPage(directory, shortName, serviceIdx, entry.page_num, pageSize);
+            if (curPage.get() != nullptr && !curPage->jumpToIndexEntry(entry))
+            {   // stale index, scan pages instead
+                pageProvider->releasePage(curPage->getBuffer(), curPage->getPageSize(), serviceIdx);
+                curPage.reset();
+            }
+        }
+        // journals without index, or time before first entry
+        if (curPage.get() == nullptr)
+        {
+            short pageNum = PageUtil::GetPageNumWithTime(directory, shortName, time);
+            curPage = pageProvider->getPage(directory, shortName, serviceIdx, pageNum, pageSize);
+        }
         if (curPage.get() != nullptr)
             curPage->passToTime(time);
     }
@@ -75,17 +94,19 @@ void Journal::loadNextPage()
 
     if (curPage.get() == nullptr)
     {
-        curPage = pageProvider->getPage(directory, shortName, serviceIdx, 1);
+        curPage = pageProvider->getPage(directory, shortName, serviceIdx, 1, pageSize);
     }
     else
     {   // allocate new page
-        PagePtr newPage = pageProvider->getPage(directory, shortName, serviceIdx, curPage->getPageNum() + 1);
+        PagePtr newPage = pageProvider->getPage(directory, shortName, serviceIdx, curPage->getPageNum() + 1, pageSize);
         // stop current page
         if (isWriting)
         {
-            curPage->finishPage();
+            int64_t closeNano = curPage->finishPage();
+            if (index.get() != nullptr)
+                index->onPageEnd(closeNano, curPage->getPageNum(), curPage->getPosition());
         }
-        pageProvider->releasePage(curPage->getBuffer(), JOURNAL_PAGE_SIZE, serviceIdx);
+        pageProvider->releasePage(curPage->getBuffer(), curPage->getPageSize(), serviceIdx);
         // reset current page
         curPage = newPage;
     }
@@ -98,10 +119,10 @@ void Journal::expire()
         expired = true;
         if (curPage.get() != nullptr)
         {
-            pageProvider->releasePage(curPage->getBuffer(), JOURNAL_PAGE_SIZE, serviceIdx);
+            pageProvider->releasePage(curPage->getBuffer(), curPage->getPageSize(), serviceIdx);
             curPage.reset();
         }
         // set page expire in page engine
-        pageProvider->getPage(directory, shortName, serviceIdx, -1);
+        pageProvider->getPage(directory, shortName, serviceIdx, -1, pageSize);
     }
 }
@@ -26,6 +26,7 @@
 
 #include "YJJ_DECLARE.h"
 #include "Page.h"
+#include "JournalIndex.h"
 
 YJJ_NAMESPACE_START
 
@@ -52,8 +53,12 @@ private:
     bool    expired;
     /** current page in use */
     PagePtr curPage;
+    /** size of new pages created by this journal (writer only) */
+    int     pageSize;
+    /** time index maintained by writer, empty for reader */
+    JournalIndexPtr index;
     /** private constructor, make create the only builder */
-    Journal(): expired(false){};
+    Journal(): expired(false), pageSize(JOURNAL_PAGE_SIZE){};
 
 public:
     /** the only entrance of creating a Journal */
@@ -65,14 +70,27 @@ public:
     void    seekTime(int64_t time);
     /** get frame address return nullptr if no available */
     void*   locateFrame();
+    /** get frame address to extend a reserved batch in current page (writer only),
+     * return nullptr if it does not fit, never loads next page */
+    void*   locateBatchFrame(int frameLength);
     /** move forward to next frame */
     void    passFrame();
+    /** record the frame just written at current position in time index (writer only) */
+    void    indexFrame(int64_t nano);
+    /** record the frame written at position of current page in time index (writer only) */
+    void    indexFrame(int64_t nano, int position);
+    /** get position in current page */
+    int     getCurPosition() const;
     /** load next page, current page will be released if not empty */
     void    loadNextPage();
     /** get current page number */
     short   getCurPageNum() const;
     /** get journal short name */
     string  getShortName() const;
+    /** set size of pages created afterwards, existing pages keep their own size */
+    void    setPageSize(int size) { pageSize = size; }
+    /** set time index to maintain (writer only) */
+    void    setIndex(JournalIndexPtr idx) { index = idx; }
 };
 
 inline void* Journal::locateFrame()
@@ -101,11 +119,32 @@ inline void* Journal::locateFrame()
     return nullptr;
 };
 
+inline void* Journal::locateBatchFrame(int frameLength)
+{
+    return curPage->locateReservableFrame(frameLength);
+}
+
 inline void Journal::passFrame()
 {   // only called after frame is taken, so current frame is applicable for sure; just skip
     curPage->passFrame();
 }
 
+inline void Journal::indexFrame(int64_t nano)
+{
+    indexFrame(nano, curPage->getPosition());
+}
+
+inline void Journal::indexFrame(int64_t nano, int position)
+{
+    if (index.get() != nullptr)
+        index->onFrame(nano, curPage->getPageNum(), position);
+}
+
+inline int Journal::getCurPosition() const
+{
+    return curPage->getPosition();
+}
+
 inline short Journal::getCurPageNum() const
 {
     return curPage->getPageNum();
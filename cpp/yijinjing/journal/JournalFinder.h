@@ -34,7 +34,7 @@
 
 YJJ_NAMESPACE_START
 
-#define JOURNAL_NAME_PATTERN JOURNAL_PREFIX + "\\.(\\w+)\\.[0-9]+\\." + JOURNAL_SUFFIX
+#define JOURNAL_NAME_PATTERN JOURNAL_PREFIX + "\\.(\\w+)\\.[0-9]+\\." + JOURNAL_SUFFIX + "(\\." + JOURNAL_ARCHIVE_SUFFIX + ")?"
 
 class JournalFinder {
 private:
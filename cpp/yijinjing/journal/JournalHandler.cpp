@@ -38,7 +38,8 @@ string JournalHandler::getDefaultName(const string& prefix)
     return ss.str();
 }
 
-size_t JournalHandler::addJournal(const string& _dir, const string& jname)
+/** strip the '/' in the back and create the folder if not exists */
+string prepareJournalFolder(const string& _dir)
 {
     // TODO fix this with boost filesystem
     // directory should not contain '/' in the back
@@ -52,13 +53,34 @@ size_t JournalHandler::addJournal(const string& _dir, const string& jname)
     if(!boost::filesystem::exists(page_folder_path)) {
         boost::filesystem::create_directories(page_folder_path);
     }
+    return dir;
+}
 
+size_t JournalHandler::addJournal(const string& _dir, const string& jname)
+{
+    string dir = prepareJournalFolder(_dir);
     // register this journal
     int service_idx = page_provider->register_journal(dir, jname);
     journals.push_back(Journal::create(dir, jname, service_idx, page_provider));
     return journals.size() - 1;
 }
 
+vector<size_t> JournalHandler::addJournals(const vector<string>& _dirs, const vector<string>& jnames)
+{
+    vector<string> dirs;
+    for (const string& dir: _dirs)
+        dirs.push_back(prepareJournalFolder(dir));
+    // register all in one go
+    vector<int> service_idx_vec = page_provider->register_journals(dirs, jnames);
+    vector<size_t> idx_vec;
+    for (size_t i = 0; i < jnames.size(); i++)
+    {
+        journals.push_back(Journal::create(dirs[i], jnames[i], service_idx_vec[i], page_provider));
+        idx_vec.push_back(journals.size() - 1);
+    }
+    return idx_vec;
+}
+
 JournalHandler::~JournalHandler()
 {
     page_provider->exit_client();
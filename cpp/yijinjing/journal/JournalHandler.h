@@ -56,6 +56,8 @@ public:
     virtual ~JournalHandler();
     /** return the journal's index in the vector */
     virtual size_t addJournal(const string& dir, const string& jname);
+    /** add journals registered to service together, return their indices in the vector */
+    virtual vector<size_t> addJournals(const vector<string>& dirs, const vector<string>& jnames);
     /** default name */
     static string getDefaultName(const string& prefix);
 };
@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Journal time index.
+ */
+
+#include "JournalIndex.h"
+#include "PageUtil.h"
+
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define ENTRY_SIZE sizeof(JournalIndexEntry)
+
+JournalIndex::JournalIndex(FILE* file): file(file), framesSinceLast(0), lastNano(0), lastPageNum(-1), pendingEntries(0) {}
+
+JournalIndex::~JournalIndex()
+{
+    if (file != nullptr)
+        fclose(file);
+}
+
+void JournalIndex::append(int64_t nano, short pageNum, int position, short kind)
+{
+    // the first entry after writer (re)started is in the middle of a page
+    if (kind == JOURNAL_INDEX_PAGE_START && lastPageNum < 0)
+        kind = JOURNAL_INDEX_SPARSE;
+    JournalIndexEntry entry = {nano, position, pageNum, kind};
+    // sparse entries stay in stdio buffer, readers fall back to the page start entry meanwhile
+    fwrite(&entry, ENTRY_SIZE, 1, file);
+    if (kind != JOURNAL_INDEX_SPARSE || ++pendingEntries >= JOURNAL_INDEX_FLUSH_ENTRIES)
+    {
+        fflush(file);
+        pendingEntries = 0;
+    }
+    framesSinceLast = 0;
+    lastNano = nano;
+    lastPageNum = pageNum;
+}
+
+void JournalIndex::onPageEnd(int64_t closeNano, short pageNum, int position)
+{
+    append(closeNano, pageNum, position, JOURNAL_INDEX_PAGE_END);
+}
+
+bool JournalIndex::lookup(int64_t time, JournalIndexEntry& entry)
+{
+    if (fseek(file, 0, SEEK_END) != 0)
+        return false;
+    long num = ftell(file) / ENTRY_SIZE;
+    // binary search for the last entry with nano < time
+    long lo = 0, hi = num;
+    JournalIndexEntry cur;
+    bool found = false;
+    while (lo < hi)
+    {
+        long mid = lo + (hi - lo) / 2;
+        if (fseek(file, mid * ENTRY_SIZE, SEEK_SET) != 0 || fread(&cur, ENTRY_SIZE, 1, file) != 1)
+            return false;
+        if (cur.nano < time)
+        {
+            entry = cur;
+            found = true;
+            lo = mid + 1;
+        }
+        else
+            hi = mid;
+    }
+    return found;
+}
+
+JournalIndexPtr JournalIndex::openForWrite(const string& dir, const string& jname)
+{
+    string path = PageUtil::GenIndexFullPath(dir, jname);
+    boost::system::error_code ec;
+    uintmax_t size = boost::filesystem::file_size(path, ec);
+    // drop the half written entry left by a crashed writer
+    if (!ec && size % ENTRY_SIZE != 0)
+        boost::filesystem::resize_file(path, size - size % ENTRY_SIZE, ec);
+    FILE* file = fopen(path.c_str(), "ab");
+    if (file == nullptr)
+    {
+        perror("cannot open journal index for write");
+        return JournalIndexPtr();
+    }
+    return JournalIndexPtr(new JournalIndex(file));
+}
+
+JournalIndexPtr JournalIndex::openForRead(const string& dir, const string& jname)
+{
+    FILE* file = fopen(PageUtil::GenIndexFullPath(dir, jname).c_str(), "rb");
+    if (file == nullptr)
+        return JournalIndexPtr();
+    return JournalIndexPtr(new JournalIndex(file));
+}
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Journal time index.
+ * Sidecar file of a journal, appended by its writer only.
+ * Each entry points to a written frame (or a page end), entries are sorted by nano,
+ * so seeking to a time is a binary search plus a short walk inside one page.
+ */
+
+#ifndef YIJINJING_JOURNALINDEX_H
+#define YIJINJING_JOURNALINDEX_H
+
+#include "YJJ_DECLARE.h"
+#include "constants.h"
+
+#include <cstdio>
+
+YJJ_NAMESPACE_START
+
+FORWARD_DECLARE_PTR(JournalIndex);
+
+//////////////////////////////////////////
+/// (short) JournalIndexKind
+//////////////////////////////////////////
+#define JOURNAL_INDEX_PAGE_START    1 /**< first frame of a page */
+#define JOURNAL_INDEX_SPARSE        2 /**< frame picked every N frames or T nanoseconds */
+#define JOURNAL_INDEX_PAGE_END      3 /**< page end, nano is close nano of the page */
+
+struct JournalIndexEntry
+{
+    /** nano time of the frame */
+    int64_t nano;
+    /** position of the frame in page */
+    int     position;
+    /** page number of the frame */
+    short   page_num;
+    /** JournalIndexKind */
+    short   kind;
+};
+
+class JournalIndex
+{
+private:
+    /** index file, opened for append by writer or for read by reader */
+    FILE*   file;
+    /** writer only, frames passed since last entry */
+    int     framesSinceLast;
+    /** writer only, nano of last entry */
+    int64_t lastNano;
+    /** writer only, page number of last entry */
+    short   lastPageNum;
+    /** writer only, entries appended and not flushed yet */
+    int     pendingEntries;
+
+    JournalIndex(FILE* file);
+    void    append(int64_t nano, short pageNum, int position, short kind);
+
+public:
+    ~JournalIndex();
+
+    /** writer only, called after each frame written, entry is only added when necessary */
+    inline void onFrame(int64_t nano, short pageNum, int position)
+    {
+        if (pageNum != lastPageNum)
+            append(nano, pageNum, position, JOURNAL_INDEX_PAGE_START);
+        else if (++framesSinceLast >= JOURNAL_INDEX_FRAME_INTERVAL || nano - lastNano >= JOURNAL_INDEX_NANO_INTERVAL)
+            append(nano, pageNum, position, JOURNAL_INDEX_SPARSE);
+    }
+    /** writer only, called when page is finished */
+    void    onPageEnd(int64_t closeNano, short pageNum, int position);
+
+    /** reader only, find last entry with nano < time, return false if no such entry */
+    bool    lookup(int64_t time, JournalIndexEntry& entry);
+
+public:
+    /** open index for append, return empty ptr if failed */
+    static JournalIndexPtr openForWrite(const string& dir, const string& jname);
+    /** open index for read, return empty ptr if the journal has no index */
+    static JournalIndexPtr openForRead(const string& dir, const string& jname);
+};
+
+YJJ_NAMESPACE_END
+
+#endif //YIJINJING_JOURNALINDEX_H
@@ -25,19 +25,50 @@
 
 #include "JournalReader.h"
 #include "PageProvider.h"
+#include "PageCommStruct.h"
 #include "Timer.h"
 #include <sstream>
+#include <algorithm>
 #include <assert.h>
 
 USING_YJJ_NAMESPACE
 
 const string JournalReader::FILE_PREFIX = "reader";
 
-JournalReader::JournalReader(PageProviderPtr ptr): JournalHandler(ptr)
+JournalReader::JournalReader(PageProviderPtr ptr): JournalHandler(ptr), mergeMode(MERGE_LINEAR_SCAN), takenIdx(-1),
+                                                   idleCountdown(0), idlePollInterval(DEFAULT_IDLE_POLL_INTERVAL), headsDirty(true),
+                                                   doorbell(ptr->getDoorbell())
 {
     journalMap.clear();
 }
 
+void JournalReader::setMergeMode(JournalMergeMode mode, int pollInterval)
+{
+    mergeMode = mode;
+    idlePollInterval = (pollInterval > 0) ? pollInterval : 1;
+    headsDirty = true;
+}
+
+void JournalReader::pollIdleJournals()
+{
+    vector<size_t> idles;
+    idles.swap(idleJournals);
+    for (size_t idx: idles)
+        pushHead(idx);
+    idleCountdown = idlePollInterval;
+}
+
+void JournalReader::rebuildHeads()
+{
+    heads.clear();
+    idleJournals.clear();
+    for (size_t idx = 0; idx < journals.size(); idx++)
+        pushHead(idx);
+    takenIdx = -1;
+    idleCountdown = idlePollInterval;
+    headsDirty = false;
+}
+
 size_t JournalReader::addJournal(const string& dir, const string& jname)
 {
     if (journalMap.find(jname) != journalMap.end())
@@ -48,10 +79,37 @@ size_t JournalReader::addJournal(const string& dir, const string& jname)
     {
         size_t idx = JournalHandler::addJournal(dir, jname);
         journalMap[jname] = idx;
+        headsDirty = true;
         return idx;
     }
 }
 
+vector<size_t> JournalReader::addJournals(const vector<string>& dirs, const vector<string>& jnames)
+{
+    vector<string> new_dirs;
+    vector<string> new_jnames;
+    for (size_t i = 0; i < jnames.size(); i++)
+    {
+        if (journalMap.find(jnames[i]) == journalMap.end()
+            && std::find(new_jnames.begin(), new_jnames.end(), jnames[i]) == new_jnames.end())
+        {
+            new_dirs.push_back(dirs[i]);
+            new_jnames.push_back(jnames[i]);
+        }
+    }
+    if (!new_jnames.empty())
+    {
+        vector<size_t> new_idx_vec = JournalHandler::addJournals(new_dirs, new_jnames);
+        for (size_t i = 0; i < new_jnames.size(); i++)
+            journalMap[new_jnames[i]] = new_idx_vec[i];
+        headsDirty = true;
+    }
+    vector<size_t> idx_vec;
+    for (const string& jname: jnames)
+        idx_vec.push_back(journalMap[jname]);
+    return idx_vec;
+}
+
 JournalReaderPtr JournalReader::create(const vector<string>& dirs, const vector<string>& jnames, int64_t startTime, const string& readerName)
 {
     std::stringstream ss;
@@ -62,11 +120,15 @@ JournalReaderPtr JournalReader::create(const vector<string>& dirs, const vector<
 #else
     PageProviderPtr provider = PageProviderPtr(new LocalPageProvider(false));
 #endif
+    return JournalReader::create(dirs, jnames, startTime, provider);
+}
+
+JournalReaderPtr JournalReader::create(const vector<string>& dirs, const vector<string>& jnames, int64_t startTime, PageProviderPtr provider)
+{
     JournalReaderPtr jrp = JournalReaderPtr(new JournalReader(provider));
 
     assert(dirs.size() == jnames.size());
-    for (size_t i = 0; i < dirs.size(); i++)
-        jrp->addJournal(dirs[i], jnames[i]);
+    jrp->addJournals(dirs, jnames);
     jrp->jumpStart(startTime);
     return jrp;
 }
@@ -137,6 +199,30 @@ void JournalReader::jumpStart(int64_t startTime)
 {
     for (JournalPtr& journal: journals)
         journal->seekTime(startTime);
+    headsDirty = true;
+}
+
+bool JournalReader::waitNextFrame(Frame& frame, int timeoutMicro)
+{
+    if (getNextFrame(frame))
+        return true;
+    if (timeoutMicro <= 0)
+        return false;
+    if (doorbell == nullptr)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(timeoutMicro, JOURNAL_POLL_MICROSEC)));
+        return getNextFrame(frame);
+    }
+    // check once more after announcing, a writer publishing in between either is seen here or rings
+    int seq = comm_begin_park_journal(doorbell);
+    bool found = getNextFrame(frame);
+    if (!found)
+    {
+        comm_park_journal(doorbell, seq, timeoutMicro);
+        found = getNextFrame(frame);
+    }
+    comm_end_park_journal(doorbell);
+    return found;
 }
 
 string JournalReader::getFrameName() const
@@ -149,15 +235,14 @@ string JournalReader::getFrameName() const
 
 void JournalReader::startVisiting()
 {
-    FramePtr frame;
+    Frame frame(nullptr);
     while (true)
     {
-        frame = getNextFrame();
-        if (frame.get() != nullptr)
+        if (getNextFrame(frame))
         {
             string name = getFrameName();
             for (auto visitor: visitors)
-                visitor->visit(name, *frame);
+                visitor->visit(name, frame);
         }
     }
 }
@@ -173,6 +258,7 @@ bool JournalReader::expireJournal(size_t idx)
     if (idx < journals.size())
     {
         journals[idx]->expire();
+        headsDirty = true;
         return true;
     }
     return false;
@@ -183,6 +269,7 @@ bool JournalReader::seekTimeJournal(size_t idx, int64_t nano)
     if (idx < journals.size())
     {
         journals[idx]->seekTime(nano);
+        headsDirty = true;
         return true;
     }
     return false;
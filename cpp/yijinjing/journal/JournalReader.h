@@ -30,10 +30,38 @@
 #include "IJournalVisitor.h"
 #include "Frame.hpp" // for inline function
 #include "Journal.h" // for inline function
+#include <algorithm> // heap operations
 
 YJJ_NAMESPACE_START
 
 FORWARD_DECLARE_PTR(JournalReader);
+struct PageCommDoorbell;
+
+/** how frames of multiple journals are merged into one stream */
+enum JournalMergeMode
+{
+    /** locate every journal for every frame, O(N) per frame */
+    MERGE_LINEAR_SCAN = 0,
+    /** keep a min-heap of journal heads, idle journals are re-polled periodically */
+    MERGE_MIN_HEAP = 1,
+};
+
+/** in MERGE_MIN_HEAP mode, idle journals are polled once every this many frames */
+const int DEFAULT_IDLE_POLL_INTERVAL = 64;
+
+/** nano time of the frame at the head of a journal (MERGE_MIN_HEAP) */
+struct JournalHead
+{
+    int64_t nano;
+    size_t  idx;
+    /** heap comparator, std heap is max-heap so order is reversed,
+     * ties are broken by journal index to keep the same order as linear scan */
+    bool operator < (const JournalHead& h) const
+    {
+        return nano > h.nano || (nano == h.nano && idx > h.idx);
+    }
+};
+
 /**
  * Journal Reader
  */
@@ -46,12 +74,49 @@ private:
     vector<IJournalVisitor*> visitors;
     /** map from journal short name to its idx */
     map<string, size_t> journalMap;
+    /** how journals are merged */
+    JournalMergeMode mergeMode;
+    /** heap of journals with a readable frame (MERGE_MIN_HEAP) */
+    vector<JournalHead> heads;
+    /** journals without readable frame (MERGE_MIN_HEAP) */
+    vector<size_t> idleJournals;
+    /** index of journal whose frame was just taken, re-located on next call (MERGE_MIN_HEAP) */
+    int     takenIdx;
+    /** frames left before idle journals are polled again (MERGE_MIN_HEAP) */
+    int     idleCountdown;
+    /** poll interval of idle journals in frames (MERGE_MIN_HEAP) */
+    int     idlePollInterval;
+    /** heads need to be rebuilt, after journal added / seeked / expired */
+    bool    headsDirty;
+    /** writers ring it after publishing frames, nullptr without paged */
+    PageCommDoorbell* doorbell;
     /** private constructor */
     JournalReader(PageProviderPtr ptr);
 
+private:
+    /** locate next frame by scanning all journals */
+    void* locateNextLinear(size_t& idx);
+    /** locate next frame with journal heads heap */
+    void* locateNextHeap(size_t& idx);
+    /** push journal into heads if it has a readable frame, otherwise mark it idle */
+    void  pushHead(size_t idx);
+    /** locate all idle journals and move the readable ones into heads */
+    void  pollIdleJournals();
+    /** rebuild heads from all journals */
+    void  rebuildHeads();
+
 public:
     /** [usage]: next frame, and process the frame */
     FramePtr getNextFrame();
+    /** [usage]: point caller-owned frame to next frame, no heap allocation,
+     * return false if no frame is available (frame stays untouched) */
+    bool  getNextFrame(Frame& frame);
+    /** same as getNextFrame, but park the thread until some writer publishes frames
+     * or timeoutMicro passed if nothing is readable now,
+     * without paged it sleeps a short while instead of parking */
+    bool  waitNextFrame(Frame& frame, int timeoutMicro);
+    /** park on another doorbell, e.g. one shared by processes using local page provider */
+    void  setDoorbell(PageCommDoorbell* bell) { doorbell = bell; }
     /** to keep the last time's getNextFrame's source. */
     string   getFrameName() const;
     /** [usage]: keep looping and visiting */
@@ -60,6 +125,10 @@ public:
     /** override JournalHandler's addJournal,
      * allow re-add journal with same name */
     virtual size_t addJournal(const string& dir, const string& jname);
+    /** override JournalHandler's addJournals, same as addJournal */
+    virtual vector<size_t> addJournals(const vector<string>& dirs, const vector<string>& jnames);
+    /** switch merge mode, idle poll interval only takes effect in MERGE_MIN_HEAP */
+    void  setMergeMode(JournalMergeMode mode, int pollInterval=DEFAULT_IDLE_POLL_INTERVAL);
     /** add visitor for "startVisiting" usage  */
     bool  addVisitor(IJournalVisitor* visitor);
     /** all journals jump to start time */
@@ -108,6 +177,11 @@ public:
                                                 int64_t startTime,
                                                 const string& readerName);
 
+    static JournalReaderPtr create(const vector<string>& dirs,
+                                   const vector<string>& jnames,
+                                   int64_t startTime,
+                                   PageProviderPtr provider);
+
     static JournalReaderPtr createSysReader(const string& readerName);
     /** revisable reader is a reader with authority to revise data it reads */
     static JournalReaderPtr createRevisableReader(const string& readerName);
@@ -116,13 +190,13 @@ public:
 
 };
 
-inline FramePtr JournalReader::getNextFrame()
+inline void* JournalReader::locateNextLinear(size_t& idx)
 {
     int64_t  minNano = TIME_TO_LAST;
     void* res_address = nullptr;
-    for (JournalPtr& journal: journals)
+    for (size_t i = 0; i < journals.size(); i++)
     {
-        FrameHeader* header = (FrameHeader*)(journal->locateFrame());
+        FrameHeader* header = (FrameHeader*)(journals[i]->locateFrame());
         if (header != nullptr)
         {
             int64_t nano = header->nano;
@@ -130,19 +204,75 @@ inline FramePtr JournalReader::getNextFrame()
             {
                 minNano = nano;
                 res_address = header;
-                curJournal = journal;
+                idx = i;
             }
         }
     }
-    if (res_address != nullptr)
+    return res_address;
+}
+
+inline void JournalReader::pushHead(size_t idx)
+{
+    FrameHeader* header = (FrameHeader*)(journals[idx]->locateFrame());
+    if (header != nullptr)
+    {
+        heads.push_back({header->nano, idx});
+        std::push_heap(heads.begin(), heads.end());
+    }
+    else
+    {
+        idleJournals.push_back(idx);
+    }
+}
+
+inline void* JournalReader::locateNextHeap(size_t& idx)
+{
+    if (headsDirty)
     {
-        curJournal->passFrame();
-        return FramePtr(new Frame(res_address));
+        rebuildHeads();
     }
     else
     {
-        return FramePtr();
+        // the frame taken last time has been processed, safe to move on
+        if (takenIdx >= 0)
+        {
+            pushHead(takenIdx);
+            takenIdx = -1;
+        }
+        if (heads.empty() || --idleCountdown <= 0)
+            pollIdleJournals();
     }
+    if (heads.empty())
+        return nullptr;
+    std::pop_heap(heads.begin(), heads.end());
+    idx = heads.back().idx;
+    heads.pop_back();
+    takenIdx = idx;
+    // head of a journal in heap is already located, this is just a status check
+    return journals[idx]->locateFrame();
+}
+
+inline bool JournalReader::getNextFrame(Frame& frame)
+{
+    size_t res_idx = 0;
+    void* res_address = (mergeMode == MERGE_MIN_HEAP) ? locateNextHeap(res_idx) : locateNextLinear(res_idx);
+    if (res_address == nullptr)
+        return false;
+    // only touch the shared_ptr when source journal changes
+    if (curJournal.get() != journals[res_idx].get())
+        curJournal = journals[res_idx];
+    curJournal->passFrame();
+    frame.set_address(res_address);
+    return true;
+}
+
+inline FramePtr JournalReader::getNextFrame()
+{
+    Frame frame(nullptr);
+    if (getNextFrame(frame))
+        return FramePtr(new Frame(frame));
+    else
+        return FramePtr();
 }
 
 YJJ_NAMESPACE_END
@@ -25,18 +25,26 @@
 #include "JournalWriter.h"
 #include "Journal.h"
 #include "PageProvider.h"
+#include "PageUtil.h"
+#include "PageCommStruct.h"
 #include "Timer.h"
 #include "sys_messages.h"
 #include <mutex> // used by JournalSafeWriter
+#include <atomic>
 
 USING_YJJ_NAMESPACE
 
 const string JournalWriter::FILE_PREFIX = "writer";
 
-void JournalWriter::init(const string& dir, const string& jname)
+void JournalWriter::init(const string& dir, const string& jname, int pageSize)
 {
+    if (!PageUtil::IsValidPageSize(pageSize))
+        throw std::runtime_error("invalid page size " + std::to_string(pageSize) + " for journal " + jname);
     addJournal(dir, jname);
     journal = journals[0];
+    journal->setPageSize(pageSize);
+    journal->setIndex(JournalIndex::openForWrite(dir, jname));
+    doorbell = page_provider->getDoorbell();
     seekEnd();
 }
 
@@ -60,6 +68,9 @@ int64_t JournalWriter::write_frame_full(const void* data, FH_TYPE_LENGTH length,
                                       FH_TYPE_LASTFG lastFlag, FH_TYPE_REQ_ID requestId, FH_TYPE_NANOTM extraNano,
                                       FH_TYPE_ERR_ID errorId, const char* errorMsg)
 {
+    // keep frames in order of nano
+    if (batchSize > 0)
+        commit();
     void* buffer = journal->locateFrame();
     Frame frame(buffer);
     frame.setSource(source);
@@ -71,24 +82,86 @@ int64_t JournalWriter::write_frame_full(const void* data, FH_TYPE_LENGTH length,
     int64_t nano = getNanoTime();
     frame.setNano(nano);
     frame.setStatusWritten();
+    journal->indexFrame(nano);
     journal->passFrame();
+    if (doorbell != nullptr)
+        comm_notify_journal(doorbell);
     return nano;
 }
 
-JournalWriterPtr JournalWriter::create(const string& dir, const string& jname, const string& writerName)
+void* JournalWriter::reserve(FH_TYPE_LENGTH length, FH_TYPE_SOURCE source, FH_TYPE_MSG_TP msgType,
+                             FH_TYPE_LASTFG lastFlag, FH_TYPE_REQ_ID requestId, FH_TYPE_NANOTM extraNano)
+{
+    void* buffer = nullptr;
+    if (batchSize > 0)
+    {   // frames handed out may still be filled by caller, neither publish them nor unmap their page here
+        buffer = journal->locateBatchFrame(BASIC_FRAME_HEADER_LENGTH + length);
+        if (buffer == nullptr)
+            return nullptr;
+    }
+    else
+    {   // head of batch, new page is loaded here if necessary
+        buffer = journal->locateFrame();
+        batchHead = buffer;
+        batchHeadPosition = journal->getCurPosition();
+    }
+    Frame frame(buffer);
+    frame.setSource(source);
+    frame.setMsgType(msgType);
+    frame.setLastFlag(lastFlag);
+    frame.setRequestId(requestId);
+    frame.setExtraNano(extraNano);
+    frame.setDataLength(length);
+    journal->passFrame();
+    batchSize++;
+    return frame.getData();
+}
+
+int64_t JournalWriter::commit()
+{
+    if (batchSize == 0)
+        return 0;
+    int64_t nano = getNanoTime();
+    Frame frame(batchHead);
+    for (int i = 0; i < batchSize; i++)
+    {
+        frame.setNano(nano);
+        frame.setDataHashCode();
+        // frames after head are not reachable by readers until head is flipped
+        if (i > 0)
+            frame.setStatusWritten();
+        frame.next();
+    }
+    if (batchSize == 1)
+        Frame(batchHead).setStatusWritten();
+    else
+    {
+        std::atomic_thread_fence(std::memory_order_release);
+        Frame(batchHead).setStatusWrittenInBatch();
+    }
+    // all frames share the nano, index the head of the batch (always in current page)
+    journal->indexFrame(nano, batchHeadPosition);
+    batchHead = nullptr;
+    batchSize = 0;
+    if (doorbell != nullptr)
+        comm_notify_journal(doorbell);
+    return nano;
+}
+
+JournalWriterPtr JournalWriter::create(const string& dir, const string& jname, const string& writerName, int pageSize)
 {
 #ifdef USE_PAGED_SERVICE
     PageProviderPtr provider = PageProviderPtr(new ClientPageProvider(writerName, true));
 #else
     PageProviderPtr provider = PageProviderPtr(new LocalPageProvider(true));
 #endif
-    return JournalWriter::create(dir, jname, provider);
+    return JournalWriter::create(dir, jname, provider, pageSize);
 }
 
-JournalWriterPtr JournalWriter::create(const string& dir, const string& jname, PageProviderPtr provider)
+JournalWriterPtr JournalWriter::create(const string& dir, const string& jname, PageProviderPtr provider, int pageSize)
 {
     JournalWriterPtr jwp = JournalWriterPtr(new JournalWriter(provider));
-    jwp->init(dir, jname);
+    jwp->init(dir, jname, pageSize);
     return jwp;
 }
 
@@ -113,10 +186,10 @@ int64_t JournalSafeWriter::write_frame_full(const void* data, FH_TYPE_LENGTH len
     return this->JournalWriter::write_frame_full(data, length, source, msgType, lastFlag, requestId, extraNano, errorId, errorMsg);
 }
 
-JournalWriterPtr JournalSafeWriter::create(const string& dir, const string& jname, const string& writerName)
+JournalWriterPtr JournalSafeWriter::create(const string& dir, const string& jname, const string& writerName, int pageSize)
 {
     PageProviderPtr provider = PageProviderPtr(new ClientPageProvider(writerName, true));
     JournalWriterPtr jwp = JournalWriterPtr(new JournalSafeWriter(provider));
-    jwp->init(dir, jname);
+    jwp->init(dir, jname, pageSize);
     return jwp;
 }
\ No newline at end of file
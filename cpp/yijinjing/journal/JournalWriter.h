@@ -31,6 +31,7 @@
 YJJ_NAMESPACE_START
 
 FORWARD_DECLARE_PTR(JournalWriter)
+struct PageCommDoorbell;
 /**
  * Journal Writer
  */
@@ -39,12 +40,20 @@ class JournalWriter : public JournalHandler
 protected:
     /** the journal will write in */
     JournalPtr journal;
+    /** first frame reserved and not committed yet, nullptr if no batch */
+    void*   batchHead;
+    /** number of frames reserved in current batch */
+    int     batchSize;
+    /** position of batchHead in current page */
+    int     batchHeadPosition;
+    /** rung after frames are published, wakes parked readers, nullptr without paged */
+    PageCommDoorbell* doorbell;
     /** private constructor */
-    JournalWriter(PageProviderPtr ptr): JournalHandler(ptr) {}
+    JournalWriter(PageProviderPtr ptr): JournalHandler(ptr), batchHead(nullptr), batchSize(0), batchHeadPosition(0), doorbell(nullptr) {}
 
 public:
-    /** init journal */
-    void init(const string& dir, const string& jname);
+    /** init journal, new pages of this journal will be created with pageSize */
+    void init(const string& dir, const string& jname, int pageSize=JOURNAL_PAGE_SIZE);
     /** get current page number */
     short getPageNum() const;
     /* seek to the end of the journal
@@ -83,10 +92,24 @@ public:
     {
         return write_frame_full(data, length, source, msgType, lastFlag, requestId, 0, errorId, errorMsg);
     }
+    /** reserve a frame with data of length in page, return address of data to be filled in place.
+     * frames reserved are invisible to readers until commit, which publishes them at once.
+     * a batch never spans pages: return nullptr if the frame does not fit in the page of the batch,
+     * caller has to commit what is reserved and reserve again (the first frame of a batch always fits).
+     * not protected by JournalSafeWriter's mutex, reserve / commit from one thread only */
+    void*   reserve(FH_TYPE_LENGTH length, FH_TYPE_SOURCE source, FH_TYPE_MSG_TP msgType,
+                    FH_TYPE_LASTFG lastFlag, FH_TYPE_REQ_ID requestId, FH_TYPE_NANOTM extraNano=0);
+    /** publish all reserved frames with one nano time, return the nano (0 if nothing reserved) */
+    int64_t commit();
+    /** number of frames reserved and not committed */
+    int     getReservedNum() const { return batchSize; }
+    /** ring another doorbell, e.g. one shared by processes using local page provider */
+    void    setDoorbell(PageCommDoorbell* bell) { doorbell = bell; }
+
 public:
     // creators
-    static JournalWriterPtr create(const string& dir, const string& jname, const string& writerName);
-    static JournalWriterPtr create(const string& dir, const string& jname, PageProviderPtr ptr);
+    static JournalWriterPtr create(const string& dir, const string& jname, const string& writerName, int pageSize=JOURNAL_PAGE_SIZE);
+    static JournalWriterPtr create(const string& dir, const string& jname, PageProviderPtr ptr, int pageSize=JOURNAL_PAGE_SIZE);
     static JournalWriterPtr create(const string& dir, const string& jname);
 
 public:
@@ -108,7 +131,7 @@ public:
                                   const char* errorMsg);
 
     // create a thread safe writer (with mutex in write_frame)
-    static JournalWriterPtr create(const string& dir, const string& jname, const string& writerName);
+    static JournalWriterPtr create(const string& dir, const string& jname, const string& writerName, int pageSize=JOURNAL_PAGE_SIZE);
 };
 
 YJJ_NAMESPACE_END
@@ -20,6 +20,7 @@
 #include "Page.h"
 #include "PageHeader.h"
 #include "PageUtil.h"
+#include "PageArchive.h"
 #include "Timer.h"
 #include <sstream>
 
@@ -27,21 +28,65 @@ USING_YJJ_NAMESPACE
 
 #define PAGE_INIT_POSITION sizeof(PageHeader)
 
-Page::Page(void *buffer) : frame(ADDRESS_ADD(buffer, PAGE_INIT_POSITION)), buffer(buffer), position(PAGE_INIT_POSITION), frameNum(0), pageNum(-1) {}
+Page::Page(void *buffer) : frame(ADDRESS_ADD(buffer, PAGE_INIT_POSITION)), buffer(buffer), position(PAGE_INIT_POSITION), frameNum(0), pageNum(-1),
+                           pageSize(JOURNAL_PAGE_SIZE), pageHeadroom(PAGE_MIN_HEADROOM) {}
 
-void Page::finishPage()
+int64_t Page::finishPage()
 {
     PageHeader* header = (PageHeader*)buffer;
     header->close_nano = getNanoTime();
     header->frame_num = frameNum;
     header->last_pos = position;
     frame.setStatusPageClosed();
+    return header->close_nano;
 }
 
-PagePtr Page::load(const string &dir, const string &jname, short pageNum, bool isWriting, bool quickMode)
+bool Page::jumpToPosition(int pos)
+{
+    if (pos < (int)PAGE_INIT_POSITION || pos >= pageSize)
+        return false;
+    if (archive.get() != nullptr && !archive->decodeAt(buffer, pos))
+        return false;
+    position = pos;
+    frame.set_address(ADDRESS_ADD(buffer, pos));
+    return true;
+}
+
+bool Page::jumpToIndexEntry(const JournalIndexEntry& entry)
+{
+    if (!jumpToPosition(entry.position))
+        return false;
+    if (entry.kind == JOURNAL_INDEX_PAGE_END)
+        return isAtPageEnd();
+    return getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN && frame.getNano() == entry.nano;
+}
+
+bool Page::decodeMore()
+{
+    return getCurStatus() == JOURNAL_FRAME_STATUS_RAW && archive->decodeAt(buffer, position)
+           && getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN;
+}
+
+void Page::passArchiveToTime(int64_t time)
+{
+    int pos = archive->decodeAtTime(buffer, time, position);
+    if (pos != position)
+    {
+        position = pos;
+        frame.set_address(ADDRESS_ADD(buffer, pos));
+    }
+    do
+    {
+        while (getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN && frame.getNano() < time)
+            passFrame();
+    } while (decodeMore() && frame.getNano() < time);
+}
+
+PagePtr Page::load(const string &dir, const string &jname, short pageNum, bool isWriting, bool quickMode, int pageSize)
 {
     string path = PageUtil::GenPageFullPath(dir, jname, pageNum);
-    void* buffer = PageUtil::LoadPageBuffer(path, JOURNAL_PAGE_SIZE, isWriting, quickMode /*from local then we need to do mlock manually*/);
+    int size = PageUtil::GetPageSize(path, pageSize);
+    void* buffer = PageUtil::LoadPageBuffer(path, size, isWriting, quickMode /*from local then we need to do mlock manually*/);
     if (buffer == nullptr)
         return PagePtr();
 
@@ -59,6 +104,7 @@ PagePtr Page::load(const string &dir, const string &jname, short pageNum, bool i
         header->status = JOURNAL_PAGE_STATUS_INITED;
         // write current frame header version inside.
         header->frame_version = __FRAME_HEADER_VERSION__;
+        header->page_size = size;
     }
     else if (header->frame_version > 0 && header->frame_version!= __FRAME_HEADER_VERSION__)
     {
@@ -73,5 +119,31 @@ PagePtr Page::load(const string &dir, const string &jname, short pageNum, bool i
 
     PagePtr page = PagePtr(new Page(buffer));
     page->pageNum = pageNum;
+    page->pageSize = size;
+    page->pageHeadroom = PageUtil::GetPageHeadroom(size);
+    return page;
+}
+
+PagePtr Page::loadArchive(const string &dir, const string &jname, short pageNum)
+{
+    PageArchiveReaderPtr archive = PageArchiveReader::open(PageUtil::GenArchiveFullPath(dir, jname, pageNum));
+    if (archive.get() == nullptr)
+        return PagePtr();
+    const PageHeader& header = archive->getPageHeader();
+    if (header.frame_version > 0 && header.frame_version != __FRAME_HEADER_VERSION__)
+    {
+        std::stringstream ss;
+        ss << "page version mismatch: (program)" << __FRAME_HEADER_VERSION__ << " (archive)" << header.frame_version;
+        throw std::runtime_error(ss.str().c_str());
+    }
+    void* buffer = archive->createBuffer();
+    if (buffer == nullptr)
+        return PagePtr();
+
+    PagePtr page = PagePtr(new Page(buffer));
+    page->pageNum = pageNum;
+    page->pageSize = archive->getHeader().page_size;
+    page->pageHeadroom = PageUtil::GetPageHeadroom(page->pageSize);
+    page->archive = archive;
     return page;
 }
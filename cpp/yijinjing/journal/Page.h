@@ -27,10 +27,14 @@
 #include "constants.h"
 #include "FrameHeader.h"
 #include "Frame.hpp"
+#include "JournalIndex.h"
+
+#include <limits>
 
 YJJ_NAMESPACE_START
 
 FORWARD_DECLARE_PTR(Page);
+FORWARD_DECLARE_PTR(PageArchiveReader);
 
 /**
  * Page class
@@ -48,6 +52,12 @@ private:
     int frameNum;
     /** number of the page for the journal */
     short pageNum;
+    /** size of the page buffer */
+    int pageSize;
+    /** writable frame has to leave this headroom before page end */
+    int pageHeadroom;
+    /** archive decoded into buffer block by block, empty for page files */
+    PageArchiveReaderPtr archive;
 
     /** private constructor */
     Page(void *buffer);
@@ -58,17 +68,28 @@ private:
     {
         return frame.getStatus();
     }
+    /** decode the archive block at current position, return true if a written frame is there */
+    bool decodeMore();
+    /** passToTime on archived page, skips blocks through the block index */
+    void passArchiveToTime(int64_t time);
 
 public:
     /** get page buffer */
     inline void* getBuffer() { return buffer; }
     /** get current page number */
     inline short getPageNum() const { return pageNum; };
+    /** get size of page buffer */
+    inline int getPageSize() const { return pageSize; };
+    /** get position of current frame */
+    inline int getPosition() const { return position; };
 
-    /** setup the page when finished */
-    void finishPage();
+    /** setup the page when finished, return close nano */
+    int64_t finishPage();
     /** get writable frame address (enough space & clean)*/
     void *locateWritableFrame();
+    /** get address to reserve a frame of frameLength right after frames reserved in the same batch,
+     * unlike locateWritableFrame, headroom may be used, nullptr if the page is really full */
+    void *locateReservableFrame(int frameLength);
     /** get wrote frame address
      * return nullptr if no more frame */
     void *locateReadableFrame();
@@ -80,11 +101,21 @@ public:
     void passWrittenFrame();
     /** pass frame to nano_time */
     void passToTime(int64_t time);
+    /** jump to a frame position taken from journal index (frame number is not tracked afterwards),
+     * return false if position is out of page */
+    bool jumpToPosition(int pos);
+    /** jump to the frame of a journal index entry,
+     * return false if the entry does not match the frame found there (page rewritten or index ahead of page) */
+    bool jumpToIndexEntry(const JournalIndexEntry& entry);
 
 public:
     /** load page, should be called by PageProvider
-     * will not lock memory if in quickMode (locked by page engine service)*/
-    static  PagePtr load(const string& dir, const string& jname, short pageNum, bool isWriting, bool quickMode);
+     * will not lock memory if in quickMode (locked by page engine service)
+     * pageSize only takes effect when creating a new page, existing page uses size in its header */
+    static  PagePtr load(const string& dir, const string& jname, short pageNum, bool isWriting, bool quickMode, int pageSize);
+    /** load archived page for reading, buffer is released by PageUtil::ReleasePageBuffer as other pages
+     * return empty if the page is not archived */
+    static  PagePtr loadArchive(const string& dir, const string& jname, short pageNum);
 };
 
 
@@ -101,12 +132,16 @@ inline void Page::passFrame()
 
 inline void Page::passWrittenFrame()
 {
+    if (archive.get() != nullptr)
+        return passArchiveToTime(std::numeric_limits<int64_t>::max());
     while (getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN)
         passFrame();
 }
 
 inline void Page::passToTime(int64_t time)
 {
+    if (archive.get() != nullptr)
+        return passArchiveToTime(time);
     while (getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN && frame.getNano() < time)
         passFrame();
 }
@@ -115,13 +150,21 @@ inline void* Page::locateWritableFrame()
 {
     passWrittenFrame();
     return (getCurStatus() == JOURNAL_FRAME_STATUS_RAW
-            && (position + PAGE_MIN_HEADROOM < JOURNAL_PAGE_SIZE))
+            && (position + pageHeadroom < pageSize))
+           ? frame.get_address(): nullptr;
+}
+
+inline void* Page::locateReservableFrame(int frameLength)
+{
+    // leave room for the page end header
+    return (getCurStatus() == JOURNAL_FRAME_STATUS_RAW
+            && (position + frameLength + BASIC_FRAME_HEADER_LENGTH <= pageSize))
            ? frame.get_address(): nullptr;
 }
 
 inline void* Page::locateReadableFrame()
 {
-    return (getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN)
+    return (getCurStatus() == JOURNAL_FRAME_STATUS_WRITTEN || (archive.get() != nullptr && decodeMore()))
            ? frame.get_address(): nullptr;
 }
 
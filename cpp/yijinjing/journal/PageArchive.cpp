@@ -0,0 +1,282 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Compressed archive of closed pages.
+ * blocks are zlib streams at best speed, frames of a page are highly repetitive
+ * and most of a page file is never written at all.
+ */
+
+#include "PageArchive.h"
+#include "PageUtil.h"
+#include "FrameHeader.h"
+
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#include <sys/fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WINDOWS
+
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+
+USING_YJJ_NAMESPACE
+
+#define PAGE_ARCHIVE_INIT_POSITION sizeof(PageHeader)
+#define PAGE_ARCHIVE_DATA_POSITION(blockNum) (sizeof(PageArchiveHeader) + sizeof(PageHeader) + (blockNum) * sizeof(PageArchiveBlock))
+
+bool PageArchive::archivePage(const string& dir, const string& jname, short pageNum, PageArchiveStat& stat)
+{
+    return archivePage(PageUtil::GenPageFullPath(dir, jname, pageNum), PageUtil::GenArchiveFullPath(dir, jname, pageNum), stat);
+}
+
+/** cut frames in [PAGE_ARCHIVE_INIT_POSITION, last_pos] into blocks, false if frames are broken */
+static bool splitBlocks(const char* buffer, const PageHeader* header, vector<PageArchiveBlock>& blocks, int& frameNum)
+{
+    int pos = PAGE_ARCHIVE_INIT_POSITION;
+    PageArchiveBlock block = {};
+    block.raw_offset = pos;
+    block.start_nano = -1;
+    frameNum = 0;
+    while (pos < header->last_pos)
+    {
+        const FrameHeader* frame = (const FrameHeader*)(buffer + pos);
+        if (frame->status != JOURNAL_FRAME_STATUS_WRITTEN || frame->length < BASIC_FRAME_HEADER_LENGTH
+            || pos + frame->length > header->last_pos)
+            return false;
+        if (block.start_nano < 0)
+            block.start_nano = frame->nano;
+        else if (pos - block.raw_offset >= PAGE_ARCHIVE_BLOCK_SIZE || frame->nano - block.start_nano >= PAGE_ARCHIVE_BLOCK_NANO)
+        {
+            block.raw_length = pos - block.raw_offset;
+            blocks.push_back(block);
+            block.raw_offset = pos;
+            block.start_nano = frame->nano;
+        }
+        pos += frame->length;
+        frameNum++;
+    }
+    // last block carries the page end header
+    if (block.start_nano < 0)
+        block.start_nano = header->close_nano;
+    block.raw_length = header->last_pos + BASIC_FRAME_HEADER_LENGTH - block.raw_offset;
+    blocks.push_back(block);
+    return true;
+}
+
+bool PageArchive::archivePage(const string& pagePath, const string& archivePath, PageArchiveStat& stat)
+{
+#ifdef _WINDOWS
+    return false;
+#else
+    int fd = open(pagePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)(PAGE_ARCHIVE_INIT_POSITION + BASIC_FRAME_HEADER_LENGTH))
+    {
+        close(fd);
+        return false;
+    }
+    int size = st.st_size;
+    char* buffer = (char*)mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (buffer == MAP_FAILED)
+        return false;
+    madvise(buffer, size, MADV_SEQUENTIAL);
+
+    const PageHeader* header = (const PageHeader*)buffer;
+    vector<PageArchiveBlock> blocks;
+    int frameNum = 0;
+    // only pages closed by their writer, whose page end is where the header says
+    bool closed = header->status == JOURNAL_PAGE_STATUS_INITED && header->close_nano > 0
+                  && header->last_pos >= (int)PAGE_ARCHIVE_INIT_POSITION && header->last_pos + BASIC_FRAME_HEADER_LENGTH <= size
+                  && ((const FrameHeader*)(buffer + header->last_pos))->status == JOURNAL_FRAME_STATUS_PAGE_END;
+    if (!closed || !splitBlocks(buffer, header, blocks, frameNum))
+    {
+        munmap(buffer, size);
+        return false;
+    }
+
+    PageArchiveHeader archiveHeader = {};
+    archiveHeader.magic = PAGE_ARCHIVE_MAGIC;
+    archiveHeader.version = PAGE_ARCHIVE_VERSION;
+    archiveHeader.codec = PAGE_ARCHIVE_CODEC_ZLIB;
+    archiveHeader.page_size = size;
+    archiveHeader.raw_size = header->last_pos + BASIC_FRAME_HEADER_LENGTH;
+    archiveHeader.block_num = blocks.size();
+
+    string tmpPath = archivePath + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr)
+    {
+        perror("cannot create archive in PageArchive::archivePage");
+        munmap(buffer, size);
+        return false;
+    }
+    bool ok = fseek(file, PAGE_ARCHIVE_DATA_POSITION(blocks.size()), SEEK_SET) == 0;
+    int64_t offset = PAGE_ARCHIVE_DATA_POSITION(blocks.size());
+    vector<Bytef> compressed;
+    for (size_t i = 0; ok && i < blocks.size(); i++)
+    {
+        PageArchiveBlock& block = blocks[i];
+        uLongf length = compressBound(block.raw_length);
+        if (compressed.size() < length)
+            compressed.resize(length);
+        ok = compress2(compressed.data(), &length, (const Bytef*)(buffer + block.raw_offset), block.raw_length, Z_BEST_SPEED) == Z_OK
+             && fwrite(compressed.data(), 1, length, file) == length;
+        block.file_offset = offset;
+        block.compressed_length = length;
+        offset += length;
+    }
+    ok = ok && fseek(file, 0, SEEK_SET) == 0
+         && fwrite(&archiveHeader, sizeof(archiveHeader), 1, file) == 1
+         && fwrite(header, sizeof(PageHeader), 1, file) == 1
+         && fwrite(blocks.data(), sizeof(PageArchiveBlock), blocks.size(), file) == blocks.size()
+         && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    munmap(buffer, size);
+    // the archive replaces the page only when it is complete on disk
+    if (!ok || rename(tmpPath.c_str(), archivePath.c_str()) != 0)
+    {
+        perror("cannot write archive in PageArchive::archivePage");
+        remove(tmpPath.c_str());
+        return false;
+    }
+    if (remove(pagePath.c_str()) != 0)
+        perror("cannot remove archived page in PageArchive::archivePage");
+
+    stat.page_disk_size = (int64_t)st.st_blocks * 512;
+    stat.archive_size = offset;
+    stat.raw_size = archiveHeader.raw_size;
+    stat.frame_num = frameNum;
+    stat.block_num = blocks.size();
+    return true;
+#endif // _WINDOWS
+}
+
+PageArchiveReader::~PageArchiveReader()
+{
+    if (file != nullptr)
+        fclose(file);
+}
+
+PageArchiveReaderPtr PageArchiveReader::open(const string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return PageArchiveReaderPtr();
+    PageArchiveReaderPtr reader = PageArchiveReaderPtr(new PageArchiveReader());
+    reader->file = file;
+    PageArchiveHeader& header = reader->header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != PAGE_ARCHIVE_MAGIC
+        || header.version != PAGE_ARCHIVE_VERSION || header.codec != PAGE_ARCHIVE_CODEC_ZLIB
+        || header.block_num <= 0 || header.raw_size > header.page_size
+        || fread(&reader->pageHeader, sizeof(PageHeader), 1, file) != 1)
+        return PageArchiveReaderPtr();
+    reader->blocks.resize(header.block_num);
+    if (fread(reader->blocks.data(), sizeof(PageArchiveBlock), header.block_num, file) != (size_t)header.block_num)
+        return PageArchiveReaderPtr();
+    for (auto const& block: reader->blocks)
+    {
+        if (block.raw_offset < (int)PAGE_ARCHIVE_INIT_POSITION || block.raw_length <= 0
+            || block.raw_offset + block.raw_length > header.raw_size)
+            return PageArchiveReaderPtr();
+    }
+    reader->decoded.assign(header.block_num, false);
+    return reader;
+}
+
+void* PageArchiveReader::createBuffer() const
+{
+#ifdef _WINDOWS
+    return nullptr;
+#else
+    // untouched memory reads as zero (raw frames) and costs nothing until a block is decoded there
+    void* buffer = mmap(0, header.page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (buffer == MAP_FAILED)
+    {
+        perror("Error mapping archive buffer");
+        return nullptr;
+    }
+    memcpy(buffer, &pageHeader, sizeof(PageHeader));
+    return buffer;
+#endif // _WINDOWS
+}
+
+int PageArchiveReader::findBlock(int pos) const
+{
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), pos,
+                               [](int p, const PageArchiveBlock& block) { return p < block.raw_offset; });
+    if (it == blocks.begin())
+        return -1;
+    --it;
+    return (pos < it->raw_offset + it->raw_length) ? (it - blocks.begin()) : -1;
+}
+
+bool PageArchiveReader::decodeBlock(void* buffer, int idx)
+{
+    if (decoded[idx])
+        return true;
+    const PageArchiveBlock& block = blocks[idx];
+    if (compressed.size() < (size_t)block.compressed_length)
+        compressed.resize(block.compressed_length);
+    uLongf length = block.raw_length;
+    if (fseek(file, block.file_offset, SEEK_SET) != 0
+        || fread(compressed.data(), 1, block.compressed_length, file) != (size_t)block.compressed_length
+        || uncompress((Bytef*)ADDRESS_ADD(buffer, block.raw_offset), &length, (const Bytef*)compressed.data(), block.compressed_length) != Z_OK
+        || length != (uLongf)block.raw_length)
+    {
+        perror("cannot decode archive block in PageArchiveReader::decodeBlock");
+        return false;
+    }
+    decoded[idx] = true;
+#ifndef _WINDOWS
+    // give back memory of blocks far behind, only os pages not shared with neighbours
+    int old = idx - PAGE_ARCHIVE_RESIDENT_BLOCKS - 1;
+    if (old >= 0 && decoded[old])
+    {
+        const long osPage = 4096;
+        long begin = (blocks[old].raw_offset + osPage - 1) / osPage * osPage;
+        long end = (blocks[old].raw_offset + blocks[old].raw_length) / osPage * osPage;
+        if (end > begin)
+            madvise(ADDRESS_ADD(buffer, begin), end - begin, MADV_DONTNEED);
+        decoded[old] = false;
+    }
+#endif // _WINDOWS
+    return true;
+}
+
+bool PageArchiveReader::decodeAt(void* buffer, int pos)
+{
+    int idx = findBlock(pos);
+    return idx >= 0 && decodeBlock(buffer, idx);
+}
+
+int PageArchiveReader::decodeAtTime(void* buffer, int64_t time, int pos)
+{
+    int from = findBlock(pos);
+    if (from < 0)
+        return pos;
+    // first block starting at or after time, frames before it are all earlier
+    auto it = std::lower_bound(blocks.begin() + from, blocks.end(), time,
+                               [](const PageArchiveBlock& block, int64_t t) { return block.start_nano < t; });
+    int idx = std::max(from, (int)(it - blocks.begin()) - 1);
+    if (!decodeBlock(buffer, idx))
+        return pos;
+    return (idx == from) ? pos : blocks[idx].raw_offset;
+}
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Compressed archive of closed pages.
+ * a closed page is cut into blocks of whole frames (by size and time span),
+ * each block compressed on its own, so a reader decodes block by block
+ * and a seek only decodes the block it lands in.
+ *
+ * archive file (yjj.[jname].[page_num].journal.arc):
+ *   PageArchiveHeader | PageHeader | PageArchiveBlock * block_num | compressed blocks
+ * decoded blocks lay frames at the same positions as the page,
+ * so time index positions stay valid.
+ */
+
+#ifndef YIJINJING_PAGEARCHIVE_H
+#define YIJINJING_PAGEARCHIVE_H
+
+#include "YJJ_DECLARE.h"
+#include "constants.h"
+#include "PageHeader.h"
+
+#include <cstdio>
+
+YJJ_NAMESPACE_START
+
+#define PAGE_ARCHIVE_MAGIC          0x415a4a59 /**< "YJZA" */
+#define PAGE_ARCHIVE_VERSION        1
+#define PAGE_ARCHIVE_CODEC_ZLIB     1
+#define PAGE_ARCHIVE_BLOCK_SIZE     (256 * KB) /**< raw bytes of a block, it closes at the first frame boundary beyond */
+#define PAGE_ARCHIVE_BLOCK_NANO     (60 * 1000000000L) /**< time span of frames in a block */
+#define PAGE_ARCHIVE_RESIDENT_BLOCKS 2         /**< decoded blocks kept in memory behind the one in reading */
+
+struct PageArchiveHeader
+{
+    /** PAGE_ARCHIVE_MAGIC */
+    int     magic;
+    /** PAGE_ARCHIVE_VERSION */
+    short   version;
+    /** codec of blocks */
+    byte    codec;
+    /** size of the page, decoded page takes the same address space */
+    int     page_size;
+    /** bytes from page start to the end of page-end frame header */
+    int     raw_size;
+    /** number of blocks */
+    int     block_num;
+#ifndef _WIN32
+} __attribute__((packed));
+#else
+};
+#pragma pack(pop)
+#endif
+
+struct PageArchiveBlock
+{
+    /** nano of the first frame in this block */
+    int64_t start_nano;
+    /** position of the block in page */
+    int     raw_offset;
+    /** decoded length */
+    int     raw_length;
+    /** position of compressed data in archive file */
+    int64_t file_offset;
+    /** compressed length */
+    int     compressed_length;
+#ifndef _WIN32
+} __attribute__((packed));
+#else
+};
+#pragma pack(pop)
+#endif
+
+/** result of archiving one page */
+struct PageArchiveStat
+{
+    /** bytes of page file on disk (allocated blocks, pages are sparse) */
+    int64_t page_disk_size;
+    /** bytes of archive file */
+    int64_t archive_size;
+    /** bytes of frames in page */
+    int64_t raw_size;
+    int     frame_num;
+    int     block_num;
+};
+
+FORWARD_DECLARE_PTR(PageArchiveReader);
+
+/**
+ * archive writer, stateless
+ */
+class PageArchive
+{
+public:
+    /** archive a closed page into its archive file then remove the page file,
+     * return false (page untouched) if the page is not closed or cannot be archived */
+    static bool archivePage(const string& dir, const string& jname, short pageNum, PageArchiveStat& stat);
+    /** same as archivePage, by path of the page file */
+    static bool archivePage(const string& pagePath, const string& archivePath, PageArchiveStat& stat);
+};
+
+/**
+ * reads one archive, decodes blocks into the buffer of the page
+ */
+class PageArchiveReader
+{
+private:
+    FILE*   file;
+    PageArchiveHeader header;
+    PageHeader pageHeader;
+    vector<PageArchiveBlock> blocks;
+    /** whether each block is in the buffer */
+    vector<bool> decoded;
+    /** compressed data of the block in decoding */
+    vector<char> compressed;
+
+    PageArchiveReader(): file(nullptr) {}
+    /** index of the block containing pos, -1 if out of page */
+    int     findBlock(int pos) const;
+    /** decode block idx into buffer, drop blocks far behind */
+    bool    decodeBlock(void* buffer, int idx);
+public:
+    ~PageArchiveReader();
+    /** open archive file, nullptr if not exists or invalid */
+    static PageArchiveReaderPtr open(const string& path);
+
+    /** anonymous buffer of page size with page header filled in, released by PageUtil::ReleasePageBuffer */
+    void*   createBuffer() const;
+    /** make sure the block containing pos is in buffer, return false if out of page or corrupted */
+    bool    decodeAt(void* buffer, int pos);
+    /** decode the last block starting before time but not before pos, return where to walk from */
+    int     decodeAtTime(void* buffer, int64_t time, int pos);
+
+    const PageArchiveHeader& getHeader() const { return header; }
+    const PageHeader& getPageHeader() const { return pageHeader; }
+    int     getBlockNum() const { return blocks.size(); }
+};
+
+YJJ_NAMESPACE_END
+
+#endif //YIJINJING_PAGEARCHIVE_H
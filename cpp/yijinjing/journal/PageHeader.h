@@ -54,8 +54,10 @@ struct PageHeader
     int     last_pos;
     /** version of frame header (using reserve)*/
     short   frame_version;
+    /** size of this page file in bytes (using reserve, 0 for legacy pages of JOURNAL_PAGE_SIZE) */
+    int     page_size;
     /** reserve space */
-    short   reserve_short[3];
+    short   reserve_short[1];
     int64_t    reserve_long[PAGE_HEADER_RESERVE - 1];
 
 #ifndef _WIN32
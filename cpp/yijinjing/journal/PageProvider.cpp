@@ -30,28 +30,92 @@
 
 #include <boost/asio.hpp>
 #include <boost/array.hpp>
+#include <mutex>
 
 USING_YJJ_NAMESPACE
 
 typedef boost::array<char, SOCKET_MESSAGE_MAX_LENGTH> SocketMArray;
 
-/** get socket response via paged_socket */
-void getSocketRsp(SocketMArray &input, SocketMArray &output)
+PagedWaitMode ClientPageProvider::wait_mode = PAGED_WAIT_SPIN_PARK;
+
+#ifdef _WINDOWS
+typedef boost::asio::ip::tcp::socket PagedSocket;
+#else
+typedef boost::asio::local::stream_protocol::socket PagedSocket;
+#endif // _WINDOWS
+
+inline int currentPid()
 {
-    using namespace boost::asio;
-    io_service io_service;
+#ifdef _WINDOWS
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
 
+/**
+ * connection to paged_socket shared by all clients in process,
+ * connected on first request and kept open, requests are sent one at a time.
+ * a broken connection (paged restarted) or one inherited through fork is replaced once per request.
+ */
+class PagedSocketConnection
+{
+private:
+    std::mutex mtx;
+    boost::asio::io_service io;
+    boost::shared_ptr<PagedSocket> socket;
+    int pid;
+
+    void connect()
+    {
+        using namespace boost::asio;
+        socket.reset(new PagedSocket(io));
 #ifdef _WINDOWS
-    ip::tcp::socket socket(io_service);
-    socket.connect(ip::tcp::endpoint(ip::address_v4::from_string("127.0.0.1"),PAGED_SOCKET_PORT));
+        socket->connect(ip::tcp::endpoint(ip::address_v4::from_string("127.0.0.1"),PAGED_SOCKET_PORT));
 #else
-    local::stream_protocol::socket socket(io_service);
-    socket.connect(local::stream_protocol::endpoint(PAGED_SOCKET_FILE));
+        socket->connect(local::stream_protocol::endpoint(PAGED_SOCKET_FILE));
 #endif // _WINDOWS
+        pid = currentPid();
+    }
+public:
+    PagedSocketConnection(): pid(-1) {}
+
+    static PagedSocketConnection& get()
+    {
+        static PagedSocketConnection* conn = new PagedSocketConnection(); // never destroyed, clients exit during static destruction
+        return *conn;
+    }
+
+    /** output is zeroed if paged does not answer */
+    void request(SocketMArray &input, SocketMArray &output)
+    {
+        using namespace boost::asio;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (socket.get() != nullptr && pid != currentPid())
+        {
+            io.notify_fork(io_service::fork_child);
+            socket.reset(); // closes the copy of this process only, parent keeps its connection
+        }
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            if (socket.get() == nullptr)
+                connect();
+            boost::system::error_code error;
+            write(*socket, buffer(input), error);
+            if (!error)
+                read(*socket, buffer(output), error);
+            if (!error)
+                return;
+            socket.reset();
+        }
+        memset(&output[0], 0, SOCKET_MESSAGE_MAX_LENGTH);
+    }
+};
 
-    boost::system::error_code error;
-    write(socket, buffer(input), error);
-    socket.read_some(buffer(output), error);
+/** get socket response via paged_socket */
+void getSocketRsp(SocketMArray &input, SocketMArray &output)
+{
+    PagedSocketConnection::get().request(input, output);
 }
 
 /** send req via socket and get response in data */
@@ -116,6 +180,35 @@ int ClientPageProvider::register_journal(const string& dir, const string& jname)
     else
         throw std::runtime_error("cannot register journal: " + client_name);
 
+    hold_journal(comm_idx, dir, jname);
+    return comm_idx;
+}
+
+vector<int> ClientPageProvider::register_journals(const vector<string>& dirs, const vector<string>& jnames)
+{
+    vector<int> comm_idx_vec;
+    for (size_t start = 0; start < jnames.size(); start += SOCKET_JOURNAL_BATCH_MAX_NUM)
+    {
+        PagedSocketRequest req = {};
+        req.type = PAGED_SOCKET_JOURNAL_REGISTER_BATCH;
+        req.journal_num = std::min(jnames.size() - start, (size_t)SOCKET_JOURNAL_BATCH_MAX_NUM);
+        SocketMArray rspArray;
+        getSocketRspOnReq(req, rspArray, client_name);
+        PagedSocketRspJournalBatch* rsp = (PagedSocketRspJournalBatch*)(&rspArray[0]);
+        if (rsp->type != req.type || !rsp->success)
+            throw std::runtime_error("cannot register journal: " + client_name);
+
+        for (int i = 0; i < rsp->journal_num; i++)
+        {
+            hold_journal(rsp->comm_idx[i], dirs[start + i], jnames[start + i]);
+            comm_idx_vec.push_back(rsp->comm_idx[i]);
+        }
+    }
+    return comm_idx_vec;
+}
+
+void ClientPageProvider::hold_journal(int comm_idx, const string& dir, const string& jname)
+{
     PageCommMsg* serverMsg = GET_COMM_MSG(comm_buffer, comm_idx);
     if (serverMsg->status == PAGED_COMM_OCCUPIED)
     {
@@ -126,25 +219,34 @@ int ClientPageProvider::register_journal(const string& dir, const string& jname)
     }
     else
         throw std::runtime_error("server buffer is not allocated: " + client_name);
-
-    return comm_idx;
 }
 
-PagePtr ClientPageProvider::getPage(const string &dir, const string &jname, int serviceIdx, short pageNum)
+PagePtr ClientPageProvider::getPage(const string &dir, const string &jname, int serviceIdx, short pageNum, int pageSize)
 {
     PageCommMsg* serverMsg = GET_COMM_MSG(comm_buffer, serviceIdx);
+    PageCommDoorbell* bell = GET_COMM_DOORBELL(comm_buffer);
+    int reply = __atomic_load_n(&bell->reply_seq[serviceIdx], __ATOMIC_ACQUIRE);
     serverMsg->page_num = pageNum;
+    serverMsg->page_size = pageSize;
     serverMsg->status = PAGED_COMM_REQUESTING;
-    while (serverMsg->status == PAGED_COMM_REQUESTING) {}
+    comm_notify_request(bell);
+    comm_wait_reply(serverMsg, bell, serviceIdx, reply, wait_mode);
 
     if (serverMsg->status != PAGED_COMM_ALLOCATED)
     {
         if (serverMsg->status == PAGED_COMM_MORE_THAN_ONE_WRITE)
             throw std::runtime_error("more than one writer is writing " + dir + " " + jname);
+        // closed pages compacted by paged are read from their archive locally
+        else if (serverMsg->status == PAGED_COMM_NON_EXIST && !is_writer && pageNum > 0)
+            return Page::loadArchive(dir, jname, pageNum);
         else
             return PagePtr();
     }
-    return Page::load(dir, jname, pageNum, revise_allowed, true);
+    PagePtr page = Page::load(dir, jname, pageNum, revise_allowed, true, pageSize);
+    // archived right after paged mapped it
+    if (page.get() == nullptr && !is_writer)
+        page = Page::loadArchive(dir, jname, pageNum);
+    return page;
 }
 
 void ClientPageProvider::releasePage(void* buffer, int size, int serviceIdx)
@@ -152,15 +254,31 @@ void ClientPageProvider::releasePage(void* buffer, int size, int serviceIdx)
     PageUtil::ReleasePageBuffer(buffer, size, true);
 }
 
+PageCommDoorbell* ClientPageProvider::getDoorbell() const
+{
+    return comm_buffer == nullptr ? nullptr : GET_COMM_DOORBELL(comm_buffer);
+}
+
+vector<int> PageProvider::register_journals(const vector<string>& dirs, const vector<string>& jnames)
+{
+    vector<int> comm_idx_vec;
+    for (size_t i = 0; i < jnames.size(); i++)
+        comm_idx_vec.push_back(register_journal(dirs[i], jnames[i]));
+    return comm_idx_vec;
+}
+
 LocalPageProvider::LocalPageProvider(bool isWriting, bool reviseAllowed)
 {
     is_writer = isWriting;
     revise_allowed = is_writer || reviseAllowed;
 }
 
-PagePtr LocalPageProvider::getPage(const string &dir, const string &jname, int serviceIdx, short pageNum)
+PagePtr LocalPageProvider::getPage(const string &dir, const string &jname, int serviceIdx, short pageNum, int pageSize)
 {
-    return Page::load(dir, jname, pageNum, is_writer, false);
+    PagePtr page = Page::load(dir, jname, pageNum, is_writer, false, pageSize);
+    if (page.get() == nullptr && !is_writer)
+        page = Page::loadArchive(dir, jname, pageNum);
+    return page;
 }
 
 void LocalPageProvider::releasePage(void* buffer, int size, int serviceIdx)
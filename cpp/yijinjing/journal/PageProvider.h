@@ -24,9 +24,12 @@
 #define YIJINJING_PAGEPROVIDER_H
 
 #include "IPageProvider.h"
+#include "constants.h"
 
 YJJ_NAMESPACE_START
 
+struct PageCommDoorbell;
+
 /**
  * PageProvider,
  * abstract class with virtual interfaces,
@@ -42,10 +45,14 @@ protected:
 public:
     /** register journal when added into JournalHandler */
     virtual int  register_journal(const string& dir, const string& jname) { return -1; };
+    /** register journals added together into JournalHandler, return comm index of each */
+    virtual vector<int> register_journals(const vector<string>& dirs, const vector<string>& jnames);
     /** exit client after JournalHandler is released */
     virtual void exit_client() {};
     /** override IPageProvider */
     virtual bool isWriter() const {return is_writer; };
+    /** doorbell shared with paged and its other clients, nullptr if not connected to paged */
+    virtual PageCommDoorbell* getDoorbell() const { return nullptr; };
 };
 
 DECLARE_PTR(PageProvider);
@@ -60,7 +67,7 @@ public:
     /** constructor */
     LocalPageProvider(bool isWriting, bool reviseAllowed=false);
     /** override IPageProvider */
-    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum);
+    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum, int pageSize);
     /** override IPageProvider */
     virtual void releasePage(void* buffer, int size, int serviceIdx);
 };
@@ -75,20 +82,30 @@ protected:
     string  client_name;
     void*   comm_buffer;
     int     hash_code;
+    /** how getPage waits for paged, shared by all clients in process */
+    static PagedWaitMode wait_mode;
 protected:
     /** register to service as a client */
     void register_client();
+    /** fill in the journal at comm_idx and hand it to service */
+    void hold_journal(int comm_idx, const string& dir, const string& jname);
 public:
     /** default constructor with client name and writing flag */
     ClientPageProvider(const string& clientName, bool isWriting, bool reviseAllowed=false);
     /** override PageProvider */
     virtual int  register_journal(const string& dir, const string& jname);
+    /** override PageProvider, SOCKET_JOURNAL_BATCH_MAX_NUM journals per request */
+    virtual vector<int> register_journals(const vector<string>& dirs, const vector<string>& jnames);
     /** override PageProvider */
     virtual void exit_client();
     /** override IPageProvider */
-    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum);
+    virtual PagePtr getPage(const string &dir, const string &jname, int serviceIdx, short pageNum, int pageSize);
     /** override IPageProvider */
     virtual void releasePage(void* buffer, int size, int serviceIdx);
+    /** override PageProvider */
+    virtual PageCommDoorbell* getDoorbell() const;
+    /** set how getPage waits for paged, PAGED_WAIT_SPIN_PARK by default */
+    static void setWaitMode(PagedWaitMode mode) { wait_mode = mode; }
 };
 
 YJJ_NAMESPACE_END
@@ -22,6 +22,7 @@
 
 #include "PageUtil.h"
 #include "PageHeader.h"
+#include "PageArchive.h"
 
 #ifdef _WINDOWS
 #include <io.h>
@@ -54,6 +55,18 @@ string PageUtil::GenPageFullPath(const string& dir, const string& jname, short p
     return ss.str();
 }
 
+string PageUtil::GenArchiveFullPath(const string& dir, const string& jname, short pageNum)
+{
+    return GenPageFullPath(dir, jname, pageNum) + "." + JOURNAL_ARCHIVE_SUFFIX;
+}
+
+string PageUtil::GenIndexFullPath(const string& dir, const string& jname)
+{
+    std::stringstream ss;
+    ss << dir << "/" << JOURNAL_PREFIX << "." << jname << "." << JOURNAL_INDEX_SUFFIX;
+    return ss.str();
+}
+
 string PageUtil::GetPageFileNamePattern(const string &jname)
 {
     return JOURNAL_PREFIX + "\\." + jname + "\\.[0-9]+\\." + JOURNAL_SUFFIX;
@@ -67,7 +80,7 @@ short PageUtil::ExtractPageNum(const string &filename, const string &jname)
 
 vector<short> PageUtil::GetPageNums(const string& dir, const string& jname)
 {
-    string namePattern = GetPageFileNamePattern(jname);
+    string namePattern = GetPageFileNamePattern(jname) + "(\\." + JOURNAL_ARCHIVE_SUFFIX + ")?";
     boost::filesystem::path p(dir);
     boost::regex pattern(namePattern);
     vector<short> res;
@@ -77,6 +90,8 @@ vector<short> PageUtil::GetPageNums(const string& dir, const string& jname)
             res.push_back(PageUtil::ExtractPageNum(filename, jname));
     }
     std::sort(res.begin(), res.end());
+    // a page and its archive both exist for a moment while archiving
+    res.erase(std::unique(res.begin(), res.end()), res.end());
     return res;
 }
 
@@ -98,7 +113,12 @@ PageHeader PageUtil::GetPageHeader(const string &dir, const string &jname, short
     string path = PageUtil::GenPageFullPath(dir, jname, pageNum);
     FILE* pfile = fopen(path.c_str(), "rb");
     if (pfile == nullptr)
+    {
+        PageArchiveReaderPtr archive = PageArchiveReader::open(GenArchiveFullPath(dir, jname, pageNum));
+        if (archive.get() != nullptr)
+            return archive->getPageHeader();
         perror("cannot open file in PageUtil::GetPageNumWithTime");
+    }
     size_t length = fread(&header, 1, sizeof(PageHeader), pfile);
     if (length != sizeof(PageHeader))
         perror("cannot get page header in PageUtil::GetPageNumWithTime");
@@ -106,6 +126,31 @@ PageHeader PageUtil::GetPageHeader(const string &dir, const string &jname, short
     return header;
 }
 
+int PageUtil::GetPageSize(const string& path, int defaultSize)
+{
+    FILE* pfile = fopen(path.c_str(), "rb");
+    if (pfile == nullptr)
+        return defaultSize;
+    PageHeader header = {};
+    size_t length = fread(&header, 1, sizeof(PageHeader), pfile);
+    fclose(pfile);
+    if (length != sizeof(PageHeader) || header.status == JOURNAL_PAGE_STATUS_RAW)
+        return defaultSize;
+    // pages created before page_size was introduced
+    return (header.page_size > 0) ? header.page_size : JOURNAL_PAGE_SIZE;
+}
+
+int PageUtil::GetPageHeadroom(int pageSize)
+{
+    int headroom = pageSize / PAGE_HEADROOM_RATIO;
+    return (headroom < PAGE_MIN_HEADROOM) ? headroom : PAGE_MIN_HEADROOM;
+}
+
+bool PageUtil::IsValidPageSize(int pageSize)
+{
+    return pageSize >= MIN_JOURNAL_PAGE_SIZE && pageSize <= MAX_JOURNAL_PAGE_SIZE && pageSize % MIN_JOURNAL_PAGE_SIZE == 0;
+}
+
 /*
  * memory manipulation (no service)
  */
@@ -214,6 +259,22 @@ void* PageUtil::LoadPageBuffer(const string& path, int size, bool isWriting, boo
 #endif // _WINDOWS
 }
 
+void PageUtil::PrefaultPageBuffer(void* buffer, int size, bool hugePage)
+{
+#ifndef _WINDOWS
+#ifdef MADV_HUGEPAGE
+    if (hugePage && madvise(buffer, size, MADV_HUGEPAGE) != 0)
+        perror("madvise(MADV_HUGEPAGE) ignored");
+#endif
+    madvise(buffer, size, MADV_WILLNEED);
+#endif // _WINDOWS
+    // write fault each page, so the writer never pays for block allocation
+    const long pageSize = 4096;
+    volatile char* p = (volatile char*)buffer;
+    for (long offset = 0; offset < size; offset += pageSize)
+        p[offset] = 0;
+}
+
 void PageUtil::ReleasePageBuffer(void *buffer, int size, bool quickMode)
 {
 #ifdef _WINDOWS
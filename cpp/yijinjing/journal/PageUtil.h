@@ -43,6 +43,10 @@ public:
      *  if quickMode==True, no locking; if quickMode==False, mlock the memory for performance
      * the address of memory is returned */
     static void*  LoadPageBuffer(const string& path, int size, bool isWriting, bool quickMode);
+    /** direct memory manipulation without service
+     * fault in every page of a writable buffer ahead of use (MAP_POPULATE is not enough for shared mappings),
+     *  if hugePage==True, transparent hugepages are advised (only effective on tmpfs / shmem) */
+    static void   PrefaultPageBuffer(void* buffer, int size, bool hugePage);
     /** direct memory manipulation without service
      * release page buffer, buffer and size needs to be specified.
      *  if quickMode==True, no unlocking; if quickMode==False, munlock the memory */
@@ -53,6 +57,10 @@ public:
     static string GenPageFileName(const string& jname, short pageNum);
     /** generate proper yjj page full path by necessary information */
     static string GenPageFullPath(const string& dir, const string& jname, short pageNum);
+    /** generate path of the compressed archive of a closed page */
+    static string GenArchiveFullPath(const string& dir, const string& jname, short pageNum);
+    /** generate path of the time index of a journal */
+    static string GenIndexFullPath(const string& dir, const string& jname);
     /** get the proper yjj file name pattern */
     static string GetPageFileNamePattern(const string& jname);
 
@@ -61,13 +69,22 @@ public:
     static short  ExtractPageNum(const string& filename, const string& jname);
     /** select page number from existing pages in directory which contains the nano time */
     static short  GetPageNumWithTime(const string& dir, const string& jname, int64_t time);
-    /** get existing page numbers in directory with jname */
+    /** get existing page numbers in directory with jname, archived pages included */
     static vector<short> GetPageNums(const string& dir, const string& jname);
 
     // header
-    /** get header from necessary information */
+    /** get header from necessary information, from archive if the page is archived */
     static PageHeader GetPageHeader(const string& dir, const string& jname, short pageNum);
 
+    // page size
+    /** get page size from header of page file,
+     * defaultSize is returned if file does not exist or page is not initialized yet */
+    static int    GetPageSize(const string& path, int defaultSize);
+    /** headroom to keep for a page with pageSize */
+    static int    GetPageHeadroom(int pageSize);
+    /** return true if pageSize is in range and aligned */
+    static bool   IsValidPageSize(int pageSize);
+
     // file
     static bool FileExists(const string& filename);
 };
@@ -26,7 +26,12 @@
 #include "Journal.h"
 #include "PageSocketStruct.h"
 #include <chrono>
+#include <thread>
+#include <cmath>
 #include <boost/asio.hpp>
+#if defined(NANO_TIMER_HAS_TSC) && !defined(_WINDOWS)
+#include <cpuid.h>
+#endif
 #include <boost/array.hpp>
 
 USING_YJJ_NAMESPACE
@@ -35,6 +40,9 @@ using json = nlohmann::json;
 
 boost::shared_ptr<NanoTimer> NanoTimer::m_ptr = boost::shared_ptr<NanoTimer>(nullptr);
 
+/** zero initialized before any dynamic initialization, getNanoTime falls back to the singleton until set */
+NanoClock kungfu::yijinjing::nanoClock;
+
 NanoTimer* NanoTimer::getInstance()
 {
     if (m_ptr.get() == nullptr)
@@ -80,7 +88,7 @@ inline int64_t get_local_diff()
     return (unix_second_num - tick_second_num) * NANOSECONDS_PER_SECOND;
 }
 
-NanoTimer::NanoTimer()
+NanoTimer::NanoTimer(): anchorTsc(0), anchorNano(0), tscStats(), calibrateStop(false)
 {
     try
     {
@@ -90,12 +98,149 @@ NanoTimer::NanoTimer()
     {
         secDiff = get_local_diff();
     }
+    nanoClock.secDiff.store(secDiff, std::memory_order_relaxed);
+    const char* clock = getenv(NANO_TIMER_CLOCK_ENV);
+    if (clock == nullptr || string(clock) != "tsc" || !initTsc())
+    {
+        nanoClock.mode.store(NANO_CLOCK_STEADY, std::memory_order_release);
+    }
+}
+
+NanoTimer::~NanoTimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(calibrateMutex);
+        calibrateStop = true;
+    }
+    calibrateCond.notify_all();
+    if (calibrateThread.joinable())
+    {
+        calibrateThread.join();
+    }
 }
 
 int64_t NanoTimer::getNano() const
 {
-    auto _nano = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            get_time_now().time_since_epoch()
-    ).count();
-    return _nano + secDiff;
+    return isTsc() ? getTscNano(readTsc()) : getReferenceNano();
+}
+
+NanoTimerTscStats NanoTimer::getTscStats() const
+{
+    std::lock_guard<std::mutex> lock(tscStatsMutex);
+    return tscStats;
+}
+
+inline bool has_invariant_tsc()
+{
+#ifdef NANO_TIMER_HAS_TSC
+#ifdef _WINDOWS
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((unsigned)regs[0] < 0x80000007)
+        return false;
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+        return false;
+    return (edx & (1 << 8)) != 0;
+#endif // _WINDOWS
+#else
+    return false;
+#endif
+}
+
+/** tsc and reference nano read as close together as possible */
+inline void sample_tsc(const NanoTimer* timer, int64_t& tsc, int64_t& nano)
+{
+    int64_t best = INT64_MAX;
+    for (int i = 0; i < 5; i++)
+    {
+        int64_t before = readTsc();
+        int64_t ref = timer->getReferenceNano();
+        int64_t after = readTsc();
+        if (after - before < best)
+        {
+            best = after - before;
+            tsc = before + (after - before) / 2;
+            nano = ref;
+        }
+    }
+}
+
+inline void publish_tsc(int64_t baseTsc, int64_t baseNano, int64_t scale)
+{
+    uint32_t seq = nanoClock.seq.load(std::memory_order_relaxed);
+    nanoClock.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    nanoClock.baseTsc.store(baseTsc, std::memory_order_relaxed);
+    nanoClock.baseNano.store(baseNano, std::memory_order_relaxed);
+    nanoClock.scale.store(scale, std::memory_order_relaxed);
+    nanoClock.seq.store(seq + 2, std::memory_order_release);
+}
+
+inline int64_t to_scale(double nanoPerTsc)
+{
+    return (int64_t)std::llround(nanoPerTsc * (double)(1LL << NANO_TIMER_TSC_SCALE_SHIFT));
+}
+
+bool NanoTimer::initTsc()
+{
+    if (!has_invariant_tsc())
+    {
+        return false;
+    }
+    // rough rate over 10ms, refined by every calibration after
+    int64_t tsc, nano, tsc2, nano2;
+    sample_tsc(this, tsc, nano);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sample_tsc(this, tsc2, nano2);
+    if (tsc2 <= tsc || nano2 <= nano)
+    {
+        return false;
+    }
+    anchorTsc = tsc;
+    anchorNano = nano;
+    tscStats.tscPerSecond = (double)(tsc2 - tsc) * NANOSECONDS_PER_SECOND / (nano2 - nano);
+    publish_tsc(tsc2, nano2, to_scale((double)(nano2 - nano) / (tsc2 - tsc)));
+    nanoClock.mode.store(NANO_CLOCK_TSC, std::memory_order_release);
+    calibrateThread = std::thread([this]()
+    {
+        std::unique_lock<std::mutex> lock(calibrateMutex);
+        while (!calibrateCond.wait_for(lock, std::chrono::milliseconds(NANO_TIMER_TSC_CALIBRATE_MS), [this]() { return calibrateStop; }))
+        {
+            calibrateTsc();
+        }
+    });
+    return true;
+}
+
+void NanoTimer::calibrateTsc()
+{
+    int64_t tsc, nano;
+    sample_tsc(this, tsc, nano);
+    double nanoPerTsc = (double)(nano - anchorNano) / (tsc - anchorTsc);
+    int64_t current = getTscNano(tsc);
+    int64_t error = nano - current;
+    if (std::llabs(error) > NANO_TIMER_TSC_MAX_SLEW_NS)
+    {
+        // reference clock jumped, follow it
+        publish_tsc(tsc, nano, to_scale(nanoPerTsc));
+        anchorTsc = tsc;
+        anchorNano = nano;
+        std::lock_guard<std::mutex> lock(tscStatsMutex);
+        tscStats.steps++;
+    }
+    else
+    {
+        // stay continuous and slew the error away over the next interval
+        double interval = (double)NANO_TIMER_TSC_CALIBRATE_MS * NANOSECONDS_PER_MILLISECOND;
+        publish_tsc(tsc, current, to_scale(nanoPerTsc * (1.0 + error / interval)));
+    }
+    std::lock_guard<std::mutex> lock(tscStatsMutex);
+    tscStats.calibrations++;
+    tscStats.lastErrorNano = error;
+    tscStats.maxAbsErrorNano = std::max(tscStats.maxAbsErrorNano, (int64_t)std::llabs(error));
+    tscStats.tscPerSecond = 1.0 * NANOSECONDS_PER_SECOND / nanoPerTsc;
 }
@@ -385,6 +385,20 @@ inline char * strptime(const char *buf, const char *fmt, struct tm *tm)
 #endif // _WINDOWS
 
 #include "YJJ_DECLARE.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define NANO_TIMER_HAS_TSC
+#ifdef _WINDOWS
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif // _WINDOWS
+#endif
 
 YJJ_NAMESPACE_START
 
@@ -406,6 +420,78 @@ const int64_t NANOSECONDS_PER_MINUTE = NANOSECONDS_PER_SECOND * SECONDS_PER_MINU
 const int64_t NANOSECONDS_PER_HOUR = NANOSECONDS_PER_SECOND * SECONDS_PER_HOUR;
 const int64_t NANOSECONDS_PER_DAY = NANOSECONDS_PER_HOUR * HOURS_PER_DAY;
 
+#define NANO_TIMER_CLOCK_ENV "KF_NANO_CLOCK" /** "tsc" to stamp with the invariant tsc, steady clock otherwise */
+#define NANO_TIMER_TSC_CALIBRATE_MS 1000 /** tsc mapping is re-calibrated this often */
+#define NANO_TIMER_TSC_MAX_SLEW_NS 1000000 /** larger errors are stepped instead of slewed */
+#define NANO_TIMER_TSC_SCALE_SHIFT 32
+
+/** clock source of getNanoTime */
+enum NanoClockMode
+{
+    NANO_CLOCK_UNINITIALIZED = 0,
+    NANO_CLOCK_STEADY = 1,
+    NANO_CLOCK_TSC = 2
+};
+
+/**
+ * clock state read by the inline getNanoTime, written by NanoTimer only.
+ * the tsc mapping nano = baseNano + (tsc - baseTsc) * scale >> NANO_TIMER_TSC_SCALE_SHIFT
+ * is published under a sequence lock, readers retry while it is being updated.
+ */
+struct NanoClock
+{
+    std::atomic<int> mode;
+    std::atomic<int64_t> secDiff;
+    std::atomic<uint32_t> seq;
+    std::atomic<int64_t> baseTsc;
+    std::atomic<int64_t> baseNano;
+    std::atomic<int64_t> scale;
+};
+
+extern NanoClock nanoClock;
+
+inline int64_t getSteadyNano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline int64_t readTsc()
+{
+#ifdef NANO_TIMER_HAS_TSC
+    return (int64_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/** nano of tsc with the published mapping */
+inline int64_t getTscNano(int64_t tsc)
+{
+    uint32_t seq;
+    int64_t baseTsc, baseNano, scale;
+    do
+    {
+        seq = nanoClock.seq.load(std::memory_order_acquire);
+        baseTsc = nanoClock.baseTsc.load(std::memory_order_relaxed);
+        baseNano = nanoClock.baseNano.load(std::memory_order_relaxed);
+        scale = nanoClock.scale.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != nanoClock.seq.load(std::memory_order_relaxed));
+    // 64 bit products, good for hours between calibrations
+    int64_t delta = tsc - baseTsc;
+    return baseNano + (((delta >> 16) * scale) >> (NANO_TIMER_TSC_SCALE_SHIFT - 16)) + (((delta & 0xffff) * scale) >> NANO_TIMER_TSC_SCALE_SHIFT);
+}
+
+/** calibration history of the tsc clock */
+struct NanoTimerTscStats
+{
+    int64_t calibrations;
+    int64_t steps;           /** calibrations whose error exceeded NANO_TIMER_TSC_MAX_SLEW_NS */
+    int64_t lastErrorNano;   /** reference clock - tsc clock at last calibration */
+    int64_t maxAbsErrorNano; /** since the first calibration */
+    double tscPerSecond;
+};
+
 /**
  * timer for nanosecond, main class
  */
@@ -416,15 +502,35 @@ public:
     int64_t   getNano() const;
     /** return secDiff */
     inline int64_t getSecDiff() const { return secDiff; }
+    /** true if getNanoTime reads the tsc */
+    inline bool isTsc() const { return nanoClock.mode.load(std::memory_order_relaxed) == NANO_CLOCK_TSC; }
+    NanoTimerTscStats getTscStats() const;
     /** singleton */
     static NanoTimer* getInstance();
+    /** reference clock the tsc is calibrated to: steady clock + secDiff */
+    inline int64_t getReferenceNano() const { return getSteadyNano() + secDiff; }
+    /** stop and join the calibration thread, tsc clock keeps its last calibration */
+    ~NanoTimer();
 
 private:
     NanoTimer();
+    /** switch to tsc if the cpu has an invariant tsc, start the calibration thread */
+    bool initTsc();
+    void calibrateTsc();
     /** singleton */
     static boost::shared_ptr<NanoTimer> m_ptr;
     /** object to be updated every time called */
     int64_t secDiff;
+    /** first calibration, the tsc rate is measured from here */
+    int64_t anchorTsc;
+    int64_t anchorNano;
+    NanoTimerTscStats tscStats;
+    mutable std::mutex tscStatsMutex;
+    /** calibration thread, owned so it never outlives the timer */
+    std::thread calibrateThread;
+    std::mutex calibrateMutex;
+    std::condition_variable calibrateCond;
+    bool calibrateStop;
 };
 
 /**
@@ -433,6 +539,15 @@ private:
  */
 inline int64_t getNanoTime()
 {
+    int mode = nanoClock.mode.load(std::memory_order_acquire);
+    if (mode == NANO_CLOCK_TSC)
+    {
+        return getTscNano(readTsc());
+    }
+    if (mode == NANO_CLOCK_STEADY)
+    {
+        return getSteadyNano() + nanoClock.secDiff.load(std::memory_order_relaxed);
+    }
     return NanoTimer::getInstance()->getNano();
 }
 
@@ -68,6 +68,8 @@ inline string get_kungfu_home()
 
 #define JOURNAL_PREFIX string("yjj")        /** journal file prefix */
 #define JOURNAL_SUFFIX string("journal")    /** journal file suffix */
+#define JOURNAL_INDEX_SUFFIX string("index")  /** journal time index file suffix */
+#define JOURNAL_ARCHIVE_SUFFIX string("arc")  /** compressed archive of a closed page, after page file name */
 
 /** fast type convert for moving address forward */
 #define ADDRESS_ADD(x, delta) (void*)((uintptr_t)x + delta)
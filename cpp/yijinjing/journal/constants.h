@@ -39,8 +39,35 @@ const int64_t TIME_TO_LAST = -1;
 /** size related */
 const int KB = 1024;
 const int MB = KB * KB;
+/** default page size, applies to pages created before page_size was kept in header */
 const int JOURNAL_PAGE_SIZE = 128 * MB;
+/** page size has to be in [MIN_JOURNAL_PAGE_SIZE, MAX_JOURNAL_PAGE_SIZE] and aligned to MIN_JOURNAL_PAGE_SIZE */
+const int MIN_JOURNAL_PAGE_SIZE = 1 * MB;
+const int MAX_JOURNAL_PAGE_SIZE = 1024 * MB;
+/** headroom is 1 / PAGE_HEADROOM_RATIO of page size, capped by PAGE_MIN_HEADROOM */
 const int PAGE_MIN_HEADROOM = 2 * MB;
+const int PAGE_HEADROOM_RATIO = 64;
+
+/** journal index keeps one entry every JOURNAL_INDEX_FRAME_INTERVAL frames,
+ * or when JOURNAL_INDEX_NANO_INTERVAL passed since last entry, whichever comes first */
+const int JOURNAL_INDEX_FRAME_INTERVAL = 4096;
+const int64_t JOURNAL_INDEX_NANO_INTERVAL = 100000000; // 100ms
+/** sparse entries are buffered by the writer and flushed every JOURNAL_INDEX_FLUSH_ENTRIES entries,
+ * page start / page end entries and close flush at once */
+const int JOURNAL_INDEX_FLUSH_ENTRIES = 64;
+
+/** how paged and its clients wait on each other through comm buffer */
+enum PagedWaitMode
+{
+    PAGED_WAIT_SPIN = 0,        /**< busy spin, lowest latency, burns a core */
+    PAGED_WAIT_PARK = 1,        /**< sleep on futex until notified */
+    PAGED_WAIT_SPIN_PARK = 2,   /**< spin PAGED_SPIN_BEFORE_PARK rounds, then sleep on futex */
+};
+const int PAGED_SPIN_BEFORE_PARK = 20000;
+/** parked side re-checks at least this often */
+const int PAGED_PARK_TIMEOUT_MICROSEC = 100000;
+/** JournalReader::waitNextFrame without paged sleeps at most this long between polls */
+const int JOURNAL_POLL_MICROSEC = 1000;
 
 YJJ_NAMESPACE_END
 
@@ -0,0 +1,205 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Page archive benchmark.
+ * write quote-like frames over several pages, replay them all, archive every closed page,
+ * then replay again from archives and seek to random nanos through the time index.
+ * report disk footprint, archiving cost and replay throughput, check frames are identical.
+ * usage: bench_journal_archive [frame_num] [page_size_mb] [seek_num]
+ */
+
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "PageArchive.h"
+#include "PageUtil.h"
+#include "Timer.h"
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <sys/stat.h>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define BENCH_JOURNAL_NAME "bench"
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct BenchQuote
+{
+    char    instrument_id[32];
+    double  last_price;
+    double  bid_price[5];
+    double  ask_price[5];
+    int     bid_volume[5];
+    int     ask_volume[5];
+    int64_t volume;
+};
+
+/** allocated bytes of all files in dir */
+int64_t disk_usage(const string& dir)
+{
+    int64_t total = 0;
+    for (auto& file : boost::filesystem::directory_iterator(dir))
+    {
+        struct stat st;
+        if (stat(file.path().string().c_str(), &st) == 0)
+            total += (int64_t)st.st_blocks * 512;
+    }
+    return total;
+}
+
+struct ReplayResult
+{
+    size_t  frames;
+    int64_t checksum;
+    int64_t nano;
+};
+
+ReplayResult replay(const string& dir)
+{
+    vector<string> dirs = {dir};
+    vector<string> jnames = {BENCH_JOURNAL_NAME};
+    JournalReaderPtr reader = JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    Frame frame(nullptr);
+    ReplayResult result = {0, 0, 0};
+    int64_t start = now_nano();
+    while (reader->getNextFrame(frame))
+    {
+        const BenchQuote* quote = (const BenchQuote*)frame.getData();
+        result.checksum = result.checksum * 31 + frame.getNano() + (int64_t)(quote->last_price * 1000) + quote->volume;
+        result.frames++;
+    }
+    result.nano = now_nano() - start;
+    return result;
+}
+
+/** return average nanoseconds per seek, -1 if any seek lands on a wrong frame */
+int64_t bench_seek(const string& dir, const vector<int64_t>& targets)
+{
+    vector<string> dirs = {dir};
+    vector<string> jnames = {BENCH_JOURNAL_NAME};
+    JournalReaderPtr reader = JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    Frame frame(nullptr);
+    int64_t total = 0;
+    for (int64_t target: targets)
+    {
+        int64_t before = now_nano();
+        reader->jumpStart(target);
+        bool found = reader->getNextFrame(frame);
+        total += now_nano() - before;
+        if (!found || frame.getNano() != target)
+        {
+            std::cerr << "seek to " << target << " got " << (found ? frame.getNano() : -1) << std::endl;
+            return -1;
+        }
+    }
+    return targets.empty() ? 0 : total / (int64_t)targets.size();
+}
+
+int main(int argc, char** argv)
+{
+    size_t frame_num = (argc > 1) ? atol(argv[1]) : 1000000;
+    int page_size = ((argc > 2) ? atoi(argv[2]) : 16) * MB;
+    size_t seek_num = (argc > 3) ? atol(argv[3]) : 200;
+    // NanoTimer needs KF_HOME even without paged
+    setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-bench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    vector<int64_t> nanos;
+    nanos.reserve(frame_num);
+    {
+        JournalWriterPtr writer = JournalWriter::create(dir.string(), BENCH_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)), page_size);
+        std::mt19937 rng(20170301);
+        BenchQuote quote = {};
+        double prices[8] = {3500, 12.5, 48.2, 7.31, 102.0, 65.4, 23.8, 9.9};
+        int64_t last = 0;
+        for (size_t i = 0; i < frame_num; i++)
+        {
+            int inst = rng() % 8;
+            snprintf(quote.instrument_id, sizeof(quote.instrument_id), "60000%d", inst);
+            prices[inst] += ((int)(rng() % 5) - 2) * 0.01;
+            quote.last_price = prices[inst];
+            for (int l = 0; l < 5; l++)
+            {
+                quote.bid_price[l] = prices[inst] - 0.01 * (l + 1);
+                quote.ask_price[l] = prices[inst] + 0.01 * (l + 1);
+                quote.bid_volume[l] = 100 * (rng() % 50);
+                quote.ask_volume[l] = 100 * (rng() % 50);
+            }
+            quote.volume += rng() % 1000;
+            int64_t nano = writer->write_frame(&quote, sizeof(quote), 0, 0, 1, -1);
+            // seeking lands on the first frame of equal nanos, only keep distinct ones as targets
+            if (nano != last)
+                nanos.push_back(nano);
+            last = nano;
+        }
+    }
+    vector<short> pageNums = PageUtil::GetPageNums(dir.string(), BENCH_JOURNAL_NAME);
+    std::cout << "(frames) " << frame_num << " (frame bytes) " << sizeof(BenchQuote) + BASIC_FRAME_HEADER_LENGTH
+              << " (pages) " << pageNums.size() << " (page mb) " << page_size / MB << std::endl;
+
+    ReplayResult raw = replay(dir.string());
+    int64_t rawDisk = disk_usage(dir.string());
+
+    // the last page is never closed by the writer, it stays as is
+    PageArchiveStat total = {};
+    int archived = 0;
+    int64_t start = now_nano();
+    for (short pageNum: pageNums)
+    {
+        PageArchiveStat stat = {};
+        if (PageArchive::archivePage(dir.string(), BENCH_JOURNAL_NAME, pageNum, stat))
+        {
+            archived++;
+            total.page_disk_size += stat.page_disk_size;
+            total.archive_size += stat.archive_size;
+            total.raw_size += stat.raw_size;
+            total.block_num += stat.block_num;
+        }
+    }
+    int64_t archiveNano = now_nano() - start;
+    int64_t archiveDisk = disk_usage(dir.string());
+    std::cout << "[archive] (pages) " << archived << " (blocks) " << total.block_num
+              << " (ms) " << archiveNano / 1e6 << " (MB/s) " << total.raw_size / 1e3 / (archiveNano / 1e6)
+              << " (ratio) " << (double)total.page_disk_size / std::max(total.archive_size, (int64_t)1) << std::endl;
+    std::cout << "[disk] (raw MB) " << rawDisk / 1e6 << " (archived MB) " << archiveDisk / 1e6 << std::endl;
+
+    ReplayResult arc = replay(dir.string());
+    std::cout << "[replay raw    ] (frames) " << raw.frames << " (ms) " << raw.nano / 1e6
+              << " (Mframes/s) " << raw.frames / (raw.nano / 1e3) << std::endl;
+    std::cout << "[replay archive] (frames) " << arc.frames << " (ms) " << arc.nano / 1e6
+              << " (Mframes/s) " << arc.frames / (arc.nano / 1e3) << std::endl;
+
+    std::mt19937 rng(20170302);
+    vector<int64_t> targets;
+    for (size_t i = 0; i < seek_num && !nanos.empty(); i++)
+        targets.push_back(nanos[rng() % nanos.size()]);
+    int64_t seek = bench_seek(dir.string(), targets);
+    std::cout << "[seek archive] (ns/seek) " << seek << std::endl;
+
+    bool ok = raw.frames == frame_num && arc.frames == raw.frames && arc.checksum == raw.checksum
+              && archived + 1 == (int)pageNums.size() && seek >= 0;
+    boost::filesystem::remove_all(dir);
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * JournalWriter batch benchmark.
+ * write bursts of frames one by one (built on stack, copied by write_frame)
+ * and by reserve / commit (built in page), then read all back to check order and content.
+ * usage: bench_journal_batch [burst_num] [burst_size] [data_length] [page_size_mb]
+ */
+
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "Timer.h"
+
+#include <chrono>
+#include <iostream>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define BENCH_JOURNAL_NAME "bench"
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** fake tick, seq is written at the head and the tail */
+inline void fill_tick(void* data, int length, int64_t seq)
+{
+    memcpy(data, &seq, sizeof(seq));
+    memcpy(ADDRESS_ADD(data, length - sizeof(seq)), &seq, sizeof(seq));
+}
+
+/** return frames read, -1 if any frame is out of order or broken */
+int64_t check(const string& dir)
+{
+    vector<string> dirs = {dir};
+    vector<string> jnames = {BENCH_JOURNAL_NAME};
+    JournalReaderPtr reader = JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    Frame frame(nullptr);
+    int64_t expected = 0;
+    int64_t lastNano = 0;
+    while (reader->getNextFrame(frame))
+    {
+        int64_t head, tail;
+        memcpy(&head, frame.getData(), sizeof(head));
+        memcpy(&tail, ADDRESS_ADD(frame.getData(), frame.getDataLength() - sizeof(tail)), sizeof(tail));
+        if (head != expected || tail != expected || frame.getNano() < lastNano)
+        {
+            std::cerr << "(expected) " << expected << " (head) " << head << " (tail) " << tail << std::endl;
+            return -1;
+        }
+        lastNano = frame.getNano();
+        expected++;
+    }
+    return expected;
+}
+
+void bench(const string& name, bool batch, int burst_num, int burst_size, int data_length, int page_size)
+{
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-bench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    int64_t total = 0;
+    {
+        JournalWriterPtr writer = JournalWriter::create(dir.string(), BENCH_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)), page_size);
+        vector<char> tick(data_length);
+        int64_t seq = 0;
+        for (int i = 0; i < burst_num; i++)
+        {
+            int64_t start = now_nano();
+            for (int j = 0; j < burst_size; j++)
+            {
+                if (batch)
+                {
+                    void* data = writer->reserve(data_length, 0, 0, 1, -1);
+                    if (data == nullptr)
+                    {   // page is full, publish the burst so far and go on in next page
+                        writer->commit();
+                        data = writer->reserve(data_length, 0, 0, 1, -1);
+                    }
+                    fill_tick(data, data_length, seq++);
+                }
+                else
+                {
+                    fill_tick(tick.data(), data_length, seq++);
+                    writer->write_frame(tick.data(), data_length, 0, 0, 1, -1);
+                }
+            }
+            if (batch)
+                writer->commit();
+            total += now_nano() - start;
+        }
+    }
+    int64_t frames = (int64_t)burst_num * burst_size;
+    int64_t checked = check(dir.string());
+    std::cout << name
+              << " (frames/sec) " << (int64_t)(frames * (double)NANOSECONDS_PER_SECOND / total)
+              << " (ns/burst) " << total / burst_num
+              << " (checked) " << ((checked == frames) ? "ok" : "FAILED") << std::endl;
+    boost::filesystem::remove_all(dir);
+}
+
+int main(int argc, char** argv)
+{
+    int burst_num = (argc > 1) ? atoi(argv[1]) : 10000;
+    int burst_size = (argc > 2) ? atoi(argv[2]) : 200;
+    int data_length = (argc > 3) ? atoi(argv[3]) : 128;
+    int page_size = ((argc > 4) ? atoi(argv[4]) : 16) * MB;
+    // NanoTimer needs KF_HOME even without paged
+    setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+
+    std::cout << "(bursts) " << burst_num << " (burst size) " << burst_size << " (data length) " << data_length << std::endl;
+    bench("[write_frame   ]", false, burst_num, burst_size, data_length, page_size);
+    bench("[reserve/commit]", true, burst_num, burst_size, data_length, page_size);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * JournalReader merge benchmark.
+ * sweep 1 ~ 256 journals, compare MERGE_LINEAR_SCAN with MERGE_MIN_HEAP,
+ * report frames/sec and check frames come out in nano order.
+ * usage: bench_journal_merge [frame_num] [max_journal_num]
+ */
+
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "Timer.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+string journal_name(size_t idx)
+{
+    std::stringstream ss;
+    ss << "bench" << idx;
+    return ss.str();
+}
+
+/** return frames per second, -1 if frames are out of order */
+double bench_merge(const string& dir, size_t journal_num, size_t frame_num, JournalMergeMode mode)
+{
+    vector<string> dirs(journal_num, dir);
+    vector<string> jnames;
+    for (size_t i = 0; i < journal_num; i++)
+        jnames.push_back(journal_name(i));
+    JournalReaderPtr reader = JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    reader->setMergeMode(mode);
+
+    Frame frame(nullptr);
+    size_t count = 0;
+    int64_t last_nano = 0;
+    bool ordered = true;
+    int64_t start = now_nano();
+    while (count < frame_num && reader->getNextFrame(frame))
+    {
+        ordered &= frame.getNano() >= last_nano;
+        last_nano = frame.getNano();
+        count++;
+    }
+    int64_t total = now_nano() - start;
+    if (count != frame_num)
+        std::cerr << "expect " << frame_num << " frames, got " << count << std::endl;
+    return ordered ? count * (double)NANOSECONDS_PER_SECOND / total : -1;
+}
+
+int main(int argc, char** argv)
+{
+    size_t frame_num = (argc > 1) ? atol(argv[1]) : 1000000;
+    size_t max_journal_num = (argc > 2) ? atol(argv[2]) : 256;
+    // NanoTimer needs KF_HOME even without paged
+    setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+
+    for (size_t journal_num = 1; journal_num <= max_journal_num; journal_num *= 2)
+    {
+        boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-bench-%%%%%%");
+        boost::filesystem::create_directories(dir);
+        {
+            vector<JournalWriterPtr> writers;
+            for (size_t i = 0; i < journal_num; i++)
+                writers.push_back(JournalWriter::create(dir.string(), journal_name(i), PageProviderPtr(new LocalPageProvider(true))));
+            int64_t data = 0;
+            for (size_t i = 0; i < frame_num; i++, data++)
+                writers[i % journal_num]->write_frame(&data, sizeof(data), 0, 0, 1, -1);
+        }
+        double linear = bench_merge(dir.string(), journal_num, frame_num, MERGE_LINEAR_SCAN);
+        double heap = bench_merge(dir.string(), journal_num, frame_num, MERGE_MIN_HEAP);
+        std::cout << "(journals) " << journal_num
+                  << " (linear frames/sec) " << (int64_t)linear
+                  << " (heap frames/sec) " << (int64_t)heap << std::endl;
+        boost::filesystem::remove_all(dir);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * JournalReader micro benchmark.
+ * compare FramePtr getNextFrame() with heap-free getNextFrame(Frame&),
+ * report frames/sec and p50 / p99 per-frame latency.
+ * usage: bench_journal_reader [frame_num] [data_length]
+ */
+
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "Timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define BENCH_JOURNAL_NAME "bench"
+
+struct BenchResult
+{
+    size_t  frame_num;
+    double  frames_per_sec;
+    int64_t p50;
+    int64_t p99;
+};
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BenchResult summarize(vector<int64_t>& latencies, int64_t total)
+{
+    BenchResult res = {};
+    res.frame_num = latencies.size();
+    if (latencies.empty())
+        return res;
+    std::sort(latencies.begin(), latencies.end());
+    res.frames_per_sec = latencies.size() * (double)NANOSECONDS_PER_SECOND / total;
+    res.p50 = latencies[latencies.size() / 2];
+    res.p99 = latencies[latencies.size() * 99 / 100];
+    return res;
+}
+
+JournalReaderPtr create_reader(const string& dir)
+{
+    vector<string> dirs = {dir};
+    vector<string> jnames = {BENCH_JOURNAL_NAME};
+    return JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+}
+
+BenchResult bench_frame_ptr(const string& dir, size_t frame_num)
+{
+    JournalReaderPtr reader = create_reader(dir);
+    vector<int64_t> latencies;
+    latencies.reserve(frame_num);
+    int64_t checksum = 0;
+    int64_t start = now_nano();
+    while (latencies.size() < frame_num)
+    {
+        int64_t before = now_nano();
+        FramePtr frame = reader->getNextFrame();
+        if (frame.get() == nullptr)
+            break;
+        checksum += frame->getNano();
+        latencies.push_back(now_nano() - before);
+    }
+    int64_t total = now_nano() - start;
+    if (checksum == 0)
+        std::cerr << "no frame read" << std::endl;
+    return summarize(latencies, total);
+}
+
+BenchResult bench_frame_view(const string& dir, size_t frame_num)
+{
+    JournalReaderPtr reader = create_reader(dir);
+    vector<int64_t> latencies;
+    latencies.reserve(frame_num);
+    int64_t checksum = 0;
+    Frame frame(nullptr);
+    int64_t start = now_nano();
+    while (latencies.size() < frame_num)
+    {
+        int64_t before = now_nano();
+        if (!reader->getNextFrame(frame))
+            break;
+        checksum += frame.getNano();
+        latencies.push_back(now_nano() - before);
+    }
+    int64_t total = now_nano() - start;
+    if (checksum == 0)
+        std::cerr << "no frame read" << std::endl;
+    return summarize(latencies, total);
+}
+
+void print_result(const string& name, const BenchResult& res)
+{
+    std::cout << name
+              << " (frames) " << res.frame_num
+              << " (frames/sec) " << (int64_t)res.frames_per_sec
+              << " (p50 ns) " << res.p50
+              << " (p99 ns) " << res.p99 << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t frame_num = (argc > 1) ? atol(argv[1]) : 1000000;
+    int data_length = (argc > 2) ? atoi(argv[2]) : 64;
+    // NanoTimer needs KF_HOME even without paged
+    setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-bench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    {
+        JournalWriterPtr writer = JournalWriter::create(dir.string(), BENCH_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)));
+        vector<char> data(data_length, 'k');
+        for (size_t i = 0; i < frame_num; i++)
+            writer->write_frame(data.data(), data_length, 0, 0, 1, -1);
+    }
+
+    print_result("[FramePtr]", bench_frame_ptr(dir.string(), frame_num));
+    print_result("[Frame&  ]", bench_frame_view(dir.string(), frame_num));
+
+    boost::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Journal time seek benchmark.
+ * seek to random written nanos with time index, then again after the index is removed,
+ * check the first frame after each seek and report average seek latency.
+ * usage: bench_journal_seek [frame_num] [page_size_mb] [seek_num]
+ */
+
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+#include "PageUtil.h"
+#include "Timer.h"
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define BENCH_JOURNAL_NAME "bench"
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** return average nanoseconds per seek, -1 if any seek lands on a wrong frame */
+int64_t bench_seek(const string& dir, const vector<int64_t>& targets)
+{
+    vector<string> dirs = {dir};
+    vector<string> jnames = {BENCH_JOURNAL_NAME};
+    JournalReaderPtr reader = JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    Frame frame(nullptr);
+    int64_t total = 0;
+    for (int64_t target: targets)
+    {
+        int64_t before = now_nano();
+        reader->jumpStart(target);
+        bool found = reader->getNextFrame(frame);
+        total += now_nano() - before;
+        if (!found || frame.getNano() != target)
+        {
+            std::cerr << "seek to " << target << " got " << (found ? frame.getNano() : -1) << std::endl;
+            return -1;
+        }
+    }
+    return targets.empty() ? 0 : total / (int64_t)targets.size();
+}
+
+int main(int argc, char** argv)
+{
+    size_t frame_num = (argc > 1) ? atol(argv[1]) : 2000000;
+    int page_size = ((argc > 2) ? atoi(argv[2]) : 16) * MB;
+    size_t seek_num = (argc > 3) ? atol(argv[3]) : 200;
+    // NanoTimer needs KF_HOME even without paged
+    setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+
+    boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-bench-%%%%%%");
+    boost::filesystem::create_directories(dir);
+    vector<int64_t> nanos;
+    nanos.reserve(frame_num);
+    {
+        JournalWriterPtr writer = JournalWriter::create(dir.string(), BENCH_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)), page_size);
+        char data[64] = {};
+        int64_t last = 0;
+        for (size_t i = 0; i < frame_num; i++)
+        {
+            int64_t nano = writer->write_frame(data, sizeof(data), 0, 0, 1, -1);
+            // seeking lands on the first frame of equal nanos, only keep distinct ones as targets
+            if (nano != last)
+                nanos.push_back(nano);
+            last = nano;
+        }
+    }
+
+    std::mt19937 rng(20170301);
+    vector<int64_t> targets;
+    for (size_t i = 0; i < seek_num && !nanos.empty(); i++)
+        targets.push_back(nanos[rng() % nanos.size()]);
+
+    std::cout << "(frames) " << frame_num
+              << " (pages) " << PageUtil::GetPageNums(dir.string(), BENCH_JOURNAL_NAME).size()
+              << " (seeks) " << targets.size() << std::endl;
+    std::cout << "[indexed] (ns/seek) " << bench_seek(dir.string(), targets) << std::endl;
+    boost::filesystem::remove(PageUtil::GenIndexFullPath(dir.string(), BENCH_JOURNAL_NAME));
+    std::cout << "[scan   ] (ns/seek) " << bench_seek(dir.string(), targets) << std::endl;
+
+    boost::filesystem::remove_all(dir);
+    return 0;
+}
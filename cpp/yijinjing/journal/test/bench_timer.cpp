@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * NanoTimer benchmark and tsc drift report.
+ * times getNanoTime against the former singleton path and the raw clocks, then samples the tsc clock
+ * against its reference (steady clock + secDiff) and CLOCK_REALTIME for a while.
+ * runs with KF_NANO_CLOCK=tsc unless set otherwise.
+ * usage: bench_timer [call_num] [drift_seconds]
+ */
+
+#include "Timer.h"
+
+#include <iostream>
+#include <thread>
+#include <time.h>
+
+USING_YJJ_NAMESPACE
+
+/** getNanoTime before the inline clock: singleton lookup, then steady clock + secDiff */
+class LegacyTimer
+{
+public:
+    static LegacyTimer* getInstance()
+    {
+        if (m_ptr.get() == nullptr)
+        {
+            m_ptr = boost::shared_ptr<LegacyTimer>(new LegacyTimer());
+        }
+        return m_ptr.get();
+    }
+    int64_t getNano() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() + secDiff;
+    }
+private:
+    LegacyTimer(): secDiff(NanoTimer::getInstance()->getSecDiff()) {}
+    static boost::shared_ptr<LegacyTimer> m_ptr;
+    int64_t secDiff;
+};
+boost::shared_ptr<LegacyTimer> LegacyTimer::m_ptr;
+
+inline int64_t realtimeNano()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * NANOSECONDS_PER_SECOND + ts.tv_nsec;
+}
+
+template <typename F>
+double timeCalls(const char* name, int callNum, F clock)
+{
+    int64_t sum = 0;
+    int64_t start = getSteadyNano();
+    for (int i = 0; i < callNum; i++)
+    {
+        sum += clock();
+    }
+    double ns = (double)(getSteadyNano() - start) / callNum;
+    std::cout << "[" << name << "] (ns per call) " << ns << (sum == 0 ? " " : "") << std::endl;
+    return ns;
+}
+
+int main(int argc, char** argv)
+{
+    int callNum = (argc > 1) ? atoi(argv[1]) : 10000000;
+    int driftSeconds = (argc > 2) ? atoi(argv[2]) : 10;
+    setenv(NANO_TIMER_CLOCK_ENV, "tsc", 0);
+
+    NanoTimer* timer = NanoTimer::getInstance();
+    std::cout << "(calls) " << callNum << " (clock) " << (timer->isTsc() ? "tsc" : "steady") << std::endl;
+    timeCalls("legacy singleton ", callNum, []() { return LegacyTimer::getInstance()->getNano(); });
+    timeCalls("getNanoTime      ", callNum, []() { return getNanoTime(); });
+    timeCalls("steady + secDiff ", callNum, []() { return getSteadyNano() + nanoClock.secDiff.load(std::memory_order_relaxed); });
+    timeCalls("CLOCK_REALTIME   ", callNum, []() { return realtimeNano(); });
+    timeCalls("rdtsc            ", callNum, []() { return readTsc(); });
+
+    // monotonic within a thread
+    int64_t last = getNanoTime();
+    int64_t backwards = 0;
+    for (int i = 0; i < callNum; i++)
+    {
+        int64_t nano = getNanoTime();
+        backwards += nano < last;
+        last = nano;
+    }
+    std::cout << "(backwards steps) " << backwards << std::endl;
+    if (!timer->isTsc())
+    {
+        return backwards == 0 ? 0 : 1;
+    }
+
+    std::cout << "(drift report, every 500ms) tsc - reference, tsc - CLOCK_REALTIME (realtime offset removed)" << std::endl;
+    int64_t realtimeOffset = realtimeNano() - getNanoTime();
+    for (int i = 0; i < driftSeconds * 2; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        int64_t reference = timer->getReferenceNano();
+        int64_t tsc = getNanoTime();
+        int64_t realtime = realtimeNano();
+        NanoTimerTscStats stats = timer->getTscStats();
+        std::cout << "  (t) " << (i + 1) * 0.5 << "s"
+                  << " (vs reference ns) " << tsc - reference
+                  << " (vs realtime ns) " << tsc + realtimeOffset - realtime
+                  << " (calibrations) " << stats.calibrations
+                  << " (last error ns) " << stats.lastErrorNano << std::endl;
+    }
+    NanoTimerTscStats stats = timer->getTscStats();
+    std::cout << "(tsc per second) " << (int64_t)stats.tscPerSecond << " (max calibration error ns) " << stats.maxAbsErrorNano
+              << " (steps) " << stats.steps << std::endl;
+    return backwards == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * JournalWriter reserve / commit across page boundary.
+ */
+
+#include "gtest/gtest.h"
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "PageProvider.h"
+
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define TEST_JOURNAL_NAME "batch"
+#define TEST_DATA_LENGTH 1000
+
+class JournalBatchTest : public ::testing::Test
+{
+protected:
+    JournalBatchTest()
+    {
+        setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+        dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-test-%%%%%%");
+        boost::filesystem::create_directories(dir);
+    }
+
+    virtual ~JournalBatchTest()
+    {
+        boost::filesystem::remove_all(dir);
+    }
+
+    JournalReaderPtr createReader()
+    {
+        vector<string> dirs = {dir.string()};
+        vector<string> jnames = {TEST_JOURNAL_NAME};
+        return JournalReader::create(dirs, jnames, TIME_FROM_FIRST, PageProviderPtr(new LocalPageProvider(false)));
+    }
+
+    boost::filesystem::path dir;
+};
+
+TEST_F(JournalBatchTest, BatchCrossingPage)
+{
+    JournalWriterPtr writer = JournalWriter::create(dir.string(), TEST_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)), MIN_JOURNAL_PAGE_SIZE);
+    short firstPage = writer->getPageNum();
+
+    // reserve until the page is full, fill the frames only afterwards
+    vector<void*> reserved;
+    void* data = nullptr;
+    while ((data = writer->reserve(TEST_DATA_LENGTH, 0, 0, 1, -1)) != nullptr)
+        reserved.push_back(data);
+    ASSERT_GT(reserved.size(), 1);
+    EXPECT_EQ(writer->getReservedNum(), (int)reserved.size());
+    EXPECT_EQ(writer->getPageNum(), firstPage);
+
+    // nothing is published before commit
+    Frame frame(nullptr);
+    EXPECT_FALSE(createReader()->getNextFrame(frame));
+
+    int64_t seq = 0;
+    for (void* d : reserved)
+    {
+        memset(d, 0, TEST_DATA_LENGTH);
+        memcpy(d, &seq, sizeof(seq));
+        seq++;
+    }
+    int64_t firstNano = writer->commit();
+    EXPECT_GT(firstNano, 0);
+    EXPECT_EQ(writer->getReservedNum(), 0);
+
+    // the next batch starts on next page
+    data = writer->reserve(TEST_DATA_LENGTH, 0, 0, 1, -1);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(writer->getPageNum(), firstPage + 1);
+    memset(data, 0, TEST_DATA_LENGTH);
+    memcpy(data, &seq, sizeof(seq));
+    seq++;
+    int64_t secondNano = writer->commit();
+
+    JournalReaderPtr reader = createReader();
+    int64_t expected = 0;
+    while (reader->getNextFrame(frame))
+    {
+        int64_t value = -1;
+        memcpy(&value, frame.getData(), sizeof(value));
+        EXPECT_EQ(value, expected);
+        EXPECT_EQ(frame.getNano(), (expected < (int64_t)reserved.size()) ? firstNano : secondNano);
+        expected++;
+    }
+    EXPECT_EQ(expected, seq);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
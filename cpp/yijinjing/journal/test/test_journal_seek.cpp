@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Journal seekTime through time index, including a stale index entry.
+ */
+
+#include "gtest/gtest.h"
+#include "JournalReader.h"
+#include "JournalWriter.h"
+#include "JournalIndex.h"
+#include "PageProvider.h"
+#include "PageUtil.h"
+#include "PageHeader.h"
+
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+#define TEST_JOURNAL_NAME "seek"
+#define TEST_FRAME_NUM 10000
+
+class JournalSeekTest : public ::testing::Test
+{
+protected:
+    JournalSeekTest()
+    {
+        setenv("KF_HOME", boost::filesystem::temp_directory_path().string().c_str(), 0);
+        dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("yjj-test-%%%%%%");
+        boost::filesystem::create_directories(dir);
+        JournalWriterPtr writer = JournalWriter::create(dir.string(), TEST_JOURNAL_NAME, PageProviderPtr(new LocalPageProvider(true)), MIN_JOURNAL_PAGE_SIZE);
+        for (int64_t i = 0; i < TEST_FRAME_NUM; i++)
+            nanos.push_back(writer->write_frame(&i, sizeof(i), 0, 0, 1, -1));
+        // half of the frames are written in batches
+        for (int64_t i = TEST_FRAME_NUM; i < 2 * TEST_FRAME_NUM; i++)
+        {
+            memcpy(writer->reserve(sizeof(i), 0, 0, 1, -1), &i, sizeof(i));
+            if (i % 10 == 9)
+            {
+                int64_t nano = writer->commit();
+                nanos.insert(nanos.end(), 10, nano);
+            }
+        }
+    }
+
+    virtual ~JournalSeekTest()
+    {
+        boost::filesystem::remove_all(dir);
+    }
+
+    /** seq of the first frame read after seeking to time, -1 if none */
+    int64_t seek(int64_t time)
+    {
+        vector<string> dirs = {dir.string()};
+        vector<string> jnames = {TEST_JOURNAL_NAME};
+        JournalReaderPtr reader = JournalReader::create(dirs, jnames, time, PageProviderPtr(new LocalPageProvider(false)));
+        Frame frame(nullptr);
+        if (!reader->getNextFrame(frame))
+            return -1;
+        int64_t seq = -1;
+        memcpy(&seq, frame.getData(), sizeof(seq));
+        return seq;
+    }
+
+    /** seq of the first frame with nano >= time */
+    int64_t expected(int64_t time)
+    {
+        return std::lower_bound(nanos.begin(), nanos.end(), time) - nanos.begin();
+    }
+
+    boost::filesystem::path dir;
+    vector<int64_t> nanos;
+};
+
+TEST_F(JournalSeekTest, IndexFlushedOnClose)
+{
+    JournalIndexPtr index = JournalIndex::openForRead(dir.string(), TEST_JOURNAL_NAME);
+    ASSERT_NE(index.get(), nullptr);
+    JournalIndexEntry entry;
+    ASSERT_TRUE(index->lookup(nanos.back(), entry));
+    EXPECT_GT(entry.nano, nanos[TEST_FRAME_NUM / 2]);
+}
+
+TEST_F(JournalSeekTest, SeekTime)
+{
+    for (int64_t i = 0; i < 2 * TEST_FRAME_NUM; i += 997)
+        EXPECT_EQ(seek(nanos[i]), expected(nanos[i]));
+}
+
+TEST_F(JournalSeekTest, StaleIndexEntry)
+{
+    int64_t target = nanos[TEST_FRAME_NUM + TEST_FRAME_NUM / 2];
+    // an entry pointing into the middle of a frame, as left by a rewritten page
+    JournalIndexEntry stale = {target - 1, (int)sizeof(PageHeader) + 7, 1, JOURNAL_INDEX_SPARSE};
+    FILE* file = fopen(PageUtil::GenIndexFullPath(dir.string(), TEST_JOURNAL_NAME).c_str(), "ab");
+    ASSERT_NE(file, nullptr);
+    fwrite(&stale, sizeof(stale), 1, file);
+    fclose(file);
+    EXPECT_EQ(seek(target), expected(target));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -25,6 +25,14 @@
 #include "constants.h"
 #include "sys_messages.h"
 #include <string.h>
+#include <thread>
+#include <chrono>
+#ifdef __linux__
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 
 YJJ_NAMESPACE_START
 
@@ -43,6 +51,10 @@ YJJ_NAMESPACE_START
  *                                          -> PAGE_NON_EXIST (reader wants a not existing page)
  *                                          -> PAGE_MEM_OVERFLOW (current locking memory overflows)
  *
+ *      doorbell (after all msg blocks in comm buffer):
+ *      user:   bump request_seq after PAGE_REQUESTING, wake server if parked
+ *      server: bump reply_seq[idx] after answering, wake user
+ *
  */
 //////////////////////////////////////////
 /// (byte) PagedCommTypeConstants
@@ -73,6 +85,8 @@ struct PageCommMsg
     short   page_num;
     /** page number requested (by server) */
     short   last_page_num;
+    /** size of page if it needs to be created (by client) */
+    int     page_size;
 
     // operators for map key
     bool const operator == (const PageCommMsg &p) const
@@ -97,10 +111,135 @@ struct PageCommMsg
 #define MAX_COMM_USER_NUMBER 1000
 /** REQUEST_ID_RANGE * MAX_COMM_USER_NUMBER < 2147483647(max num of int) */
 #define REQUEST_ID_RANGE 1000000
+
+/** futex words to notify each other instead of spinning on status */
+struct PageCommDoorbell
+{
+    /** bumped by client on each request, server parks on it */
+    volatile int request_seq;
+    /** 1 if server is parked (by server) */
+    volatile int server_parked;
+    /** bumped by server after answering each msg block, client parks on it */
+    volatile int reply_seq[MAX_COMM_USER_NUMBER];
+    /** bumped by writers after publishing frames while any reader is parked, readers park on it */
+    volatile int journal_seq;
+    /** number of readers parked on journal_seq */
+    volatile int journal_waiters;
+};
+
 /** based on the max number, the comm file size is determined */
-const int COMM_SIZE = MAX_COMM_USER_NUMBER * sizeof(PageCommMsg) + 1024;
+const int COMM_SIZE = MAX_COMM_USER_NUMBER * sizeof(PageCommMsg) + sizeof(PageCommDoorbell) + 1024;
 /** fast type convert */
 #define GET_COMM_MSG(buffer, idx) ((PageCommMsg*)(ADDRESS_ADD(buffer, idx * sizeof(PageCommMsg))))
+#define GET_COMM_DOORBELL(buffer) ((PageCommDoorbell*)(ADDRESS_ADD(buffer, MAX_COMM_USER_NUMBER * sizeof(PageCommMsg))))
+static_assert(MAX_COMM_USER_NUMBER * sizeof(PageCommMsg) % sizeof(int) == 0, "futex words have to be aligned");
+
+/** sleep while *addr == expected, at most timeoutMicro */
+inline void comm_futex_wait(volatile int* addr, int expected, int timeoutMicro)
+{
+#ifdef __linux__
+    struct timespec ts = {timeoutMicro / 1000000, (timeoutMicro % 1000000) * 1000};
+    syscall(SYS_futex, (int*)addr, FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+    if (*addr == expected)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+/** wake all waiting on addr */
+inline void comm_futex_wake(volatile int* addr)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (int*)addr, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+inline void comm_cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/** client: ring server after msg status is set to PAGED_COMM_REQUESTING */
+inline void comm_notify_request(PageCommDoorbell* bell)
+{
+    __atomic_add_fetch(&bell->request_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bell->server_parked, __ATOMIC_SEQ_CST))
+        comm_futex_wake(&bell->request_seq);
+}
+
+/** server: wait for next request, seq is request_seq loaded before last scan */
+inline void comm_wait_request(PageCommDoorbell* bell, int seq, PagedWaitMode mode)
+{
+    if (mode == PAGED_WAIT_SPIN)
+        return;
+    if (mode == PAGED_WAIT_SPIN_PARK)
+    {
+        for (int i = 0; i < PAGED_SPIN_BEFORE_PARK; i++)
+        {
+            if (__atomic_load_n(&bell->request_seq, __ATOMIC_ACQUIRE) != seq)
+                return;
+            comm_cpu_relax();
+        }
+    }
+    // announce parking before the last check, client checks in reversed order
+    __atomic_store_n(&bell->server_parked, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bell->request_seq, __ATOMIC_SEQ_CST) == seq)
+        comm_futex_wait(&bell->request_seq, seq, PAGED_PARK_TIMEOUT_MICROSEC);
+    __atomic_store_n(&bell->server_parked, 0, __ATOMIC_SEQ_CST);
+}
+
+/** server: notify client after msg status of idx is answered */
+inline void comm_notify_reply(PageCommDoorbell* bell, size_t idx)
+{
+    __atomic_add_fetch(&bell->reply_seq[idx], 1, __ATOMIC_SEQ_CST);
+    comm_futex_wake(&bell->reply_seq[idx]);
+}
+
+/** client: wait until msg is answered, reply is reply_seq[idx] loaded before requesting */
+inline void comm_wait_reply(PageCommMsg* msg, PageCommDoorbell* bell, size_t idx, int reply, PagedWaitMode mode)
+{
+    int spins = 0;
+    while (msg->status == PAGED_COMM_REQUESTING)
+    {
+        if (mode == PAGED_WAIT_SPIN || (mode == PAGED_WAIT_SPIN_PARK && spins++ < PAGED_SPIN_BEFORE_PARK))
+            comm_cpu_relax();
+        else
+            comm_futex_wait(&bell->reply_seq[idx], reply, PAGED_PARK_TIMEOUT_MICROSEC);
+    }
+}
+
+/** writer: ring parked readers after frames are published, a syscall only if someone is parked */
+inline void comm_notify_journal(PageCommDoorbell* bell)
+{
+    // frame status stores before waiters load, reader does the reverse
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&bell->journal_waiters, __ATOMIC_RELAXED) > 0)
+    {
+        __atomic_add_fetch(&bell->journal_seq, 1, __ATOMIC_SEQ_CST);
+        comm_futex_wake(&bell->journal_seq);
+    }
+}
+
+/** reader: announce parking, return journal_seq to park on,
+ * journals have to be checked once more before comm_park_journal */
+inline int comm_begin_park_journal(PageCommDoorbell* bell)
+{
+    __atomic_add_fetch(&bell->journal_waiters, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&bell->journal_seq, __ATOMIC_SEQ_CST);
+}
+
+/** reader: sleep until a writer rings after seq was loaded, at most timeoutMicro */
+inline void comm_park_journal(PageCommDoorbell* bell, int seq, int timeoutMicro)
+{
+    comm_futex_wait(&bell->journal_seq, seq, timeoutMicro);
+}
+
+inline void comm_end_park_journal(PageCommDoorbell* bell)
+{
+    __atomic_sub_fetch(&bell->journal_waiters, 1, __ATOMIC_SEQ_CST);
+}
 
 YJJ_NAMESPACE_END
 
@@ -35,8 +35,6 @@ USING_YJJ_NAMESPACE
 
 using json = nlohmann::json;
 
-std::mutex paged_mtx;
-
 #define COMM_FILE KUNGFU_JOURNAL_FOLDER + "PAGE_ENGINE_COMM"
 const int INTERVAL_IN_MILLISEC = 1000000;
 
@@ -48,6 +46,7 @@ void signal_callback(int signum)
 
 bool PageEngine::write(string content, byte msg_type, bool is_last, short source)
 {
+    std::lock_guard<std::mutex> lock(writer_mtx);
     if (writer.get() == nullptr)
         return false;
     writer->write_frame(content.c_str(), content.length() + 1, source, msg_type, is_last, -1);
@@ -56,17 +55,18 @@ bool PageEngine::write(string content, byte msg_type, bool is_last, short source
 
 void PageEngine::acquire_mutex() const
 {
-    paged_mtx.lock();
+    client_mtx.lock();
 }
 
 void PageEngine::release_mutex() const
 {
-    paged_mtx.unlock();
+    client_mtx.unlock();
 }
 
-PageEngine::PageEngine(const string& _base_dir) : base_dir(_base_dir), commBuffer(nullptr), commFile(COMM_FILE), maxIdx(0),
+PageEngine::PageEngine(const string& _base_dir) : userJournals(MAX_COMM_USER_NUMBER, -1), base_dir(_base_dir), commBuffer(nullptr), commFile(COMM_FILE), maxIdx(0),
                                           microsecFreq(INTERVAL_IN_MILLISEC),
-                                          task_running(false), last_switch_nano(0), comm_running(false) {
+                                          task_running(false), last_switch_nano(0), comm_running(false), commWaitMode(PAGED_WAIT_PARK),
+                                          pagePool(new PagePool(KUNGFU_JOURNAL_FOLDER)) {
     for (int s = 1; s < 32; s++)
         signal(s, signal_callback);
 
@@ -76,6 +76,7 @@ PageEngine::PageEngine(const string& _base_dir) : base_dir(_base_dir), commBuffe
     // setup basic tasks
     tasks.clear();
     add_task(PstBasePtr(new PstPidCheck(this))); // pid check is a necessary task.
+    pagePool->setDepth(JOURNAL_PAGE_SIZE, DEFAULT_PAGE_POOL_DEPTH, false);
 
     SPDLOG_INFO("page engine base dir {}", get_kungfu_home());
 }
@@ -94,6 +95,8 @@ void PageEngine::start()
     SPDLOG_INFO("loading page buffer: {}", commFile);
     commBuffer = PageUtil::LoadPageBuffer(commFile, COMM_SIZE, true, true);
     memset(commBuffer, 0, COMM_SIZE);
+    // step 0.5: start filling page pool, so first writers already hit
+    pagePool->start();
     // step 1: start commBuffer checking thread
     comm_running = false;
     commThread = ThreadPtr(new std::thread(boost::bind(&PageEngine::start_comm, this)));
@@ -126,7 +129,10 @@ void PageEngine::stop()
 
     /* write paged end in system journal */
     write("", MSG_TYPE_PAGED_END);
-    writer.reset();
+    {
+        std::lock_guard<std::mutex> lock(writer_mtx);
+        writer.reset();
+    }
 
     /* stop task thread first */
     task_running = false;
@@ -146,6 +152,10 @@ void PageEngine::stop()
     }
     SPDLOG_INFO("(stopComm) done");
 
+    /* drop pooled pages */
+    pagePool->stop();
+    SPDLOG_INFO("(stopPagePool) done");
+
     /* stop socket io thread */
     PageSocketHandler::getInstance()->stop();
     if (socketThread.get() != nullptr)
@@ -164,19 +174,24 @@ void PageEngine::start_task()
     SPDLOG_INFO("(startTasks) (microseconds) {}", microsecFreq);
     while (task_running)
     {
-        acquire_mutex();
-        for (auto item: tasks)
+        // tasks lock what they touch, a slow task never holds up socket or comm thread
+        vector<PstBasePtr> running;
+        {
+            std::lock_guard<std::mutex> lock(task_mtx);
+            for (auto const &item: tasks)
+                running.push_back(item.second);
+        }
+        for (auto const &task: running)
         {
-            item.second->go();
+            task->go();
         }
-        release_mutex();
         std::this_thread::sleep_for(std::chrono::microseconds(microsecFreq));
     }
 }
 
 bool PageEngine::add_task(PstBasePtr task)
 {
-    acquire_mutex();
+    std::lock_guard<std::mutex> lock(task_mtx);
     string name = task->getName();
     bool exist = (tasks.find(name) != tasks.end());
     tasks[name] = task;
@@ -187,17 +202,14 @@ bool PageEngine::add_task(PstBasePtr task)
     {
         SPDLOG_INFO("task {} added", name);
     }
-    release_mutex();
     return !exist;
 }
 
 bool PageEngine::remove_task(PstBasePtr task)
 {
     string name = task->getName();
-    acquire_mutex();
-    bool ret = remove_task_by_name(name);
-    release_mutex();
-    return ret;
+    std::lock_guard<std::mutex> lock(task_mtx);
+    return remove_task_by_name(name);
 }
 
 bool PageEngine::remove_task_by_name(string taskName)
@@ -217,6 +229,13 @@ void PageEngine::start_socket()
 
 int PageEngine::reg_journal(const string& clientName)
 {
+    auto it = clientJournals.find(clientName);
+    if (it == clientJournals.end())
+    {
+        SPDLOG_ERROR("cannot find the client in reg_journal");
+        return -1;
+    }
+
     size_t idx = 0;
     for (; idx < MAX_COMM_USER_NUMBER; idx++)
         if (GET_COMM_MSG(commBuffer, idx)->status == PAGED_COMM_RAW)
@@ -233,24 +252,30 @@ int PageEngine::reg_journal(const string& clientName)
     PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
     msg->status = PAGED_COMM_OCCUPIED;
     msg->last_page_num = 0;
-    auto it = clientJournals.find(clientName);
-    if (it == clientJournals.end())
-    {
-        SPDLOG_ERROR("cannot find the client in reg_journal");
-        return -1;
-    }
     it->second.user_index_vec.push_back(idx);
     SPDLOG_INFO("[RegJournal] (client) {} (idx) {}", clientName, idx);
     return idx;
 }
 
+void PageEngine::unreg_journal(const string& clientName, int idx)
+{
+    auto it = clientJournals.find(clientName);
+    if (it == clientJournals.end())
+        return;
+    vector<int>& indexes = it->second.user_index_vec;
+    indexes.erase(remove(indexes.begin(), indexes.end(), idx), indexes.end());
+    PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
+    msg->status = PAGED_COMM_RAW;
+    SPDLOG_INFO("[UnregJournal] (client) {} (idx) {}", clientName, idx);
+}
+
 bool PageEngine::reg_client(string& _commFile, int& fileSize, int& hashCode, const string& clientName, int pid, bool isWriter)
 {
     SPDLOG_INFO("[RegClient] (name) {} (writer?) {}", clientName, isWriter);
     if (clientJournals.find(clientName) != clientJournals.end())
         return false;
 
-    map<int, vector<string> >::iterator it = pidClient.find(pid);
+    auto it = pidClient.find(pid);
     if (it == pidClient.end())
         pidClient[pid] = {clientName};
     else
@@ -273,117 +298,99 @@ bool PageEngine::reg_client(string& _commFile, int& fileSize, int& hashCode, con
     return true;
 }
 
-void PageEngine::release_page(const PageCommMsg& msg)
+int PageEngine::get_journal_id(int idx, const PageCommMsg& msg)
 {
-    SPDLOG_INFO("[RmPage] (folder) {} (jname) {} (pNum) {} (lpNum) {}", msg.folder, msg.name, msg.page_num, msg.last_page_num);
-
-    map<PageCommMsg, int>::iterator count_it;
-    if (msg.is_writer)
+    int journalId = userJournals[idx];
+    if (journalId < 0)
     {
-        count_it = fileWriterCounts.find(msg);
-        if (count_it == fileWriterCounts.end())
+        string key = string(msg.folder) + "/" + msg.name;
+        auto it = journalIds.find(key);
+        if (it == journalIds.end())
         {
-            SPDLOG_ERROR("cannot find key at fileWriterCounts in exit_client");
-            return;
+            journalId = journals.size();
+            journals.push_back({msg.folder, msg.name});
+            journalIds[key] = journalId;
         }
+        else
+            journalId = it->second;
+        userJournals[idx] = journalId;
     }
-    else
+    return journalId;
+}
+
+void PageEngine::release_page(int journalId, short pageNum, bool isWriter)
+{
+    const PageJournalInfo& journal = journals[journalId];
+    SPDLOG_INFO("[RmPage] (folder) {} (jname) {} (pNum) {}", journal.folder, journal.name, pageNum);
+
+    auto page_it = pages.find(page_key(journalId, pageNum));
+    if (page_it == pages.end())
     {
-        count_it = fileReaderCounts.find(msg);
-        if (count_it == fileReaderCounts.end())
-        {
-            SPDLOG_ERROR("cannot find key at fileReaderCounts in exit_client");
-            return;
-        }
+        SPDLOG_ERROR("cannot find page in release_page");
+        return;
     }
-    count_it->second --;
-    if (count_it->second == 0)
+    PageBufferInfo& page = page_it->second;
+    int& count = isWriter ? page.writer_num : page.reader_num;
+    if (count <= 0)
     {
-        bool otherSideEmpty = false;
-        if (msg.is_writer)
-        {
-            fileWriterCounts.erase(count_it);
-            otherSideEmpty = fileReaderCounts.find(msg) == fileReaderCounts.end();
-        }
-        else
-        {
-            fileReaderCounts.erase(count_it);
-            otherSideEmpty = fileWriterCounts.find(msg) == fileWriterCounts.end();
-        }
-        if (otherSideEmpty)
-        {
-            string path = PageUtil::GenPageFullPath(msg.folder, msg.name, msg.page_num);
-            auto file_it = fileAddrs.find(path);
-            if (file_it != fileAddrs.end())
-            {
-                void* addr = file_it->second;
-                SPDLOG_INFO("[AddrRm] (path) {} (addr) {}", path, addr);
-                PageUtil::ReleasePageBuffer(addr, JOURNAL_PAGE_SIZE, true);
-                fileAddrs.erase(file_it);
-            }
-        }
+        SPDLOG_ERROR("cannot find {} of page in release_page", isWriter ? "writer" : "reader");
+        return;
+    }
+    count --;
+    if (page.writer_num == 0 && page.reader_num == 0)
+    {
+        SPDLOG_INFO("[AddrRm] (path) {} (addr) {} (size) {}", page.path, page.addr, page.size);
+        PageUtil::ReleasePageBuffer(page.addr, page.size, true);
+        pages.erase(page_it);
     }
 }
 
-byte PageEngine::initiate_page(const PageCommMsg& msg)
+byte PageEngine::initiate_page(int journalId, const PageCommMsg& msg)
 {
     SPDLOG_INFO("[InPage] (folder) {} (jname) {} (pNum) {} (lpNum) {} (writer?) {}", msg.folder, msg.name, msg.page_num, msg.last_page_num, msg.is_writer);
 
-    string path = PageUtil::GenPageFullPath(msg.folder, msg.name, msg.page_num);
-    if (fileAddrs.find(path) == fileAddrs.end())
+    int64_t key = page_key(journalId, msg.page_num);
+    auto page_it = pages.find(key);
+    if (page_it == pages.end())
     {
+        string path = PageUtil::GenPageFullPath(msg.folder, msg.name, msg.page_num);
         void* buffer = nullptr;
+        int size = PageUtil::IsValidPageSize(msg.page_size) ? msg.page_size : JOURNAL_PAGE_SIZE;
         if (!PageUtil::FileExists(path))
         {   // this file is not exist....
             if (!msg.is_writer)
                 return PAGED_COMM_NON_EXIST;
             else
             {
-                auto tempPageIter = fileAddrs.find(TEMP_PAGE);
-                if (tempPageIter != fileAddrs.end())
+                buffer = pagePool->acquire(path, size);
+                if (buffer == nullptr)
                 {
-                    int ret = rename((TEMP_PAGE).c_str(), path.c_str());
-                    if (ret < 0)
-                    {
-                        SPDLOG_ERROR("[InPage] ERROR: Cannot rename from {} to {}", TEMP_PAGE, path);
-                        return PAGED_COMM_CANNOT_RENAME_FROM_TEMP;
-                    }
-                    else
-                    {
-                        SPDLOG_INFO("[InPage] TEMP_POOL: {} to {}", TEMP_PAGE, path);
-                        buffer = tempPageIter->second;
-                        fileAddrs.erase(tempPageIter);
-                    }
+                    SPDLOG_WARN("[InPage] page pool missed, create {} in place", path);
+                    buffer = PageUtil::LoadPageBuffer(path, size, true, true);
                 }
-                if (buffer == nullptr)
-                    buffer = PageUtil::LoadPageBuffer(path, JOURNAL_PAGE_SIZE, true, true);
             }
         }
         else
         {   // exist file but not loaded, map and lock immediately.
-            buffer = PageUtil::LoadPageBuffer(path, JOURNAL_PAGE_SIZE, false, true);
+            size = PageUtil::GetPageSize(path, size);
+            buffer = PageUtil::LoadPageBuffer(path, size, false, true);
+            if (buffer == nullptr) // archived by compactor just now
+                return PAGED_COMM_NON_EXIST;
         }
 
-        SPDLOG_INFO("[AddrAdd] (path) {} (addr) {}", path, buffer);
-        fileAddrs[path] = buffer;
+        SPDLOG_INFO("[AddrAdd] (path) {} (addr) {} (size) {}", path, buffer, size);
+        page_it = pages.emplace(key, PageBufferInfo{buffer, size, journalId, msg.page_num, 0, 0, path}).first;
     }
 
+    PageBufferInfo& page = page_it->second;
     if (msg.is_writer)
     {
-        auto count_it = fileWriterCounts.find(msg);
-        if (count_it == fileWriterCounts.end())
-            fileWriterCounts[msg] = 1;
-        else
+        if (page.writer_num > 0)
             return PAGED_COMM_MORE_THAN_ONE_WRITE;
+        page.writer_num = 1;
     }
     else
-    {
-        auto count_it = fileReaderCounts.find(msg);
-        if (count_it == fileReaderCounts.end())
-            fileReaderCounts[msg] = 1;
-        else
-            count_it->second ++;
-    }
+        page.reader_num ++;
     return PAGED_COMM_ALLOCATED;
 }
 
@@ -391,7 +398,7 @@ bool PageEngine::login_td(const string& clientName, short source)
 {
     SPDLOG_INFO("[TELogin] (name) {} (source) {}", clientName, source);
 
-    map<string, PageClientInfo>::iterator it = clientJournals.find(clientName);
+    auto it = clientJournals.find(clientName);
     if (it == clientJournals.end())
     {
         SPDLOG_ERROR("[ERROR][TELogin] client {} does not exist!", clientName);
@@ -410,7 +417,7 @@ bool PageEngine::login_td(const string& clientName, short source)
     j_request["rid_s"] = info.rid_start;
     j_request["rid_e"] = info.rid_end;
     j_request["pid"] = info.pid;
-    j_request["last_switch_nano"] = last_switch_nano;
+    j_request["last_switch_nano"] = last_switch_nano.load();
     write(j_request.dump(), MSG_TYPE_TRADE_ENGINE_LOGIN, true, source);
     info.trade_engine_vec.push_back(source);
     return true;
@@ -418,7 +425,7 @@ bool PageEngine::login_td(const string& clientName, short source)
 
 void  PageEngine::exit_client(const string& clientName, int hashCode, bool needHashCheck)
 {
-    map<string, PageClientInfo>::iterator it = clientJournals.find(clientName);
+    auto it = clientJournals.find(clientName);
     if (it == clientJournals.end())
         return;
     PageClientInfo& info = it->second;
@@ -437,16 +444,20 @@ void  PageEngine::exit_client(const string& clientName, int hashCode, bool needH
         j_request["rid_s"] = info.rid_start;
         j_request["rid_e"] = info.rid_end;
         j_request["pid"] = info.pid;
-        j_request["last_switch_nano"] = last_switch_nano;
+        j_request["last_switch_nano"] = last_switch_nano.load();
         write(j_request.dump(), MSG_TYPE_STRATEGY_END);
     }
 
-    for (auto idx: info.user_index_vec)
     {
-        PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
-        if (msg->status == PAGED_COMM_ALLOCATED)
-            release_page(*msg);
-        msg->status = PAGED_COMM_RAW;
+        std::lock_guard<std::mutex> lock(page_mtx);
+        for (auto idx: info.user_index_vec)
+        {
+            PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
+            if (msg->status == PAGED_COMM_ALLOCATED && userJournals[idx] >= 0)
+                release_page(userJournals[idx], msg->page_num, msg->is_writer);
+            userJournals[idx] = -1;
+            msg->status = PAGED_COMM_RAW;
+        }
     }
     SPDLOG_INFO("[RmClient] (name) {} (start) {} (end) {}", clientName, info.reg_nano, getNanoTime());
     vector<string>& clients = pidClient[info.pid];
@@ -456,9 +467,41 @@ void  PageEngine::exit_client(const string& clientName, int hashCode, bool needH
     clientJournals.erase(it);
 }
 
+vector<int> PageEngine::get_client_pids() const
+{
+    std::lock_guard<std::mutex> lock(client_mtx);
+    vector<int> pids;
+    for (auto const &item: pidClient)
+        pids.push_back(item.first);
+    return pids;
+}
+
+void PageEngine::exit_pid(int pid)
+{
+    std::lock_guard<std::mutex> lock(client_mtx);
+    auto it = pidClient.find(pid);
+    if (it == pidClient.end())
+        return;
+    vector<string> names = it->second; // exit_client erases from pidClient
+    for (auto const &name: names)
+    {
+        SPDLOG_WARN("process {} with pid {} exited", name, pid);
+        exit_client(name, 0, false);
+    }
+}
+
+vector<string> PageEngine::get_page_paths() const
+{
+    std::lock_guard<std::mutex> lock(page_mtx);
+    vector<string> paths;
+    for (auto const &item: pages)
+        paths.push_back(item.second.path);
+    return paths;
+}
+
 IntPair PageEngine::register_strategy(const string& strategyName)
 {
-    map<string, PageClientInfo>::iterator it = clientJournals.find(strategyName);
+    auto it = clientJournals.find(strategyName);
     if (it == clientJournals.end())
     {
         SPDLOG_ERROR("[ERROR] cannot find client {} ", strategyName);
@@ -479,7 +522,7 @@ IntPair PageEngine::register_strategy(const string& strategyName)
     j_request["rid_s"] = info.rid_start;
     j_request["rid_e"] = info.rid_end;
     j_request["pid"] = info.pid;
-    j_request["last_switch_nano"] = last_switch_nano;
+    j_request["last_switch_nano"] = last_switch_nano.load();
     write(j_request.dump(), MSG_TYPE_STRATEGY_START);
     SPDLOG_INFO("[RegStrategy] (name) {} (rid) {} - {}", strategyName, info.rid_start, info.rid_end);
     return std::make_pair(info.rid_start, info.rid_end);
@@ -496,28 +539,43 @@ bool PageEngine::sub_md(const vector<string>& tickers, short source, short msg_t
 
 void PageEngine::start_comm()
 {
+    PageCommDoorbell* bell = GET_COMM_DOORBELL(commBuffer);
     comm_running = true;
-    for (size_t idx = 0; comm_running; idx = (idx + 1) % (maxIdx + 1))
+    while (comm_running)
     {
-        PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
-        if (msg->status == PAGED_COMM_REQUESTING)
+        // load seq before scanning, so a request made during the scan never gets parked on
+        int seq = __atomic_load_n(&bell->request_seq, __ATOMIC_ACQUIRE);
+        bool handled = false;
+        for (size_t idx = 0; idx <= maxIdx; idx++)
         {
-            acquire_mutex();
-            SPDLOG_INFO("[Demand] (idx) {}", idx);
-            if (msg->last_page_num > 0 && msg->last_page_num != msg->page_num)
+            PageCommMsg* msg = GET_COMM_MSG(commBuffer, idx);
+            if (msg->status == PAGED_COMM_REQUESTING)
             {
-                short curPage = msg->page_num;
-                msg->page_num = msg->last_page_num;
-                release_page(*msg);
-                msg->page_num = curPage;
+                handle_request(idx, msg);
+                comm_notify_reply(bell, idx);
+                handled = true;
             }
-            msg->status = initiate_page(*msg);
-            msg->last_page_num = msg->page_num;
-            release_mutex();
         }
+        if (!handled)
+            comm_wait_request(bell, seq, commWaitMode);
     }
 }
 
+void PageEngine::handle_request(int idx, PageCommMsg* msg)
+{
+    std::lock_guard<std::mutex> lock(page_mtx);
+    if (msg->status != PAGED_COMM_REQUESTING)
+        return; // client exited in between
+    SPDLOG_INFO("[Demand] (idx) {}", idx);
+    int journalId = get_journal_id(idx, *msg);
+    if (msg->last_page_num > 0 && msg->last_page_num != msg->page_num)
+        release_page(journalId, msg->last_page_num, msg->is_writer);
+    byte status = initiate_page(journalId, *msg);
+    // a failed request holds no page, nothing to release on the next one
+    msg->last_page_num = status == PAGED_COMM_ALLOCATED ? msg->page_num : 0;
+    msg->status = status;
+}
+
 bool PageEngine::switch_trading_day()
 {
     return write("", MSG_TYPE_SWITCH_TRADING_DAY);
@@ -525,17 +583,23 @@ bool PageEngine::switch_trading_day()
 
 py::dict PageEngine::getStatus() const
 {
-    acquire_mutex();
     py::dict res;
-    res["Client"] = getClientInfo();
-    res["Pid"] = getPidInfo();
-    res["Task"] = getTaskInfo();
-    res["User"] = getUserInfo();
-    res["File"] = py::dict();
-    res["File"]["Read"] = getFileReaderInfo();
-    res["File"]["Write"] = getFileWriterInfo();
-    res["File"]["Locking"] = getLockingFiles();
-    release_mutex();
+    {
+        std::lock_guard<std::mutex> client_lock(client_mtx);
+        std::lock_guard<std::mutex> page_lock(page_mtx);
+        res["Client"] = getClientInfo();
+        res["Pid"] = getPidInfo();
+        res["User"] = getUserInfo();
+        res["File"] = py::dict();
+        res["File"]["Read"] = getFileReaderInfo();
+        res["File"]["Write"] = getFileWriterInfo();
+        res["File"]["Locking"] = getLockingFiles();
+    }
+    {
+        std::lock_guard<std::mutex> task_lock(task_mtx);
+        res["Task"] = getTaskInfo();
+    }
+    res["Pool"] = getPoolInfo();
     return res;
 }
 
@@ -606,11 +670,14 @@ py::dict PageEngine::getPidInfo() const
 py::dict PageEngine::getFileReaderInfo() const
 {
     py::dict info;
-    for (auto const &item: fileReaderCounts)
+    for (auto const &item: pages)
     {
-        const PageCommMsg& msg = item.first;
-        py::tuple key = py::make_tuple(msg.folder, msg.name, msg.page_num, msg.last_page_num, msg.is_writer);
-        info[key] = item.second;
+        const PageBufferInfo& page = item.second;
+        if (page.reader_num == 0)
+            continue;
+        const PageJournalInfo& journal = journals[page.journal_id];
+        py::tuple key = py::make_tuple(journal.folder, journal.name, page.page_num, page.page_num, false);
+        info[key] = page.reader_num;
     }
     return info;
 }
@@ -618,11 +685,14 @@ py::dict PageEngine::getFileReaderInfo() const
 py::dict PageEngine::getFileWriterInfo() const
 {
     py::dict info;
-    for (auto const &item: fileWriterCounts)
+    for (auto const &item: pages)
     {
-        const PageCommMsg& msg = item.first;
-        py::tuple key = py::make_tuple(msg.folder, msg.name, msg.page_num, msg.last_page_num, msg.is_writer);
-        info[key] = item.second;
+        const PageBufferInfo& page = item.second;
+        if (page.writer_num == 0)
+            continue;
+        const PageJournalInfo& journal = journals[page.journal_id];
+        py::tuple key = py::make_tuple(journal.folder, journal.name, page.page_num, page.page_num, true);
+        info[key] = page.writer_num;
     }
     return info;
 }
@@ -630,11 +700,35 @@ py::dict PageEngine::getFileWriterInfo() const
 py::list PageEngine::getLockingFiles() const
 {
     py::list files;
-    for (auto const &iter: fileAddrs)
-        files.append(iter.first);
+    for (auto const &item: pages)
+        files.append(item.second.path);
     return files;
 }
 
+py::dict PageEngine::getPoolInfo() const
+{
+    py::dict info;
+    for (auto const &item: pagePool->getStats())
+    {
+        const PagePoolStat& stat = item.second;
+        py::dict pool;
+        pool["capacity"] = stat.capacity;
+        pool["depth"] = stat.depth;
+        pool["huge_page"] = stat.huge_page;
+        pool["hits"] = stat.hits;
+        pool["misses"] = stat.misses;
+        pool["refills"] = stat.refills;
+        info[py::cast(item.first)] = pool;
+    }
+    info["unpooled"] = pagePool->getUnpooledCount();
+    return info;
+}
+
+void PageEngine::set_page_pool(int pageSize, int depth, bool hugePage)
+{
+    pagePool->setDepth(pageSize, depth, hugePage);
+}
+
 string getJournalFolder()
 {
     return PAGED_JOURNAL_FOLDER;
@@ -656,16 +750,20 @@ PYBIND11_MODULE(paged, m)
     .def("removeTask", &PageEngine::remove_task)
     .def("status", &PageEngine::getStatus)
     .def("write", &PageEngine::write, py::arg("content"), py::arg("msg_type"), py::arg("is_last")=true, py::arg("source")=0)
-    .def("switch_trading_day", &PageEngine::switch_trading_day);
+    .def("switch_trading_day", &PageEngine::switch_trading_day)
+    .def("setCommWaitMode", [](PageEngine& pe, int mode) { pe.set_comm_wait_mode((PagedWaitMode)mode); }, py::arg("mode")=(int)PAGED_WAIT_PARK)
+    .def("setPagePool", &PageEngine::set_page_pool, py::arg("page_size"), py::arg("depth")=DEFAULT_PAGE_POOL_DEPTH, py::arg("huge_page")=false);
 
     // TODO boost::noncopyable ??
     py::class_<PstBase, boost::shared_ptr<PstBase>>(m, "PstBase");
     py::class_<PstTimeTick, PstBase, boost::shared_ptr<PstTimeTick> >(m, "TimeTick").def(py::init<PageEngine* >());
-    py::class_<PstTempPage, PstBase, boost::shared_ptr<PstTempPage> >(m, "TempPage").def(py::init<PageEngine* >());
     py::class_<PstKfController, PstBase, boost::shared_ptr<PstKfController> >(m, "Controller").def(py::init<PageEngine* >())
     .def("set_switch_day_time", &PstKfController::setDaySwitch)
     .def("add_engine_start_time", &PstKfController::addEngineStart)
     .def("add_engine_end_time", &PstKfController::addEngineEnd);
+    py::class_<PstCompactor, PstBase, boost::shared_ptr<PstCompactor> >(m, "Compactor").def(py::init<PageEngine* >())
+    .def("set_min_age", &PstCompactor::setMinAge, py::arg("seconds"))
+    .def("set_interval", &PstCompactor::setInterval, py::arg("seconds"));
 
     m.def("jfolder", &getJournalFolder);
     m.def("jname", &getJournalName);
@@ -27,10 +27,14 @@
 #include "PageCommStruct.h"
 #include "PageSocketHandler.h"
 #include "PageServiceTask.h"
+#include "PagePool.h"
 #include "JournalWriter.h"
 
 #include <utility>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 YJJ_NAMESPACE_START
 
@@ -67,24 +71,71 @@ struct PageClientInfo
     vector<short> trade_engine_vec;
 };
 
+/** page buffer mapped by page engine */
+struct PageBufferInfo
+{
+    /** address of the mapped buffer */
+    void*   addr;
+    /** size of the mapped buffer */
+    int     size;
+    /** interned id of the journal */
+    int     journal_id;
+    /** page number in the journal */
+    short   page_num;
+    /** number of writers on this page */
+    int     writer_num;
+    /** number of readers on this page */
+    int     reader_num;
+    /** full path of the page file */
+    string  path;
+};
+
+/** journal interned by page engine */
+struct PageJournalInfo
+{
+    string  folder;
+    string  name;
+};
+
+/** key of a page in PageEngine::pages */
+inline int64_t page_key(int journalId, short pageNum)
+{
+    return ((int64_t)journalId << 16) | (unsigned short)pageNum;
+}
+
 class PageEngine: public IPageSocketUtil
 {
     friend class PstPidCheck;
     friend class PstTimeTick;
-    friend class PstTempPage;
     friend class PstKfController;
+    friend class PstCompactor;
 private:
-    // internal data structures. be careful on its thread-safety
+    // internal data structures, each group has its own mutex, always locked in this order:
+    // client_mtx -> page_mtx -> writer_mtx, task_mtx is never held with any other
+
+    /** guards client bookkeeping, held by socket thread while serving a request (acquire_mutex) */
+    mutable std::mutex client_mtx;
     /** map: client -> all info (all journal usage) */
-    map<string, PageClientInfo> clientJournals;
+    std::unordered_map<string, PageClientInfo> clientJournals;
     /** map: pid -> client */
-    map<int, vector<string> > pidClient;
-    /** map: file attached with number of writers */
-    map<PageCommMsg, int> fileWriterCounts;
-    /** map: file attached with number of readers */
-    map<PageCommMsg, int> fileReaderCounts;
-    /** map: file to its page buffer */
-    map<string, void*> fileAddrs;
+    std::unordered_map<int, vector<string> > pidClient;
+
+    /** guards page bookkeeping, held by comm thread while allocating */
+    mutable std::mutex page_mtx;
+    /** map: folder + '/' + name -> journal id, ids are never reused */
+    std::unordered_map<string, int> journalIds;
+    /** journal id -> journal */
+    vector<PageJournalInfo> journals;
+    /** comm idx -> journal id, -1 until its first page request */
+    vector<int> userJournals;
+    /** map: page_key -> mapped page with its writers and readers */
+    std::unordered_map<int64_t, PageBufferInfo> pages;
+
+    /** guards system journal writer */
+    mutable std::mutex writer_mtx;
+
+    /** guards tasks, tasks run without it */
+    mutable std::mutex task_mtx;
     /** map: task name to task body */
     map<string, PstBasePtr> tasks;
 
@@ -113,31 +164,45 @@ public:
     bool write(string content, byte msg_type, bool is_last=true, short source=0);
     /** return true if msg is written in system journal */
     bool switch_trading_day();
+    /** keep depth pre-faulted pages of pageSize in pool, depth=0 to disable */
+    void set_page_pool(int pageSize, int depth, bool hugePage);
+    /** set how comm thread waits for requests when idle */
+    void set_comm_wait_mode(PagedWaitMode mode) { commWaitMode = mode; }
     /** get status in python dictionary */
     pybind11::dict  getStatus() const;
 
 public:
     // functions required by IPageSocketUtil
     int     reg_journal(const string& clientName);
+    void    unreg_journal(const string& clientName, int idx);
     IntPair register_strategy(const string& strategyName);
     bool    reg_client(string& commFile, int& fileSize, int& hashCode, const string& clientName, int pid, bool isWriter);
     void    exit_client(const string& clientName, int hashCode, bool needHashCheck);
     bool    sub_md(const vector<string>& tickers, short source, short msgType, bool isLast);
     bool    login_td(const string& clientName, short source);
+    /** client_mtx, held by socket thread */
     void    acquire_mutex() const;
     void    release_mutex() const;
     void    set_last_switch_nano(int64_t nano) { last_switch_nano = nano; }
+    /** snapshot of pids with clients */
+    vector<int> get_client_pids() const;
+    /** exit all clients of the process */
+    void    exit_pid(int pid);
+    /** snapshot of paths of mapped pages */
+    vector<string> get_page_paths() const;
 
 private:
     const string base_dir;
     JournalWriterPtr writer; /**< writer for system journal */
     void*   commBuffer; /**< comm memory */
     string  commFile;   /**< comm file linked to memory */
-    size_t  maxIdx;     /**< max index of current assigned comm block */
+    std::atomic<size_t> maxIdx; /**< max index of current assigned comm block */
     int     microsecFreq;  /**< task frequency in microseconds */
     bool    task_running;  /**< task thread is running */
-    int64_t    last_switch_nano; /**< last switch day nano time */
+    std::atomic<int64_t> last_switch_nano; /**< last switch day nano time */
+    PagePoolPtr pagePool;  /**< pre-faulted pages for writers */
     volatile bool    comm_running;  /**< comm buffer checking thread is running */
+    volatile PagedWaitMode commWaitMode; /**< how comm thread waits when idle */
 
     /** thread for task running */
     ThreadPtr taskThread;
@@ -156,10 +221,14 @@ private:
     void start_task();
 
 private:
-    /** release the page assigned in comm msg */
-    void release_page(const PageCommMsg& msg);
-    /** initialize the page assigned in comm msg */
-    byte initiate_page(const PageCommMsg& msg);
+    /** interned id of journal in comm msg, page_mtx held */
+    int  get_journal_id(int idx, const PageCommMsg& msg);
+    /** release the page of journal, page_mtx held */
+    void release_page(int journalId, short pageNum, bool isWriter);
+    /** initialize the page assigned in comm msg, page_mtx held */
+    byte initiate_page(int journalId, const PageCommMsg& msg);
+    /** answer the page request in comm msg idx */
+    void handle_request(int idx, PageCommMsg* msg);
 
     /** helper functions for getStatus */
     py::dict  getClientInfo() const;
@@ -169,6 +238,7 @@ private:
     py::dict  getFileWriterInfo() const;
     py::list  getLockingFiles() const;
     py::tuple getTaskInfo() const;
+    py::dict  getPoolInfo() const;
 };
 
 YJJ_NAMESPACE_END
@@ -0,0 +1,197 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Page pool for page engine.
+ */
+
+#include "PagePool.h"
+#include "PageUtil.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <boost/filesystem.hpp>
+
+USING_YJJ_NAMESPACE
+
+/** refill thread re-checks pools at least this often */
+const int POOL_REFILL_CHECK_MILLISEC = 1000;
+
+PagePool::PagePool(const string& poolDir): dir(poolDir), unpooled(0), seq(0), running(false) {}
+
+PagePool::~PagePool()
+{
+    stop();
+}
+
+void PagePool::setDepth(int pageSize, int depth, bool hugePage)
+{
+    if (!PageUtil::IsValidPageSize(pageSize))
+        throw std::runtime_error("invalid page size for page pool: " + std::to_string(pageSize));
+    std::unique_lock<std::mutex> lock(mtx);
+    SizedPool& pool = pools[pageSize];
+    pool.stat.capacity = depth > 0 ? depth : 0;
+    pool.stat.huge_page = hugePage;
+    while ((int)pool.pages.size() > pool.stat.capacity)
+    {
+        PooledPage& page = pool.pages.back();
+        PageUtil::ReleasePageBuffer(page.addr, pageSize, true);
+        remove(page.path.c_str());
+        pool.pages.pop_back();
+    }
+    pool.stat.depth = pool.pages.size();
+    SPDLOG_INFO("[PagePool] (size) {} (capacity) {} (huge) {}", pageSize, pool.stat.capacity, hugePage);
+    cond.notify_one();
+}
+
+void PagePool::start()
+{
+    if (running)
+        return;
+    // pages left by a previous run are not tracked by anyone, drop them
+    boost::filesystem::path poolPath(dir);
+    if (boost::filesystem::exists(poolPath))
+    {
+        for (boost::filesystem::directory_iterator it(poolPath), end; it != end; ++it)
+        {
+            string filename = it->path().filename().string();
+            if (filename.compare(0, strlen(POOL_PAGE_PREFIX), POOL_PAGE_PREFIX) == 0 || filename == "TEMP_PAGE")
+            {
+                SPDLOG_INFO("[PagePool] remove stale page {}", it->path().string());
+                boost::filesystem::remove(it->path());
+            }
+        }
+    }
+    running = true;
+    refillThread = std::thread(&PagePool::refill, this);
+}
+
+void PagePool::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!running)
+            return;
+        running = false;
+        cond.notify_one();
+    }
+    if (refillThread.joinable())
+        refillThread.join();
+    std::unique_lock<std::mutex> lock(mtx);
+    for (auto& item: pools)
+    {
+        for (auto& page: item.second.pages)
+        {
+            PageUtil::ReleasePageBuffer(page.addr, item.first, true);
+            remove(page.path.c_str());
+        }
+        item.second.pages.clear();
+        item.second.stat.depth = 0;
+    }
+}
+
+void* PagePool::acquire(const string& path, int pageSize)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    auto it = pools.find(pageSize);
+    if (it == pools.end() || it->second.stat.capacity == 0)
+    {
+        unpooled++;
+        return nullptr;
+    }
+    SizedPool& pool = it->second;
+    if (pool.pages.empty())
+    {
+        pool.stat.misses++;
+        cond.notify_one();
+        return nullptr;
+    }
+    PooledPage page = pool.pages.front();
+    if (rename(page.path.c_str(), path.c_str()) < 0)
+    {
+        SPDLOG_ERROR("[PagePool] cannot rename from {} to {}", page.path, path);
+        pool.stat.misses++;
+        return nullptr;
+    }
+    pool.pages.pop_front();
+    pool.stat.depth = pool.pages.size();
+    pool.stat.hits++;
+    cond.notify_one();
+    return page.addr;
+}
+
+map<int, PagePoolStat> PagePool::getStats() const
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    map<int, PagePoolStat> stats;
+    for (auto const &item: pools)
+        stats[item.first] = item.second.stat;
+    return stats;
+}
+
+long PagePool::getUnpooledCount() const
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    return unpooled;
+}
+
+int PagePool::nextSizeToFill()
+{
+    for (auto const &item: pools)
+        if ((int)item.second.pages.size() < item.second.stat.capacity)
+            return item.first;
+    return 0;
+}
+
+void PagePool::refill()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (running)
+    {
+        int pageSize = nextSizeToFill();
+        if (pageSize == 0)
+        {
+            cond.wait_for(lock, std::chrono::milliseconds(POOL_REFILL_CHECK_MILLISEC));
+            continue;
+        }
+        bool hugePage = pools[pageSize].stat.huge_page;
+        string path = dir + POOL_PAGE_PREFIX + std::to_string(seq++);
+        lock.unlock();
+        // create, stretch and fault in outside of lock, comm thread may acquire meanwhile
+        void* buffer = PageUtil::LoadPageBuffer(path, pageSize, true, true);
+        if (buffer != nullptr)
+            PageUtil::PrefaultPageBuffer(buffer, pageSize, hugePage);
+        lock.lock();
+        if (buffer == nullptr)
+        {
+            SPDLOG_ERROR("[PagePool] cannot create page {}", path);
+            cond.wait_for(lock, std::chrono::milliseconds(POOL_REFILL_CHECK_MILLISEC));
+            continue;
+        }
+        SizedPool& pool = pools[pageSize];
+        if (running && (int)pool.pages.size() < pool.stat.capacity)
+        {
+            pool.pages.push_back({path, buffer});
+            pool.stat.depth = pool.pages.size();
+            pool.stat.refills++;
+        }
+        else
+        {
+            PageUtil::ReleasePageBuffer(buffer, pageSize, true);
+            remove(path.c_str());
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Page pool for page engine.
+ * Keeps pre-created, stretched and pre-faulted page files for each page size,
+ * so a writer rolling over to a new page only costs a rename in comm thread.
+ * Pool is refilled by its own background thread.
+ */
+
+#ifndef YIJINJING_PAGEPOOL_H
+#define YIJINJING_PAGEPOOL_H
+
+#include "YJJ_DECLARE.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+YJJ_NAMESPACE_START
+
+#define POOL_PAGE_PREFIX "POOL_PAGE_"
+/** default number of pages kept ready for each page size */
+const int DEFAULT_PAGE_POOL_DEPTH = 2;
+
+/** pre-faulted page file waiting in pool */
+struct PooledPage
+{
+    /** path of the temp file */
+    string  path;
+    /** address of the mapped buffer */
+    void*   addr;
+};
+
+/** counters of pool for one page size */
+struct PagePoolStat
+{
+    /** pages to keep ready */
+    int     capacity = 0;
+    /** pages ready right now */
+    int     depth = 0;
+    /** true if hugepages are advised */
+    bool    huge_page = false;
+    /** pages taken from pool */
+    long    hits = 0;
+    /** pages created in comm thread because pool was empty */
+    long    misses = 0;
+    /** pages created by refill thread */
+    long    refills = 0;
+};
+
+class PagePool
+{
+public:
+    PagePool(const string& poolDir);
+    ~PagePool();
+
+    /** keep depth pages of pageSize ready, depth=0 to disable */
+    void setDepth(int pageSize, int depth, bool hugePage);
+    /** remove stale pool files and start refill thread */
+    void start();
+    /** stop refill thread and drop all pooled pages */
+    void stop();
+
+    /** take a pooled page of pageSize and move it to path,
+     * return address of the page buffer, nullptr if missed (counted if pageSize is pooled) */
+    void*   acquire(const string& path, int pageSize);
+
+    /** snapshot of all counters, by page size */
+    map<int, PagePoolStat> getStats() const;
+    /** pages of other sizes, never pooled */
+    long    getUnpooledCount() const;
+
+private:
+    struct SizedPool
+    {
+        PagePoolStat stat;
+        std::deque<PooledPage> pages;
+    };
+
+    /** refill thread body */
+    void refill();
+    /** find one pool below capacity, return 0 if all full */
+    int  nextSizeToFill();
+
+    const string dir;
+    map<int, SizedPool> pools;
+    long    unpooled;
+    int     seq;
+    bool    running;
+    mutable std::mutex mtx;
+    std::condition_variable cond;
+    std::thread refillThread;
+};
+
+DECLARE_PTR(PagePool);
+
+YJJ_NAMESPACE_END
+
+#endif //YIJINJING_PAGEPOOL_H
@@ -26,6 +26,8 @@
 #include "PageUtil.h"
 #include "Timer.h"
 #include "Journal.h"
+#include "PageHeader.h"
+#include "PageArchive.h"
 #ifdef ENABLE_ACTIVATION_CODE
 #include "ActivationCode.hpp"
 #endif
@@ -37,51 +39,48 @@
 #include <libproc.h>
 #endif
 
+#include <boost/filesystem.hpp>
+#include <boost/regex.hpp>
+#include <unordered_set>
+
 USING_YJJ_NAMESPACE
 
 PstPidCheck::PstPidCheck(PageEngine *pe): engine(pe) {}
 
 void PstPidCheck::go()
 {
-    int pid;
 #ifdef __APPLE__
     struct proc_taskallinfo ti;
     int nb;
 #endif
-    vector<string> clientsToRemove;
+    // walk processes without holding any lock of engine
+    vector<int> pidsToRemove;
+    for (int pid: engine->get_client_pids())
     {
-        for (auto const &item: engine->pidClient)
-        {
-            pid = item.first;
 #ifdef _WINDOWS
-            HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-            DWORD exitCode = 0;
-            if (GetExitCodeProcess(process, &exitCode) == FALSE)
-            {
-                SPDLOG_CRITICAL("pid check failed {}", pid);
-            }
-            if (exitCode != STILL_ACTIVE)
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+        DWORD exitCode = 0;
+        if (GetExitCodeProcess(process, &exitCode) == FALSE)
+        {
+            SPDLOG_CRITICAL("pid check failed {}", pid);
+        }
+        if (exitCode != STILL_ACTIVE)
 #elif defined __APPLE__
-            nb = proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &ti, sizeof(ti));
-            if (nb == 0)
+        nb = proc_pidinfo(pid, PROC_PIDTASKALLINFO, 0, &ti, sizeof(ti));
+        if (nb == 0)
 #elif defined __linux__
-            struct stat sts;
-            std::stringstream ss;
-            ss << "/proc/" << pid;
-            if (stat(ss.str().c_str(), &sts) == -1 && errno == ENOENT)
+        struct stat sts;
+        std::stringstream ss;
+        ss << "/proc/" << pid;
+        if (stat(ss.str().c_str(), &sts) == -1 && errno == ENOENT)
 #endif
-            {
-                for (auto const &name: item.second)
-                {
-                    SPDLOG_WARN("process {} with pid {} exited", name, pid);
-                    clientsToRemove.push_back(name);
-                }
-            }
+        {
+            pidsToRemove.push_back(pid);
         }
     }
-    for (auto const &name: clientsToRemove)
+    for (int pid: pidsToRemove)
     {
-        engine->exit_client(name, 0, false);
+        engine->exit_pid(pid);
     }
 }
 
@@ -92,22 +91,6 @@ void PstTimeTick::go()
     engine->write("", MSG_TYPE_TIME_TICK);
 }
 
-PstTempPage::PstTempPage(PageEngine *pe): engine(pe) {}
-
-void PstTempPage::go()
-{
-    auto &fileAddrs = engine->fileAddrs;
-    if (fileAddrs.find(TEMP_PAGE) == fileAddrs.end())
-    {
-        SPDLOG_INFO("NEW TEMP PAGE: {}", TEMP_PAGE);
-        void *buffer = PageUtil::LoadPageBuffer(TEMP_PAGE, JOURNAL_PAGE_SIZE, true, true);
-        if (buffer != nullptr)
-        {
-            fileAddrs[TEMP_PAGE] = buffer;
-        }
-    }
-}
-
 PstKfController::PstKfController(PageEngine *pe): engine(pe) {}
 
 int64_t getFirstNano(string& formatTime)
@@ -204,3 +187,122 @@ pybind11::dict PstKfController::getInfo() const
     res["engine_ends"] = engine_ends;
     return res;
 }
+
+PstCompactor::PstCompactor(PageEngine *pe): engine(pe), min_age_nano(COMPACTOR_DEFAULT_MIN_AGE_SEC * NANOSECONDS_PER_SECOND),
+                                            interval_nano(COMPACTOR_DEFAULT_INTERVAL_SEC * NANOSECONDS_PER_SECOND),
+                                            last_scan_nano(0), scanning(false), stopping(false),
+                                            scan_num(0), page_num(0), fail_num(0), page_disk_size(0), archive_size(0), last_scan_millis(0) {}
+
+PstCompactor::~PstCompactor()
+{
+    stopping = true;
+    if (worker.joinable())
+        worker.join();
+}
+
+void PstCompactor::setMinAge(int seconds)
+{
+    min_age_nano = seconds * NANOSECONDS_PER_SECOND;
+}
+
+void PstCompactor::setInterval(int seconds)
+{
+    interval_nano = seconds * NANOSECONDS_PER_SECOND;
+}
+
+void PstCompactor::go()
+{
+    int64_t nano = getNanoTime();
+    if (scanning || nano - last_scan_nano < interval_nano)
+        return;
+    if (worker.joinable())
+        worker.join();
+    last_scan_nano = nano;
+    scanning = true;
+    worker = std::thread([this]() { scan(); scanning = false; });
+}
+
+/** same file may be named with duplicated '/' by clients */
+static string normalizePath(const string& path)
+{
+    string res;
+    for (char c: path)
+        if (c != '/' || res.empty() || res.back() != '/')
+            res.push_back(c);
+    return res;
+}
+
+void PstCompactor::scan()
+{
+    int64_t start = getNanoTime();
+    std::unordered_set<string> mapped;
+    for (auto const &path: engine->get_page_paths())
+        mapped.insert(normalizePath(path));
+
+    boost::regex pattern(JOURNAL_PREFIX + "\\.\\w+\\.[0-9]+\\." + JOURNAL_SUFFIX);
+    // collect first, archiving changes the folders under iteration
+    vector<string> candidates;
+    boost::system::error_code ec;
+    boost::filesystem::recursive_directory_iterator it(KUNGFU_JOURNAL_FOLDER, ec), end;
+    for (; !ec && it != end && !stopping; it.increment(ec))
+    {
+        string filename = it->path().filename().string();
+        string path = it->path().string();
+        if (boost::regex_match(filename, pattern) && mapped.find(normalizePath(path)) == mapped.end())
+            candidates.push_back(path);
+    }
+
+    int pages = 0, fails = 0;
+    int64_t pageDisk = 0, archived = 0;
+    for (auto const &path: candidates)
+    {
+        if (stopping)
+            break;
+        PageHeader header = {};
+        FILE* pfile = fopen(path.c_str(), "rb");
+        if (pfile == nullptr)
+            continue;
+        size_t length = fread(&header, 1, sizeof(PageHeader), pfile);
+        fclose(pfile);
+        // open pages and pages just closed may still be wanted by their writer or readers
+        if (length != sizeof(PageHeader) || header.status != JOURNAL_PAGE_STATUS_INITED
+            || header.close_nano <= 0 || start - header.close_nano < min_age_nano)
+            continue;
+        PageArchiveStat stat = {};
+        if (PageArchive::archivePage(path, path + "." + JOURNAL_ARCHIVE_SUFFIX, stat))
+        {
+            SPDLOG_INFO("[Compact] (path) {} (disk) {} (archive) {} (blocks) {}", path, stat.page_disk_size, stat.archive_size, stat.block_num);
+            pages++;
+            pageDisk += stat.page_disk_size;
+            archived += stat.archive_size;
+        }
+        else
+        {
+            SPDLOG_WARN("[Compact] cannot archive {}", path);
+            fails++;
+        }
+    }
+    std::lock_guard<std::mutex> lock(stat_mtx);
+    scan_num++;
+    page_num += pages;
+    fail_num += fails;
+    page_disk_size += pageDisk;
+    archive_size += archived;
+    last_scan_millis = (getNanoTime() - start) / NANOSECONDS_PER_MILLISECOND;
+}
+
+pybind11::dict PstCompactor::getInfo() const
+{
+    pybind11::dict res;
+    std::lock_guard<std::mutex> lock(stat_mtx);
+    res["scanning"] = scanning.load();
+    res["scans"] = scan_num;
+    res["pages"] = page_num;
+    res["fails"] = fail_num;
+    res["page_disk_size"] = page_disk_size;
+    res["archive_size"] = archive_size;
+    res["last_scan_ms"] = last_scan_millis;
+    res["min_age_sec"] = min_age_nano / NANOSECONDS_PER_SECOND;
+    res["interval_sec"] = interval_nano / NANOSECONDS_PER_SECOND;
+    return res;
+}
@@ -27,6 +27,10 @@
 #include "YJJ_DECLARE.h"
 #include "Log.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <pybind11/pybind11.h>
 PYBIND11_DECLARE_HOLDER_TYPE(T, boost::shared_ptr<T>);
 #include <pybind11/stl.h>
@@ -34,8 +38,6 @@ namespace py = pybind11;
 
 YJJ_NAMESPACE_START
 
-#define TEMP_PAGE KUNGFU_JOURNAL_FOLDER + "TEMP_PAGE"
-
 class PageEngine;
 
 class PstBase
@@ -70,17 +72,6 @@ private:
 };
 DECLARE_PTR(PstTimeTick);
 
-class PstTempPage: public PstBase
-{
-public:
-    PstTempPage(PageEngine* pe);
-    void go();
-    string getName() const { return "TempPage"; }
-private:
-    PageEngine* engine;
-};
-DECLARE_PTR(PstTempPage);
-
 #define CONTROLLER_SWITCH_DAY       1
 #define CONTROLLER_ENGINE_STARTS    2
 #define CONTROLLER_ENGINE_ENDS      3
@@ -102,6 +93,47 @@ private:
 };
 DECLARE_PTR(PstKfController);
 
+/** default age of a closed page before archived */
+#define COMPACTOR_DEFAULT_MIN_AGE_SEC   3600
+/** default interval between scans of journal folder */
+#define COMPACTOR_DEFAULT_INTERVAL_SEC  600
+
+/**
+ * archives closed pages under journal folder into compressed archives (PageArchive),
+ * scanning in its own thread so the task thread is never held by disk io.
+ * pages mapped by engine or closed less than min age ago are left as they are.
+ */
+class PstCompactor: public PstBase
+{
+public:
+    PstCompactor(PageEngine* pe);
+    ~PstCompactor();
+    void go();
+    string getName() const { return "Compactor"; }
+    pybind11::dict getInfo() const;
+    void setMinAge(int seconds);
+    void setInterval(int seconds);
+private:
+    /** one pass over journal folder, in worker thread */
+    void scan();
+    PageEngine* engine;
+    std::atomic<int64_t> min_age_nano;
+    std::atomic<int64_t> interval_nano;
+    int64_t last_scan_nano;
+    std::thread worker;
+    std::atomic<bool> scanning;
+    std::atomic<bool> stopping;
+    /** guards stats below */
+    mutable std::mutex stat_mtx;
+    int     scan_num;
+    int     page_num;
+    int     fail_num;
+    int64_t page_disk_size;
+    int64_t archive_size;
+    int64_t last_scan_millis;
+};
+DECLARE_PTR(PstCompactor);
+
 YJJ_NAMESPACE_END
 
 #endif //YIJINJING_PAGESERVICETASK_H
@@ -32,19 +32,59 @@ USING_YJJ_NAMESPACE
 
 using namespace boost::asio;
 
-boost::array<char, SOCKET_MESSAGE_MAX_LENGTH> _data;
-
 #ifdef _WINDOWS
+typedef ip::tcp::socket PagedSocket;
 boost::shared_ptr<ip::tcp::acceptor> _acceptor;
-boost::shared_ptr<ip::tcp::socket> _socket;
 #else
+typedef local::stream_protocol::socket PagedSocket;
 boost::shared_ptr<boost::asio::local::stream_protocol::acceptor> _acceptor;
-boost::shared_ptr<local::stream_protocol::socket> _socket;
 #endif // _WINDOWS
 
 boost::shared_ptr<io_service> _io;
 boost::shared_ptr<PageSocketHandler> PageSocketHandler::m_ptr = boost::shared_ptr<PageSocketHandler>(nullptr);
 
+YJJ_NAMESPACE_START
+
+/**
+ * one client connection,
+ * reads a whole message, processes it under util's mutex, writes the response back and reads the next one,
+ * until the client closes the connection
+ */
+class PageSocketSession: public boost::enable_shared_from_this<PageSocketSession>
+{
+private:
+    PagedSocket socket;
+    boost::array<char, SOCKET_MESSAGE_MAX_LENGTH> data;
+    PageSocketHandler* handler;
+public:
+    PageSocketSession(io_service& io, PageSocketHandler* handler): socket(io), handler(handler) {}
+
+    PagedSocket& get_socket() { return socket; }
+
+    void start_read()
+    {
+        async_read(socket, buffer(data), boost::bind(&PageSocketSession::handle_read, shared_from_this(), boost::asio::placeholders::error));
+    }
+
+    void handle_read(const boost::system::error_code& error)
+    {
+        if (error)
+            return; // closed by client, session is released with the last handler
+        handler->util->acquire_mutex();
+        handler->process_msg(&data[0]);
+        handler->util->release_mutex();
+        async_write(socket, buffer(data), boost::bind(&PageSocketSession::handle_write, shared_from_this(), boost::asio::placeholders::error));
+    }
+
+    void handle_write(const boost::system::error_code& error)
+    {
+        if (!error)
+            start_read();
+    }
+};
+
+YJJ_NAMESPACE_END
+
 PageSocketHandler::PageSocketHandler(): io_running(false)
 {}
 
@@ -75,13 +115,11 @@ void PageSocketHandler::run(IPageSocketUtil* _util)
     _acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
     _acceptor->bind(endpoint);
     _acceptor->listen();
-    _socket.reset(new ip::tcp::socket(*_io));
 #else
     _acceptor.reset(new local::stream_protocol::acceptor(*_io, local::stream_protocol::endpoint(PAGED_SOCKET_FILE)));
-    _socket.reset(new local::stream_protocol::socket(*_io));
 #endif // _WINDOWS
 
-    _acceptor->async_accept(*_socket, boost::bind(&PageSocketHandler::handle_accept, this));
+    start_accept();
     io_running = true;
     _io->run();
 }
@@ -95,30 +133,29 @@ void PageSocketHandler::stop()
 {
     if (_io.get() != nullptr)
         _io->stop();
-    if (_socket.get() != nullptr)
-        _socket->close();
     if (_acceptor.get() != nullptr)
         _acceptor->close();
     io_running = false;
 }
 
-void PageSocketHandler::handle_accept()
+void PageSocketHandler::start_accept()
 {
-    _socket->read_some(buffer(_data));
-    util->acquire_mutex();
-    process_msg();
-    util->release_mutex();
-#ifdef _WINDOWS
-    _socket.reset(new ip::tcp::socket(*_io));
-#else
-    _socket.reset(new local::stream_protocol::socket(*_io));
-#endif // _WINDOWS
-    _acceptor->async_accept(*_socket, boost::bind(&PageSocketHandler::handle_accept, this));
+    boost::shared_ptr<PageSocketSession> session = boost::make_shared<PageSocketSession>(*_io, this);
+    _acceptor->async_accept(session->get_socket(), boost::bind(&PageSocketHandler::handle_accept, this, session, boost::asio::placeholders::error));
 }
 
-void PageSocketHandler::process_msg()
+void PageSocketHandler::handle_accept(boost::shared_ptr<PageSocketSession> session, const boost::system::error_code& error)
 {
-    PagedSocketRequest* req = (PagedSocketRequest*)&_data[0];
+    if (error == boost::asio::error::operation_aborted)
+        return; // acceptor closed
+    if (!error)
+        session->start_read();
+    start_accept();
+}
+
+void PageSocketHandler::process_msg(char* data)
+{
+    PagedSocketRequest* req = (PagedSocketRequest*)&data[0];
     byte req_type = req->type;
     SPDLOG_INFO("[socket] (status) ", req_type);
 
@@ -129,13 +166,13 @@ void PageSocketHandler::process_msg()
             json timer;
             timer["secDiff"] = getSecDiff();
             timer["nano"] = getNanoTime();
-            strcpy(&_data[0], timer.dump().c_str());
+            strcpy(&data[0], timer.dump().c_str());
             break;
         }
         case PAGED_SOCKET_CONNECTION_TEST:
         {
             string greetings = "Hello, world!";
-            strcpy(&_data[0], greetings.c_str());
+            strcpy(&data[0], greetings.c_str());
             break;
         }
         case PAGED_SOCKET_JOURNAL_REGISTER:
@@ -145,7 +182,30 @@ void PageSocketHandler::process_msg()
             rsp.type = req_type;
             rsp.success = idx >= 0;
             rsp.comm_idx = idx;
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
+            break;
+        }
+        case PAGED_SOCKET_JOURNAL_REGISTER_BATCH:
+        {
+            int journal_num = std::min((int)req->journal_num, SOCKET_JOURNAL_BATCH_MAX_NUM);
+            PagedSocketRspJournalBatch rsp = {};
+            rsp.type = req_type;
+            for (int i = 0; i < journal_num; i++)
+            {
+                int idx = util->reg_journal(req->name);
+                if (idx < 0)
+                    break;
+                rsp.comm_idx[rsp.journal_num++] = idx;
+            }
+            rsp.success = journal_num > 0 && rsp.journal_num == req->journal_num;
+            // all or nothing, client never learns of the indexes of a failed batch
+            if (!rsp.success)
+            {
+                for (int i = 0; i < rsp.journal_num; i++)
+                    util->unreg_journal(req->name, rsp.comm_idx[i]);
+                rsp.journal_num = 0;
+            }
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
         case PAGED_SOCKET_STRATEGY_REGISTER:
@@ -156,7 +216,7 @@ void PageSocketHandler::process_msg()
             rsp.success = rid_pair.first < rid_pair.second && rid_pair.first > 0;
             rsp.rid_start = rid_pair.first;
             rsp.rid_end = rid_pair.second;
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
         case PAGED_SOCKET_READER_REGISTER:
@@ -172,7 +232,7 @@ void PageSocketHandler::process_msg()
             rsp.file_size = file_size;
             rsp.hash_code = has_code;
             memcpy(rsp.comm_file, comm_file.c_str(), comm_file.length() + 1);
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
         case PAGED_SOCKET_CLIENT_EXIT:
@@ -181,20 +241,20 @@ void PageSocketHandler::process_msg()
             PagedSocketResponse rsp = {};
             rsp.type = req_type;
             rsp.success = true;
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
         case PAGED_SOCKET_SUBSCRIBE:
         case PAGED_SOCKET_SUBSCRIBE_TBC:
         {
-            short source = _data[1];
-            short msg_type = _data[2];
+            short source = data[1];
+            short msg_type = data[2];
             vector<string> tickers;
             int pos = 3;
             string cur;
             while (pos < (int)SOCKET_MESSAGE_MAX_LENGTH - 1)
             {
-                cur = string(&_data[pos]);
+                cur = string(&data[pos]);
                 if (cur.length() > 0)
                 {
                     tickers.push_back(cur);
@@ -207,7 +267,7 @@ void PageSocketHandler::process_msg()
             PagedSocketResponse rsp = {};
             rsp.type = req_type;
             rsp.success = ret;
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
         case PAGED_SOCKET_TD_LOGIN:
@@ -216,9 +276,8 @@ void PageSocketHandler::process_msg()
             PagedSocketResponse rsp = {};
             rsp.type = req_type;
             rsp.success = ret;
-            memcpy(&_data[0], &rsp, sizeof(rsp));
+            memcpy(&data[0], &rsp, sizeof(rsp));
             break;
         }
     }
-    write(*_socket, buffer(_data));
 }
\ No newline at end of file
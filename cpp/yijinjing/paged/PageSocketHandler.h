@@ -28,17 +28,22 @@
 #include "Log.h"
 #include "PageSocketStruct.h"
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/system/error_code.hpp>
 
 YJJ_NAMESPACE_START
 
 using json = nlohmann::json;
 
+class PageSocketSession;
+
 /** utilities for socket usage */
 class IPageSocketUtil
 {
 public:
     /** return journal index in comm file */
     virtual int     reg_journal(const string& clientName) = 0;
+    /** give back a comm index from reg_journal whose page was never requested */
+    virtual void    unreg_journal(const string& clientName, int idx) = 0;
     /** return (rid_start, rid_end) */
     virtual IntPair register_strategy(const string& strategyName) = 0;
     /** return true if this client exists, and fill in commfile, size of commfile, hash code of this client */
@@ -57,9 +62,14 @@ public:
     virtual void    release_mutex() const = 0;
 };
 
-/** socket handler for page engine */
+/**
+ * socket handler for page engine,
+ * every client connection is a session kept open and served asynchronously,
+ * so a client sends any number of requests over one connection
+ */
 class PageSocketHandler: public boost::enable_shared_from_this<PageSocketHandler>
 {
+    friend class PageSocketSession;
 private:
     /** flag for io running */
     bool io_running;
@@ -68,10 +78,12 @@ private:
     /** singleton */
     static boost::shared_ptr<PageSocketHandler> m_ptr;
 private:
-    /** callback when accept new msg*/
-    void handle_accept();
-    /** minor unit for msg processing */
-    void process_msg();
+    /** start accepting next connection */
+    void start_accept();
+    /** callback when accept new connection */
+    void handle_accept(boost::shared_ptr<PageSocketSession> session, const boost::system::error_code& error);
+    /** minor unit for msg processing, response is written back to data */
+    void process_msg(char* data);
     /** private constructor for singleton */
     PageSocketHandler();
 public:
@@ -31,6 +31,7 @@ YJJ_NAMESPACE_START
 
 #define SOCKET_MESSAGE_MAX_LENGTH       500 /**< max length of a socket buffer */
 #define SOCKET_ERROR_MAX_LENGTH         100 /**< max length of error msg for socket */
+#define SOCKET_JOURNAL_BATCH_MAX_NUM    64  /**< max number of journals registered by one batch message */
 
 //////////////////////////////////////////
 /// (byte) PagedSocketTypeConstants
@@ -42,6 +43,7 @@ YJJ_NAMESPACE_START
 #define PAGED_SOCKET_JOURNAL_REGISTER   11 /**< register journal */
 #define PAGED_SOCKET_READER_REGISTER    12 /**< register client (reader) */
 #define PAGED_SOCKET_WRITER_REGISTER    13 /**< register client (writer) */
+#define PAGED_SOCKET_JOURNAL_REGISTER_BATCH 14 /**< register journal_num journals in one message */
 #define PAGED_SOCKET_CLIENT_EXIT        19 /**< exit a client */
 // subscribe 20 ~ 29
 #define PAGED_SOCKET_SUBSCRIBE          20 /**< subscribe market data */
@@ -67,6 +69,8 @@ struct PagedSocketRequest
     int     hash_code;
     /** source id (only take effect when login trade engine) */
     short   source;
+    /** number of journals (only take effect when registering journals in batch) */
+    short   journal_num;
 #ifndef _WIN32
 } __attribute__((packed));
 #else
@@ -105,6 +109,14 @@ struct PagedSocketRspJournal: public PagedSocketResponse
     int     comm_idx;
 };
 
+struct PagedSocketRspJournalBatch: public PagedSocketResponse
+{
+    /** number of journals registered, comm_idx is filled in order of registration */
+    int     journal_num;
+    /** the indices in the comm_file */
+    int     comm_idx[SOCKET_JOURNAL_BATCH_MAX_NUM];
+};
+
 struct PagedSocketRspStrategy: public PagedSocketResponse
 {
     /** start of request id */
@@ -113,6 +125,8 @@ struct PagedSocketRspStrategy: public PagedSocketResponse
     int     rid_end;
 };
 
+static_assert(sizeof(PagedSocketRspJournalBatch) <= SOCKET_MESSAGE_MAX_LENGTH, "batch response has to fit in one socket message");
+
 YJJ_NAMESPACE_END
 
 #endif //YIJINJING_PAGESOCKETSTRUCT_H
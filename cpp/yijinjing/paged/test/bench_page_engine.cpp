@@ -0,0 +1,192 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * PageEngine stress benchmark.
+ * a PageEngine runs in this process under a temporary KF_HOME, with a housekeeping task
+ * that takes task_millisec every 100ms, as PstPidCheck does with many processes to check.
+ * client_num clients register one journal each, then threads roll their pages round robin
+ * (1MB pages, page_num pages per client) while the status is polled, then all clients exit.
+ * report page request round trip and check that every page is released in the end.
+ * usage: bench_page_engine [client_num] [page_num] [thread_num] [task_millisec]
+ */
+
+#include "PageEngine.h"
+#include "PageProvider.h"
+#include "Page.h"
+
+#include <boost/filesystem.hpp>
+#include <pybind11/embed.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+USING_YJJ_NAMESPACE
+
+#define BENCH_PAGE_SIZE MIN_JOURNAL_PAGE_SIZE
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** housekeeping which takes a while */
+class PstBenchSlow: public PstBase
+{
+public:
+    PstBenchSlow(int millisec): millisec(millisec), runs(0) {}
+    void go()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(millisec));
+        runs++;
+    }
+    string getName() const { return "BenchSlow"; }
+    int millisec;
+    std::atomic<int> runs;
+};
+
+struct BenchClient
+{
+    ClientPageProvider* provider;
+    string name;
+    int idx;
+    PagePtr page;
+};
+
+int main(int argc, char** argv)
+{
+    int clientNum = (argc > 1) ? atoi(argv[1]) : 200;
+    int pageNum = (argc > 2) ? atoi(argv[2]) : 5;
+    int threadNum = (argc > 3) ? atoi(argv[3]) : 4;
+    int taskMillisec = (argc > 4) ? atoi(argv[4]) : 20;
+    if (clientNum >= MAX_COMM_USER_NUMBER)
+    {
+        std::cerr << "clients exceed MAX_COMM_USER_NUMBER" << std::endl;
+        return 1;
+    }
+
+    char home[] = "/tmp/bench_page_engine_XXXXXX";
+    if (mkdtemp(home) == nullptr)
+        return 1;
+    setenv("KF_HOME", home, 1);
+    boost::filesystem::create_directories(KUNGFU_SOCKET_FOLDER);
+    boost::filesystem::create_directories(KUNGFU_LOG_FOLDER);
+    std::cout << "(clients) " << clientNum << " (pages per client) " << pageNum << " (threads) " << threadNum
+              << " (task ms) " << taskMillisec << std::endl;
+
+    pybind11::scoped_interpreter python; // engine status is a python dict
+    {
+        pybind11::gil_scoped_release nogil;
+        boost::shared_ptr<PstBenchSlow> slow(new PstBenchSlow(taskMillisec));
+        PageEngine engine(home);
+        engine.set_freq(0.1);
+        engine.set_page_pool(JOURNAL_PAGE_SIZE, 0, false);
+        engine.set_page_pool(BENCH_PAGE_SIZE, 0, false);
+        engine.add_task(slow);
+        engine.start();
+
+        string dir = string(home) + "/journal/bench";
+        vector<BenchClient> clients(clientNum);
+        int64_t start = now_nano();
+        for (int c = 0; c < clientNum; c++)
+        {
+            BenchClient& client = clients[c];
+            client.name = "bench_" + std::to_string(c);
+            client.provider = new ClientPageProvider(client.name, true);
+            client.idx = client.provider->register_journal(dir, client.name);
+        }
+        std::cout << "[register] (ms) " << (now_nano() - start) / 1e6 << std::endl;
+
+        std::atomic<bool> polling(true);
+        std::atomic<int> polls(0);
+        std::thread poller([&]()
+        {
+            while (polling)
+            {
+                {
+                    pybind11::gil_scoped_acquire gil;
+                    engine.getStatus();
+                }
+                polls++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+
+        vector<vector<int64_t>> latencies(threadNum);
+        std::atomic<int> failed(0);
+        vector<std::thread> threads;
+        start = now_nano();
+        for (int t = 0; t < threadNum; t++)
+        {
+            threads.emplace_back([&, t]()
+            {
+                for (int p = 1; p <= pageNum; p++)
+                {
+                    for (int c = t; c < clientNum; c += threadNum)
+                    {
+                        BenchClient& client = clients[c];
+                        int64_t requested = now_nano();
+                        client.page = client.provider->getPage(dir, client.name, client.idx, p, BENCH_PAGE_SIZE);
+                        latencies[t].push_back(now_nano() - requested);
+                        failed += client.page.get() == nullptr;
+                    }
+                }
+            });
+        }
+        for (auto& thread: threads)
+            thread.join();
+        int64_t rollNano = now_nano() - start;
+        polling = false;
+        poller.join();
+
+        vector<int64_t> all;
+        for (auto const& l: latencies)
+            all.insert(all.end(), l.begin(), l.end());
+        std::sort(all.begin(), all.end());
+        std::cout << "[page request] (count) " << all.size() << " (total ms) " << rollNano / 1e6
+                  << " (p50 us) " << all[all.size() / 2] / 1e3
+                  << " (p99 us) " << all[all.size() * 99 / 100] / 1e3
+                  << " (max us) " << all.back() / 1e3
+                  << " (failed) " << failed << std::endl;
+        std::cout << "(task runs) " << slow->runs << " (status polls) " << polls << std::endl;
+
+        start = now_nano();
+        for (auto& client: clients)
+        {
+            client.page.reset();
+            client.provider->exit_client();
+            delete client.provider;
+        }
+        std::cout << "[exit] (ms) " << (now_nano() - start) / 1e6 << std::endl;
+
+        size_t locking;
+        {
+            pybind11::gil_scoped_acquire gil;
+            pybind11::dict status = engine.getStatus();
+            locking = pybind11::len(status["File"]["Locking"]) + pybind11::len(status["Client"]);
+        }
+        // the system journal keeps its page
+        bool ok = failed == 0 && locking <= 2;
+        std::cout << "(pages and clients left) " << locking << std::endl;
+        engine.stop();
+        boost::filesystem::remove_all(home);
+        std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+        std::cout.flush();
+        _exit(ok ? 0 : 1); // PageEngine finalizes python in its destructor
+    }
+}
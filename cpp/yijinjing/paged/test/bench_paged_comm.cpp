@@ -0,0 +1,135 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Comm buffer handshake benchmark.
+ * a forked process plays paged comm thread (answers instantly), the parent plays a client,
+ * requests are spaced by an idle gap as page rolls are in real life.
+ * report page request round trip and cpu usage of both sides for each wait mode.
+ * usage: bench_paged_comm [request_num] [gap_microsec]
+ */
+
+#include "PageCommStruct.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+USING_YJJ_NAMESPACE
+
+/** slots scanned by server, as if that many journals registered */
+#define BENCH_COMM_USERS 64
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline double cpu_seconds(const struct rusage& usage)
+{
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/** same loop as PageEngine::start_comm, without page allocation */
+void run_server(void* buffer, volatile int* running, PagedWaitMode mode)
+{
+    PageCommDoorbell* bell = GET_COMM_DOORBELL(buffer);
+    while (*running)
+    {
+        int seq = __atomic_load_n(&bell->request_seq, __ATOMIC_ACQUIRE);
+        bool handled = false;
+        for (size_t idx = 0; idx < BENCH_COMM_USERS; idx++)
+        {
+            PageCommMsg* msg = GET_COMM_MSG(buffer, idx);
+            if (msg->status == PAGED_COMM_REQUESTING)
+            {
+                msg->status = PAGED_COMM_ALLOCATED;
+                msg->last_page_num = msg->page_num;
+                comm_notify_reply(bell, idx);
+                handled = true;
+            }
+        }
+        if (!handled)
+            comm_wait_request(bell, seq, mode);
+    }
+}
+
+void bench(const string& name, PagedWaitMode mode, int request_num, int gap_micro)
+{
+    void* buffer = mmap(nullptr, COMM_SIZE + sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    memset(buffer, 0, COMM_SIZE + sizeof(int));
+    volatile int* running = (volatile int*)ADDRESS_ADD(buffer, COMM_SIZE);
+    *running = 1;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        run_server(buffer, running, mode);
+        _exit(0);
+    }
+
+    size_t idx = BENCH_COMM_USERS - 1;
+    PageCommMsg* msg = GET_COMM_MSG(buffer, idx);
+    PageCommDoorbell* bell = GET_COMM_DOORBELL(buffer);
+    std::vector<int64_t> latencies;
+    struct rusage self_start, self_end, child;
+    getrusage(RUSAGE_SELF, &self_start);
+    int64_t start = now_nano();
+    for (int i = 0; i < request_num; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(gap_micro));
+        int64_t before = now_nano();
+        int reply = __atomic_load_n(&bell->reply_seq[idx], __ATOMIC_ACQUIRE);
+        msg->page_num = i;
+        msg->status = PAGED_COMM_REQUESTING;
+        comm_notify_request(bell);
+        comm_wait_reply(msg, bell, idx, reply, mode);
+        latencies.push_back(now_nano() - before);
+    }
+    double wall = (now_nano() - start) / 1e9;
+    getrusage(RUSAGE_SELF, &self_end);
+
+    *running = 0;
+    comm_notify_request(bell);
+    waitpid(pid, nullptr, 0);
+    getrusage(RUSAGE_CHILDREN, &child);
+    static double child_before = 0;
+    double server_cpu = cpu_seconds(child) - child_before;
+    child_before = cpu_seconds(child);
+    munmap(buffer, COMM_SIZE + sizeof(int));
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name
+              << " (p50 ns) " << latencies[latencies.size() / 2]
+              << " (p99 ns) " << latencies[latencies.size() * 99 / 100]
+              << " (server cpu %) " << (int)(server_cpu / wall * 100)
+              << " (client cpu %) " << (int)((cpu_seconds(self_end) - cpu_seconds(self_start)) / wall * 100)
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int request_num = (argc > 1) ? atoi(argv[1]) : 2000;
+    int gap_micro = (argc > 2) ? atoi(argv[2]) : 1000;
+    std::cout << "(requests) " << request_num << " (gap us) " << gap_micro << std::endl;
+    bench("[spin     ]", PAGED_WAIT_SPIN, request_num, gap_micro);
+    bench("[park     ]", PAGED_WAIT_PARK, request_num, gap_micro);
+    bench("[spin_park]", PAGED_WAIT_SPIN_PARK, request_num, gap_micro);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/*****************************************************************************
+ * Copyright [2017] [taurus.ai]
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/**
+ * Paged socket startup storm benchmark.
+ * PageSocketHandler runs in this process on a bookkeeping-only util, under a temporary KF_HOME.
+ * threads start clients as fast as they can: register client, register journals, exit,
+ * once with a connection per request and journals one by one as before,
+ * once with the persistent connection and batched journal registration of ClientPageProvider.
+ * a connected client that never sends anything is kept open during the storm,
+ * then paged is restarted and a client registers again over the broken connection.
+ * usage: bench_paged_socket [client_num] [journal_num] [thread_num]
+ */
+
+#include "PageSocketHandler.h"
+#include "PageProvider.h"
+#include "PageCommStruct.h"
+#include "PageUtil.h"
+
+#include <boost/asio.hpp>
+#include <boost/array.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+USING_YJJ_NAMESPACE
+
+typedef boost::array<char, SOCKET_MESSAGE_MAX_LENGTH> SocketMArray;
+
+inline int64_t now_nano()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** client and journal bookkeeping of PageEngine, no page service */
+class BenchSocketUtil: public IPageSocketUtil
+{
+public:
+    string comm_file;
+    void* comm_buffer;
+    map<string, vector<int> > clients;
+    mutable std::mutex mtx;
+
+    BenchSocketUtil(const string& commFile): comm_file(commFile)
+    {
+        comm_buffer = PageUtil::LoadPageBuffer(comm_file, COMM_SIZE, true, true);
+        memset(comm_buffer, 0, COMM_SIZE);
+    }
+
+    int reg_journal(const string& clientName)
+    {
+        auto it = clients.find(clientName);
+        if (it == clients.end())
+            return -1;
+        for (int idx = 0; idx < MAX_COMM_USER_NUMBER; idx++)
+        {
+            PageCommMsg* msg = GET_COMM_MSG(comm_buffer, idx);
+            if (msg->status == PAGED_COMM_RAW)
+            {
+                msg->status = PAGED_COMM_OCCUPIED;
+                it->second.push_back(idx);
+                return idx;
+            }
+        }
+        return -1;
+    }
+    void unreg_journal(const string& clientName, int idx)
+    {
+        auto it = clients.find(clientName);
+        if (it == clients.end())
+            return;
+        it->second.erase(std::remove(it->second.begin(), it->second.end(), idx), it->second.end());
+        GET_COMM_MSG(comm_buffer, idx)->status = PAGED_COMM_RAW;
+    }
+    IntPair register_strategy(const string& strategyName) { return IntPair(-1, -1); }
+    bool reg_client(string& commFile, int& fileSize, int& hashCode, const string& clientName, int pid, bool isWriter)
+    {
+        if (clients.find(clientName) != clients.end())
+            return false;
+        clients[clientName];
+        commFile = comm_file;
+        fileSize = COMM_SIZE;
+        hashCode = 0;
+        return true;
+    }
+    void exit_client(const string& clientName, int hashCode, bool needHashCheck)
+    {
+        auto it = clients.find(clientName);
+        if (it == clients.end())
+            return;
+        for (int idx: it->second)
+            GET_COMM_MSG(comm_buffer, idx)->status = PAGED_COMM_RAW;
+        clients.erase(it);
+    }
+    bool sub_md(const vector<string>& tickers, short source, short msgType, bool isLast) { return true; }
+    bool login_td(const string& clientName, short source) { return true; }
+    void acquire_mutex() const { mtx.lock(); }
+    void release_mutex() const { mtx.unlock(); }
+};
+
+/** getSocketRsp before the persistent connection */
+void legacyRequest(SocketMArray& input, SocketMArray& output)
+{
+    using namespace boost::asio;
+    io_service io_service;
+    local::stream_protocol::socket socket(io_service);
+    socket.connect(local::stream_protocol::endpoint(PAGED_SOCKET_FILE));
+    boost::system::error_code error;
+    write(socket, buffer(input), error);
+    socket.read_some(buffer(output), error);
+}
+
+bool legacyRequest(PagedSocketRequest& req, SocketMArray& output, const string& name)
+{
+    memcpy(req.name, name.c_str(), name.length() + 1);
+    SocketMArray input;
+    memcpy(&input[0], &req, sizeof(req));
+    legacyRequest(input, output);
+    PagedSocketResponse* rsp = (PagedSocketResponse*)&output[0];
+    return rsp->type == req.type && rsp->success;
+}
+
+/** register client, journals one by one and exit, as ClientPageProvider did */
+bool legacyStartup(const string& name, const vector<string>& dirs, const vector<string>& jnames)
+{
+    SocketMArray output;
+    PagedSocketRequest req = {};
+    req.type = PAGED_SOCKET_READER_REGISTER;
+    req.pid = getpid();
+    if (!legacyRequest(req, output, name))
+        return false;
+    PagedSocketRspClient* client = (PagedSocketRspClient*)&output[0];
+    void* comm_buffer = PageUtil::LoadPageBuffer(string(client->comm_file), client->file_size, true, false);
+    bool ok = comm_buffer != nullptr;
+    for (size_t i = 0; ok && i < jnames.size(); i++)
+    {
+        req = {};
+        req.type = PAGED_SOCKET_JOURNAL_REGISTER;
+        ok = legacyRequest(req, output, name);
+        PageCommMsg* msg = GET_COMM_MSG(comm_buffer, ((PagedSocketRspJournal*)&output[0])->comm_idx);
+        memcpy(msg->folder, dirs[i].c_str(), dirs[i].length() + 1);
+        memcpy(msg->name, jnames[i].c_str(), jnames[i].length() + 1);
+        msg->status = PAGED_COMM_HOLDING;
+    }
+    req = {};
+    req.type = PAGED_SOCKET_CLIENT_EXIT;
+    legacyRequest(req, output, name);
+    PageUtil::ReleasePageBuffer(comm_buffer, COMM_SIZE, true);
+    return ok;
+}
+
+/** register client, journals in batch and exit over the persistent connection */
+bool batchStartup(const string& name, const vector<string>& dirs, const vector<string>& jnames)
+{
+    try
+    {
+        ClientPageProvider provider(name, false);
+        bool ok = provider.register_journals(dirs, jnames).size() == jnames.size();
+        provider.exit_client();
+        return ok;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+template <typename F>
+bool storm(const char* label, int clientNum, int threadNum, const vector<string>& dirs, const vector<string>& jnames, F startup)
+{
+    std::atomic<int> next(0);
+    std::atomic<int> failed(0);
+    vector<std::thread> threads;
+    int64_t start = now_nano();
+    for (int t = 0; t < threadNum; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            for (int c = next++; c < clientNum; c = next++)
+                failed += !startup(string(label) + "_" + std::to_string(c), dirs, jnames);
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+    int64_t ns = now_nano() - start;
+    std::cout << "[" << label << "] (total ms) " << ns / 1e6 << " (us per client) " << ns / 1e3 / clientNum
+              << " (failed) " << failed << std::endl;
+    return failed == 0;
+}
+
+void startPaged(IPageSocketUtil* util, std::thread& thread)
+{
+    remove(string(PAGED_SOCKET_FILE).c_str());
+    thread = std::thread([util]() { PageSocketHandler::getInstance()->run(util); });
+    while (!PageSocketHandler::getInstance()->is_running())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void stopPaged(std::thread& thread)
+{
+    PageSocketHandler::getInstance()->stop();
+    thread.join();
+}
+
+int main(int argc, char** argv)
+{
+    int clientNum = (argc > 1) ? atoi(argv[1]) : 200;
+    int journalNum = (argc > 2) ? atoi(argv[2]) : 16;
+    int threadNum = (argc > 3) ? atoi(argv[3]) : 8;
+    if (journalNum * threadNum > MAX_COMM_USER_NUMBER)
+    {
+        std::cerr << "journals of concurrent clients exceed MAX_COMM_USER_NUMBER" << std::endl;
+        return 1;
+    }
+
+    char home[] = "/tmp/bench_paged_socket_XXXXXX";
+    if (mkdtemp(home) == nullptr)
+        return 1;
+    setenv("KF_HOME", home, 1);
+    boost::filesystem::create_directories(KUNGFU_SOCKET_FOLDER);
+    std::cout << "(clients) " << clientNum << " (journals per client) " << journalNum << " (threads) " << threadNum << std::endl;
+
+    vector<string> dirs(journalNum, string(home) + "/journal");
+    vector<string> jnames;
+    for (int i = 0; i < journalNum; i++)
+        jnames.push_back("bench_" + std::to_string(i));
+
+    BenchSocketUtil util(string(home) + "/comm");
+    std::thread paged;
+    startPaged(&util, paged);
+
+    // a client which connects and says nothing, used to hold paged's only socket thread
+    boost::asio::io_service io;
+    boost::asio::local::stream_protocol::socket idle(io);
+    idle.connect(boost::asio::local::stream_protocol::endpoint(PAGED_SOCKET_FILE));
+
+    bool ok = storm("legacy", clientNum, threadNum, dirs, jnames, legacyStartup);
+    ok = storm("batch", clientNum, threadNum, dirs, jnames, batchStartup) && ok;
+    ok = ok && util.clients.empty();
+
+    // paged restarts, the persistent connection is broken
+    stopPaged(paged);
+    startPaged(&util, paged);
+    int64_t start = now_nano();
+    bool reconnected = batchStartup("reconnect", dirs, jnames);
+    std::cout << "[reconnect] (us) " << (now_nano() - start) / 1e3 << " (ok) " << reconnected << std::endl;
+    ok = ok && reconnected;
+
+    // a batch which does not fit gives back the indexes it got
+    int freeNum = journalNum - 1;
+    {
+        std::lock_guard<std::mutex> lock(util.mtx);
+        for (int idx = freeNum; idx < MAX_COMM_USER_NUMBER; idx++)
+            GET_COMM_MSG(util.comm_buffer, idx)->status = PAGED_COMM_OCCUPIED;
+    }
+    bool rejected = !batchStartup("overflow", dirs, jnames);
+    int rawNum = 0;
+    {
+        std::lock_guard<std::mutex> lock(util.mtx);
+        for (int idx = 0; idx < MAX_COMM_USER_NUMBER; idx++)
+        {
+            PageCommMsg* msg = GET_COMM_MSG(util.comm_buffer, idx);
+            rawNum += msg->status == PAGED_COMM_RAW;
+            msg->status = PAGED_COMM_RAW;
+        }
+    }
+    std::cout << "[overflow] (rejected) " << rejected << " (free after) " << rawNum << "/" << freeNum << std::endl;
+    ok = ok && rejected && rawNum == freeNum;
+
+    idle.close();
+    stopPaged(paged);
+    boost::filesystem::remove_all(home);
+    std::cout << "(check) " << (ok ? "ok" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -117,7 +117,7 @@ PYBIND11_MODULE(pyyjj, m)
     .def("expireJ", &JournalReader::expireJournalByName, py::arg("jname"))
     .def("restartJ", &JournalReader::seekTimeJournalByName, py::arg("jname"), py::arg("nano"))
     .def("seekJ", &JournalReader::seekTimeJournal, py::arg("idx"), py::arg("nano"))
-    .def("next", &JournalReader::getNextFrame)
+    .def("next", (FramePtr (JournalReader::*)()) &JournalReader::getNextFrame)
     .def("name", &JournalReader::getFrameName);
 
     // JournalWriter
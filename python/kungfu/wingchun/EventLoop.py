@@ -1,6 +1,7 @@
 
 from kungfu.wingchun.TaskScheduler import TaskScheduler
 from kungfu.wingchun.constants import MsgType
+from kungfu.wingchun.structs import AlgoOrderInput, get_algo_msg_var
 import nnpy, json, pyyjj
 import sys
 import signal
@@ -27,7 +28,8 @@ class EventLoop:
 
     def subscribe_nanomsg(self, url):
         socket = nnpy.Socket(nnpy.AF_SP, nnpy.SUB)
-        socket.setsockopt(nnpy.SUB, nnpy.SUB_SUBSCRIBE, '')
+        # json messages only, binary ones start with b'KFB'
+        socket.setsockopt(nnpy.SUB, nnpy.SUB_SUBSCRIBE, '{')
         socket.connect(url)
         self._sockets.append(socket)
 
@@ -154,11 +156,8 @@ class EventLoop:
                 self._trade_cb(frame.get_data())
         elif msg_type == MsgType.AlgoOrderInput:
             if self._algo_input_cb is not None:
-                try:
-                    j = json.loads(frame.get_data())
-                    self._algo_input_cb(j['order_id'], j['algo_type'], j['client_id'], j['algo_order_input'])
-                except Exception as e:
-                    print(e)
+                msg = AlgoOrderInput.from_address(frame.get_data())
+                self._algo_input_cb(msg.order_id, msg.algo_type.decode(), msg.client_id.decode(), get_algo_msg_var(msg))
         else:
             pass
 
@@ -90,6 +90,7 @@ class MsgType:
 
     AlgoOrderInput = 501
     AlgoOrderUpdate = 502
+    AlgoOrderAction = 503
 
     SwitchDay = 601
     RspTradingDay = 602
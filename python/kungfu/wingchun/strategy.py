@@ -11,6 +11,9 @@ from kungfu.wingchun.context import context
 import pystrategy
 import pyyjj
 
+# same as PNL_SAVE_INTERVAL_NANO in portfolio/include/pnl_def.h
+PNL_SAVE_INTERVAL_NANO = 500000000
+
 class Strategy:
     def __init__(self, name, path):
         self._base_dir = os.environ['KF_HOME']
@@ -105,6 +108,7 @@ class Strategy:
 
         self._event_loop.register_nanotime_callback(self.__nseconds_next_min(pyyjj.nano()), self.__on_1min_timer)
         self._event_loop.register_nanotime_callback_at_next('15:30:00', self.__on_1day_timer)
+        self._event_loop.register_nanotime_callback(pyyjj.nano() + PNL_SAVE_INTERVAL_NANO, self.__on_pnl_save_timer)
 
         self._event_loop.register_quote_callback(self.__process_quote)
         self._event_loop.register_entrust_callback(self.__process_entrust)
@@ -116,6 +120,7 @@ class Strategy:
 
         self._pre_run(context)
         self._event_loop.run()
+        self._util.flush_pnl()
 
     def stop(self):
         self._event_loop.stop()
@@ -152,6 +157,10 @@ class Strategy:
         self._util.on_push_by_day()
         self._event_loop.register_nanotime_callback_at_next('15:30:00', self.__on_1day_timer)
 
+    def __on_pnl_save_timer(self, nano):
+        self._util.on_pnl_save_timer(nano)
+        self._event_loop.register_nanotime_callback(nano + PNL_SAVE_INTERVAL_NANO, self.__on_pnl_save_timer)
+
     def __get_md_journal_folder(self, source):
         return self._base_dir + '/journal/md/' + source
 
@@ -153,3 +153,29 @@ class Trade(ctypes.Structure):
         ('tax', ctypes.c_double),
         ('commission', ctypes.c_double),
     ]
+
+# algo order messages are followed by var_length bytes of '\0' terminated parameters
+class AlgoOrderInput(ctypes.Structure):
+    _fields_ = [
+        ('order_id', ctypes.c_uint64),
+        ('client_id', ctypes.c_char * 32),
+        ('algo_type', ctypes.c_char * 32),
+        ('var_length', ctypes.c_uint32)
+    ]
+
+class AlgoOrderAction(ctypes.Structure):
+    _fields_ = [
+        ('order_id', ctypes.c_uint64),
+        ('order_action_id', ctypes.c_uint64),
+        ('var_length', ctypes.c_uint32)
+    ]
+
+class AlgoOrderStatus(ctypes.Structure):
+    _fields_ = [
+        ('order_id', ctypes.c_uint64),
+        ('algo_type', ctypes.c_char * 32),
+        ('var_length', ctypes.c_uint32)
+    ]
+
+def get_algo_msg_var(msg):
+    return ctypes.string_at(ctypes.addressof(msg) + ctypes.sizeof(msg)).decode()